@@ -0,0 +1,30 @@
+#ifndef __BENCH_ALLOC_H__
+#define __BENCH_ALLOC_H__
+
+#include <stddef.h>
+#include <stdlib.h>
+
+/**
+ * Counts the allocations made by the code the benchmarks measure.
+ * The benchmark build force-includes this header in every file it compiles
+ * (clang -include, cl -FI), so every malloc, calloc and realloc there
+ * is counted, with or without a sanitizer.
+ * bench_util.c defines the counters in terms of the real allocator.
+ */
+
+void *bench_malloc(size_t size);
+void *bench_calloc(size_t count, size_t size);
+void *bench_realloc(void *ptr, size_t size);
+
+/**
+ * Gets the number of allocations made so far.
+ *
+ * @return the number of calls to malloc, calloc and realloc
+ */
+size_t bench_alloc_count(void);
+
+#define malloc(size) bench_malloc(size)
+#define calloc(count, size) bench_calloc(count, size)
+#define realloc(ptr, size) bench_realloc(ptr, size)
+
+#endif // #ifndef __BENCH_ALLOC_H__
@@ -0,0 +1,107 @@
+#include <math.h>
+#include <stdlib.h>
+#include "bench_util.h"
+#include "body.h"
+#include "forces.h"
+#include "rand_utils.h"
+#include "scene.h"
+#include "shape.h"
+
+// A breakout grid like demo/breakout.c, with a configurable number of bricks.
+// Several balls are in play; any that get past the paddle line are served again.
+const double WINDOW_WIDTH = 1000.0;
+const size_t BRICK_COLUMNS = 20;
+const double BRICK_HEIGHT = 20.0;
+const double BRICK_GAP = 5.0;
+const double WALL_WIDTH = 10.0;
+const double BALL_RADIUS = 7.0;
+const size_t BALL_POINTS = 30;
+const double BALL_MASS = 1.0;
+const double BALL_SPEED = 400.0;
+const double ELASTICITY = 1.0;
+const double FIELD_HEIGHT = 400.0;
+// One ball for every this many bricks
+const size_t BRICKS_PER_BALL = 50;
+
+const size_t DEFAULT_BODIES = 1000;
+const size_t DEFAULT_TICKS = 500;
+const double DT = 0.002;
+
+typedef struct game {
+    body_t **balls;
+    size_t ball_count;
+} game_t;
+
+/** Bounces the ball off the brick and breaks the brick */
+static void hit_brick(body_t *ball, body_t *brick, vector_t axis, void *aux) {
+    vector_t velocity = body_get_velocity(ball);
+    body_set_velocity(ball, vec_subtract(velocity, vec_multiply(2 * vec_dot(velocity, axis), axis)));
+    body_remove(brick);
+}
+
+static void serve(body_t *ball) {
+    body_set_centroid(ball, (vector_t) {rand_range(BALL_RADIUS, WINDOW_WIDTH - BALL_RADIUS), BALL_RADIUS});
+    double angle = rand_range(M_PI / 6, 5 * M_PI / 6);
+    body_set_velocity(ball, vec_multiply(BALL_SPEED, (vector_t) {cos(angle), sin(angle)}));
+}
+
+static void step(scene_t *scene, game_t *game) {
+    for (size_t i = 0; i < game->ball_count; i++) {
+        if (body_get_centroid(game->balls[i]).y < 0) {
+            serve(game->balls[i]);
+        }
+    }
+}
+
+static body_t *add_wall(scene_t *scene, double width, double height, vector_t center) {
+    body_t *wall = body_init(make_shape_rectangle(width, height, center), INFINITY, (rgb_color_t) {0, 0, 0});
+    scene_add_body(scene, wall);
+    return wall;
+}
+
+int main(int argc, char *argv[]) {
+    size_t bricks = DEFAULT_BODIES;
+    size_t ticks = DEFAULT_TICKS;
+    bench_parse_args(argc, argv, &bricks, &ticks);
+    srand(0);
+
+    size_t rows = (bricks + BRICK_COLUMNS - 1) / BRICK_COLUMNS;
+    double brick_width = WINDOW_WIDTH / BRICK_COLUMNS - BRICK_GAP;
+    double top = FIELD_HEIGHT + rows * (BRICK_HEIGHT + BRICK_GAP);
+
+    game_t game = {.ball_count = bricks / BRICKS_PER_BALL > 0 ? bricks / BRICKS_PER_BALL : 1};
+    game.balls = malloc(game.ball_count * sizeof(body_t *));
+
+    scene_t *scene = scene_init();
+    body_t *walls[3] = {
+        add_wall(scene, WALL_WIDTH, top, (vector_t) {-WALL_WIDTH / 2, top / 2}),
+        add_wall(scene, WALL_WIDTH, top, (vector_t) {WINDOW_WIDTH + WALL_WIDTH / 2, top / 2}),
+        add_wall(scene, WINDOW_WIDTH, WALL_WIDTH, (vector_t) {WINDOW_WIDTH / 2, top + WALL_WIDTH / 2})
+    };
+    for (size_t i = 0; i < game.ball_count; i++) {
+        body_t *ball = body_init(make_shape_circle(BALL_RADIUS, VEC_ZERO, BALL_POINTS),
+            BALL_MASS, (rgb_color_t) {1, 0, 0});
+        serve(ball);
+        scene_add_body(scene, ball);
+        for (size_t j = 0; j < 3; j++) {
+            create_physics_collision(scene, ELASTICITY, ball, walls[j]);
+        }
+        game.balls[i] = ball;
+    }
+    for (size_t i = 0; i < bricks; i++) {
+        vector_t center = {
+            (i % BRICK_COLUMNS + 0.5) * (brick_width + BRICK_GAP),
+            FIELD_HEIGHT + (i / BRICK_COLUMNS + 0.5) * (BRICK_HEIGHT + BRICK_GAP)
+        };
+        body_t *brick = body_init(make_shape_rectangle(brick_width, BRICK_HEIGHT, center),
+            INFINITY, (rgb_color_t) {0, 0, 1});
+        scene_add_body(scene, brick);
+        for (size_t j = 0; j < game.ball_count; j++) {
+            create_collision(scene, game.balls[j], brick, hit_brick, NULL, NULL);
+        }
+    }
+
+    bench_run("breakout", scene, ticks, DT, (bench_step_t) step, &game);
+    free(game.balls);
+    return 0;
+}
@@ -0,0 +1,53 @@
+#include <math.h>
+#include <stdlib.h>
+#include "bench_util.h"
+#include "body.h"
+#include "scene.h"
+#include "shape.h"
+#include "spring_field.h"
+
+// Same setup as demo/damping.c, with a configurable number of balls
+const vector_t WINDOW_MAX = {1000.0, 500.0};
+const vector_t CENTER = {500.0, 250.0};
+const double CIRC_RAD = 10.0;
+const size_t CIRC_POINTS = 100;
+const double CIRC_MASS = 0.5;
+const double SPRING_K = 40;
+const double DRAG = 0.5;
+
+const size_t DEFAULT_BODIES = 1000;
+const size_t DEFAULT_TICKS = 500;
+const size_t DEFAULT_THREADS = 1;
+const double DT = 0.001;
+
+int main(int argc, char *argv[]) {
+    size_t bodies = DEFAULT_BODIES;
+    size_t ticks = DEFAULT_TICKS;
+    bench_parse_args(argc, argv, &bodies, &ticks);
+    // An optional third argument sets the spring field's thread count
+    size_t threads = argc > 3 ? strtoul(argv[3], NULL, 10) : DEFAULT_THREADS;
+
+    // Each ball hangs from a fixed anchor, so count the pairs
+    size_t balls = bodies / 2 > 0 ? bodies / 2 : 1;
+    double spacing = WINDOW_MAX.x / balls;
+    double curve = WINDOW_MAX.y / (2 * pow(CENTER.x, 2));
+
+    scene_t *scene = scene_init();
+    spring_field_t *springs = create_spring_field(scene);
+    spring_field_set_threads(springs, threads);
+    for (size_t i = 0; i < balls; i++) {
+        double x = spacing * (i + 0.5);
+        body_t *anchor = body_init(make_shape_circle(1, CENTER, CIRC_POINTS), INFINITY, (rgb_color_t) {1, 1, 1});
+        body_set_centroid(anchor, (vector_t) {x, CENTER.y});
+        body_t *ball = body_init(make_shape_circle(CIRC_RAD, CENTER, CIRC_POINTS), CIRC_MASS, (rgb_color_t) {0, 0, 0});
+        body_set_centroid(ball, (vector_t) {x, curve * pow(x - CENTER.x, 2) + CENTER.y});
+        scene_add_body(scene, anchor);
+        scene_add_body(scene, ball);
+
+        spring_field_add_spring(springs, SPRING_K, ball, anchor);
+        spring_field_add_drag(springs, DRAG, ball);
+    }
+
+    bench_run("damping", scene, ticks, DT, NULL, NULL);
+    return 0;
+}
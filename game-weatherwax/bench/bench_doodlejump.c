@@ -0,0 +1,199 @@
+#include <math.h>
+#include <stdlib.h>
+#include "bench_util.h"
+#include "body.h"
+#include "body_pool.h"
+#include "broad_phase.h"
+#include "camera.h"
+#include "level_stream.h"
+#include "scene.h"
+#include "shape.h"
+
+// Endless upward scrolling set up like demo/doodlejump.c: a level stream lays
+// out the platforms and monsters ahead of the camera on its own thread,
+// collisions come from broad-phase rules, and shots come from a body pool.
+// The world is split into side-by-side lanes, each with its own jumper,
+// so the number of platforms on screen scales with the requested body count.
+// Scrolling moves a camera, not the bodies.
+const double LANE_WIDTH = 500.0;
+const double SCREEN_HEIGHT = 1000.0;
+const double SCROLL_LINE = 500.0;
+const double PLATFORM_WIDTH = 80.0;
+const double PLATFORM_HEIGHT = 10.0;
+const double PLATFORM_GAP = 125.0;
+const double SPRITE_RADIUS = 30.0;
+const size_t SPRITE_POINTS = 40;
+const double SPRITE_MASS = 20.0;
+const double BOUNCE_SPEED = 1100.0;
+const double GRAVITY = 2000.0;
+const double MONSTER_RADIUS = 25.0;
+const size_t MONSTER_POINTS = 20;
+// Chance of a monster in each lane of a chunk
+const double MONSTER_CHANCE = 0.5;
+const double SHOT_RADIUS = 5.0;
+const size_t SHOT_POINTS = 20;
+const double SHOT_MASS = 1.0;
+const vector_t SHOT_VELOCITY = {0.0, 800.0};
+// Every jumper shoots once every this many ticks
+const size_t SHOT_INTERVAL = 500;
+const double CELL_SIZE = 100.0;
+// One jumper for every this many platforms on screen
+const size_t PLATFORMS_PER_LANE = 8;
+const uint32_t SPRITE_CATEGORY = 1 << 0;
+const uint32_t PLATFORM_CATEGORY = 1 << 1;
+const uint32_t SHOT_CATEGORY = 1 << 2;
+const uint32_t MONSTER_CATEGORY = 1 << 3;
+
+const size_t DEFAULT_BODIES = 1000;
+const size_t DEFAULT_TICKS = 2000;
+const double DT = 0.002;
+const uint64_t SEED = 0;
+
+// Kinds of bodies a level chunk spawns
+typedef enum {
+    PLATFORM_SPAWN,
+    MONSTER_SPAWN
+} spawn_kind_t;
+
+typedef struct world {
+    body_t **sprites;
+    // set before the level stream starts and read by its thread, so never changed after
+    size_t lane_count;
+    camera_t *camera;
+    broad_phase_t *broad_phase;
+    body_pool_t *shots;
+    level_stream_t *level;
+    size_t tick;
+} world_t;
+
+/** Bounces the sprite up when it lands on a platform */
+static void land(body_t *sprite, body_t *platform, vector_t axis, void *aux) {
+    vector_t velocity = body_get_velocity(sprite);
+    if (velocity.y < 0) {
+        body_set_velocity(sprite, (vector_t) {velocity.x, BOUNCE_SPEED});
+    }
+}
+
+/** A shot destroys the monster it hits and goes back to the pool */
+static void shoot_monster(body_t *shot, body_t *monster, vector_t axis, void *aux) {
+    world_t *world = aux;
+    body_remove(monster);
+    body_pool_release(world->shots, shot);
+}
+
+static body_t *make_shot(body_pool_t *pool, void *aux) {
+    world_t *world = aux;
+    body_t *shot = body_init(make_shape_circle(SHOT_RADIUS, VEC_ZERO, SHOT_POINTS),
+        SHOT_MASS, (rgb_color_t) {0, 1, 0});
+    scene_add_body(body_pool_get_scene(pool), shot);
+    broad_phase_set_bullet(world->broad_phase, shot, true);
+    broad_phase_set_category(world->broad_phase, shot, SHOT_CATEGORY, ALL_CATEGORIES);
+    return shot;
+}
+
+/** Lays out a screen's height of platforms, and maybe a monster, in every lane */
+static double generate_chunk(level_chunk_t *chunk, double bottom, void *aux) {
+    world_t *world = aux;
+    double top = bottom + SCREEN_HEIGHT;
+    for (size_t i = 0; i < world->lane_count; i++) {
+        double left = i * LANE_WIDTH;
+        for (double y = bottom + PLATFORM_GAP; y <= top; y += PLATFORM_GAP) {
+            double x = left + level_chunk_rand(chunk, PLATFORM_WIDTH / 2, LANE_WIDTH - PLATFORM_WIDTH / 2);
+            level_chunk_add(chunk, (spawn_t) {PLATFORM_SPAWN, {x, y}, VEC_ZERO});
+        }
+        if (level_chunk_rand(chunk, 0, 1) < MONSTER_CHANCE) {
+            vector_t position = {
+                left + level_chunk_rand(chunk, MONSTER_RADIUS, LANE_WIDTH - MONSTER_RADIUS),
+                level_chunk_rand(chunk, bottom, top)
+            };
+            level_chunk_add(chunk, (spawn_t) {MONSTER_SPAWN, position, VEC_ZERO});
+        }
+    }
+    return top;
+}
+
+static body_t *spawn_body(scene_t *scene, spawn_t spawn, void *aux) {
+    world_t *world = aux;
+    body_t *body;
+    uint32_t category;
+    if (spawn.kind == MONSTER_SPAWN) {
+        body = body_init(make_shape_circle(MONSTER_RADIUS, spawn.position, MONSTER_POINTS),
+            INFINITY, (rgb_color_t) {1, 0, 0});
+        category = MONSTER_CATEGORY;
+    }
+    else {
+        body = body_init(make_shape_rectangle(PLATFORM_WIDTH, PLATFORM_HEIGHT, spawn.position),
+            INFINITY, (rgb_color_t) {0, 0, 1});
+        category = PLATFORM_CATEGORY;
+    }
+    scene_add_body(scene, body);
+    broad_phase_set_category(world->broad_phase, body, category, ALL_CATEGORIES);
+    return body;
+}
+
+static void step(scene_t *scene, world_t *world) {
+    double bottom = camera_get_position(world->camera).y;
+    bool shoot = world->tick++ % SHOT_INTERVAL == 0;
+    double highest = -INFINITY;
+    for (size_t i = 0; i < world->lane_count; i++) {
+        body_t *sprite = world->sprites[i];
+        vector_t centroid = body_get_centroid(sprite);
+        if (centroid.y < bottom) {
+            centroid.y = bottom + SCROLL_LINE;
+            body_set_centroid(sprite, centroid);
+            body_set_velocity(sprite, (vector_t) {0, BOUNCE_SPEED});
+        }
+        highest = fmax(highest, centroid.y);
+        body_add_force(sprite, (vector_t) {0, -GRAVITY * SPRITE_MASS});
+        if (shoot) {
+            body_pool_acquire(world->shots, centroid, SHOT_VELOCITY);
+        }
+    }
+
+    // Scroll the view up once a jumper passes the scroll line
+    double scroll = highest - (bottom + SCROLL_LINE);
+    if (scroll > 0) {
+        camera_move(world->camera, (vector_t) {0, scroll});
+        bottom += scroll;
+    }
+    level_stream_update(world->level, bottom, bottom + SCREEN_HEIGHT);
+
+    // Park shots that have flown off the top of the screen
+    for (size_t i = 0; i < body_pool_size(world->shots); i++) {
+        body_t *shot = body_pool_get(world->shots, i);
+        if (body_visible(shot) && body_get_centroid(shot).y > bottom + SCREEN_HEIGHT) {
+            body_pool_release(world->shots, shot);
+        }
+    }
+}
+
+int main(int argc, char *argv[]) {
+    size_t platforms = DEFAULT_BODIES;
+    size_t ticks = DEFAULT_TICKS;
+    bench_parse_args(argc, argv, &platforms, &ticks);
+
+    world_t world = {.lane_count = platforms / PLATFORMS_PER_LANE > 0 ? platforms / PLATFORMS_PER_LANE : 1};
+    world.sprites = malloc(world.lane_count * sizeof(body_t *));
+    world.camera = camera_init();
+
+    scene_t *scene = scene_init();
+    world.broad_phase = create_broad_phase(scene, CELL_SIZE);
+    broad_phase_add_rule(world.broad_phase, SPRITE_CATEGORY, PLATFORM_CATEGORY, land, NULL, NULL);
+    broad_phase_add_rule(world.broad_phase, SHOT_CATEGORY, MONSTER_CATEGORY, shoot_monster, &world, NULL);
+    world.shots = create_body_pool(scene, make_shot, &world, NULL);
+    for (size_t i = 0; i < world.lane_count; i++) {
+        vector_t start = {(i + 0.5) * LANE_WIDTH, SCROLL_LINE};
+        body_t *sprite = body_init(make_shape_circle(SPRITE_RADIUS, start, SPRITE_POINTS),
+            SPRITE_MASS, (rgb_color_t) {1, 0, 1});
+        scene_add_body(scene, sprite);
+        broad_phase_set_category(world.broad_phase, sprite, SPRITE_CATEGORY, ALL_CATEGORIES);
+        world.sprites[i] = sprite;
+    }
+    world.level = create_level_stream(scene, 0, SEED, generate_chunk, &world, spawn_body, &world);
+    step(scene, &world);
+
+    bench_run("doodlejump", scene, ticks, DT, (bench_step_t) step, &world);
+    free(world.sprites);
+    camera_free(world.camera);
+    return 0;
+}
@@ -0,0 +1,47 @@
+#include <stdlib.h>
+#include "bench_util.h"
+#include "body.h"
+#include "gravity_field.h"
+#include "rand_utils.h"
+#include "scene.h"
+#include "shape.h"
+
+// Same setup as demo/nbodies.c, with a configurable body count
+const vector_t WINDOW_MIN = {0, 0};
+const vector_t WINDOW_MAX = {1000, 500};
+const double OUTER_R_MIN = 3.0;
+const double OUTER_R_MAX = 10.0;
+const double SCALE = 2.0;
+const double MASS_MIN = 1.0;
+const double MASS_MAX = 5.0;
+const double G = 10000.0;
+const double THETA = 0.5;
+
+const size_t DEFAULT_BODIES = 1000;
+const size_t DEFAULT_TICKS = 200;
+const size_t DEFAULT_THREADS = 1;
+const double DT = 0.001;
+
+int main(int argc, char *argv[]) {
+    size_t bodies = DEFAULT_BODIES;
+    size_t ticks = DEFAULT_TICKS;
+    bench_parse_args(argc, argv, &bodies, &ticks);
+    // An optional third argument sets the gravity field's thread count
+    size_t threads = argc > 3 ? strtoul(argv[3], NULL, 10) : DEFAULT_THREADS;
+    srand(0);
+
+    scene_t *scene = scene_init();
+    gravity_field_t *field = create_gravity_field(scene, G, THETA);
+    gravity_field_set_threads(field, threads);
+    for (size_t i = 0; i < bodies; i++) {
+        vector_t center = {rand_range(WINDOW_MIN.x, WINDOW_MAX.x), rand_range(WINDOW_MIN.y, WINDOW_MAX.y)};
+        double outer_r = rand_range(OUTER_R_MIN, OUTER_R_MAX);
+        list_t *star = make_shape_star(center, 4, outer_r, outer_r / SCALE);
+        body_t *body = body_init(star, rand_range(MASS_MIN, MASS_MAX), (rgb_color_t) {0, 0, 0});
+        scene_add_body(scene, body);
+        gravity_field_add_body(field, body);
+    }
+
+    bench_run("nbodies", scene, ticks, DT, NULL, NULL);
+    return 0;
+}
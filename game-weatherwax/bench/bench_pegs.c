@@ -0,0 +1,94 @@
+#include <math.h>
+#include <stdlib.h>
+#include "bench_util.h"
+#include "body.h"
+#include "broad_phase.h"
+#include "rand_utils.h"
+#include "scene.h"
+#include "shape.h"
+
+// A pegs board like demo/pegs.c, widened to hold a configurable number of pegs.
+// Balls that fall off the bottom are moved back to the top,
+// so the scene keeps the same bodies for the whole run.
+// Collisions come from category rules rather than one registration per pair.
+const size_t CIRCLE_POINTS = 40;
+const double PEG_RADIUS = 0.5;
+const double BALL_RADIUS = 1.0;
+const double PEG_SPACING = 3.5;
+const double PEG_ELASTICITY = 0.3;
+const double BALL_ELASTICITY = 0.7;
+const double BALL_MASS = 2.0;
+const double GRAVITY = 9.8;
+const double CELL_SIZE = 4.0;
+// One ball for every this many pegs
+const size_t PEGS_PER_BALL = 10;
+const uint32_t BALL_CATEGORY = 1 << 0;
+const uint32_t PEG_CATEGORY = 1 << 1;
+
+const size_t DEFAULT_BODIES = 1000;
+const size_t DEFAULT_TICKS = 500;
+const double DT = 0.005;
+
+typedef struct board {
+    body_t **balls;
+    size_t ball_count;
+    double width;
+    double height;
+} board_t;
+
+static vector_t drop_point(board_t *board) {
+    return (vector_t) {rand_range(0, board->width), board->height + rand_range(0, board->height / 4)};
+}
+
+static void step(scene_t *scene, board_t *board) {
+    for (size_t i = 0; i < board->ball_count; i++) {
+        body_t *ball = board->balls[i];
+        if (body_get_centroid(ball).y < 0) {
+            body_set_centroid(ball, drop_point(board));
+            body_set_velocity(ball, VEC_ZERO);
+        }
+        body_add_force(ball, (vector_t) {0, -GRAVITY * BALL_MASS});
+    }
+}
+
+int main(int argc, char *argv[]) {
+    size_t pegs = DEFAULT_BODIES;
+    size_t ticks = DEFAULT_TICKS;
+    bench_parse_args(argc, argv, &pegs, &ticks);
+    srand(0);
+
+    size_t cols = (size_t) ceil(sqrt(pegs));
+    size_t rows = (pegs + cols - 1) / cols;
+    board_t board = {
+        .ball_count = pegs / PEGS_PER_BALL > 0 ? pegs / PEGS_PER_BALL : 1,
+        .width = cols * PEG_SPACING,
+        .height = rows * PEG_SPACING
+    };
+    board.balls = malloc(board.ball_count * sizeof(body_t *));
+
+    scene_t *scene = scene_init();
+    broad_phase_t *broad_phase = create_broad_phase(scene, CELL_SIZE);
+    broad_phase_add_physics_rule(broad_phase, BALL_ELASTICITY, BALL_CATEGORY, BALL_CATEGORY);
+    broad_phase_add_physics_rule(broad_phase, PEG_ELASTICITY, BALL_CATEGORY, PEG_CATEGORY);
+    for (size_t i = 0; i < board.ball_count; i++) {
+        body_t *ball = body_init(make_shape_circle(BALL_RADIUS, drop_point(&board), CIRCLE_POINTS),
+            BALL_MASS, (rgb_color_t) {1, 0, 0});
+        scene_add_body(scene, ball);
+        broad_phase_set_category(broad_phase, ball, BALL_CATEGORY, ALL_CATEGORIES);
+        board.balls[i] = ball;
+    }
+    for (size_t i = 0; i < pegs; i++) {
+        // Odd rows are offset by half a column, as on a real board
+        size_t row = i / cols;
+        double x = (i % cols + (row % 2 == 1 ? 0.5 : 0.0)) * PEG_SPACING;
+        vector_t center = {x, (row + 0.5) * PEG_SPACING};
+        body_t *peg = body_init(make_shape_circle(PEG_RADIUS, center, CIRCLE_POINTS),
+            INFINITY, (rgb_color_t) {0, 1, 0});
+        scene_add_body(scene, peg);
+        broad_phase_set_category(broad_phase, peg, PEG_CATEGORY, BALL_CATEGORY);
+    }
+
+    bench_run("pegs", scene, ticks, DT, (bench_step_t) step, &board);
+    free(board.balls);
+    return 0;
+}
@@ -0,0 +1,77 @@
+#include <SDL2/SDL.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "bench_alloc.h"
+#include "bench_util.h"
+
+// Atomic because the libraries allocate from worker and generator threads too
+static SDL_atomic_t alloc_count;
+
+// The parentheses keep bench_alloc.h's macros from expanding, so these call the real allocator
+void *bench_malloc(size_t size) {
+    SDL_AtomicAdd(&alloc_count, 1);
+    return (malloc)(size);
+}
+
+void *bench_calloc(size_t count, size_t size) {
+    SDL_AtomicAdd(&alloc_count, 1);
+    return (calloc)(count, size);
+}
+
+void *bench_realloc(void *ptr, size_t size) {
+    SDL_AtomicAdd(&alloc_count, 1);
+    return (realloc)(ptr, size);
+}
+
+size_t bench_alloc_count(void) {
+    return (size_t) (unsigned) SDL_AtomicGet(&alloc_count);
+}
+
+static double now(void) {
+    struct timespec time;
+    timespec_get(&time, TIME_UTC);
+    return time.tv_sec + time.tv_nsec * 1e-9;
+}
+
+void bench_parse_args(int argc, char *argv[], size_t *bodies, size_t *ticks) {
+    if (argc > 1) {
+        *bodies = strtoul(argv[1], NULL, 10);
+    }
+    if (argc > 2) {
+        *ticks = strtoul(argv[2], NULL, 10);
+    }
+    // The per-tick numbers divide by the tick count
+    if (*ticks == 0) {
+        fprintf(stderr, "usage: %s [bodies] [ticks], with ticks > 0\n", argv[0]);
+        exit(EXIT_FAILURE);
+    }
+}
+
+void bench_run(const char *name, scene_t *scene, size_t ticks, double dt, bench_step_t step, void *aux) {
+    // Let caches and buffers fill before measuring
+    if (step != NULL) {
+        step(scene, aux);
+    }
+    scene_tick(scene, dt);
+
+    size_t allocs_before = bench_alloc_count();
+
+    size_t body_ticks = 0;
+    double start = now();
+    for (size_t i = 0; i < ticks; i++) {
+        if (step != NULL) {
+            step(scene, aux);
+        }
+        body_ticks += scene_bodies(scene);
+        scene_tick(scene, dt);
+    }
+    double elapsed = now() - start;
+
+    size_t allocs = bench_alloc_count() - allocs_before;
+    size_t bodies = scene_bodies(scene);
+    scene_free(scene);
+
+    printf("%s bodies=%zu ticks=%zu ticks/s=%.1f ns/body/tick=%.1f allocs/tick=%.1f\n", name, bodies, ticks,
+        ticks / elapsed, body_ticks == 0 ? 0.0 : elapsed * 1e9 / body_ticks, (double) allocs / ticks);
+}
@@ -0,0 +1,48 @@
+#ifndef __BENCH_UTIL_H__
+#define __BENCH_UTIL_H__
+
+#include <stddef.h>
+#include "scene.h"
+
+/**
+ * Shared driver for the headless benchmarks in bench/.
+ * Each benchmark builds one scene, then hands it to bench_run(),
+ * which ticks it at a fixed dt and prints a single line like
+ *   nbodies bodies=1000 ticks=500 ticks/s=812.4 ns/body/tick=1231.0 allocs/tick=0.0
+ *
+ * Benchmarks are built with optimizations and without sanitizers.
+ * Allocations are counted by the wrappers in bench_alloc.h.
+ */
+
+/**
+ * A function run before every tick, e.g. to spawn or recycle bodies.
+ * Time spent in it is included in the measurement.
+ */
+typedef void (*bench_step_t)(scene_t *scene, void *aux);
+
+/**
+ * Reads the optional command line arguments "[bodies] [ticks]".
+ *
+ * @param argc the argument count passed to main
+ * @param argv the arguments passed to main
+ * @param bodies set to the first argument, if given
+ * @param ticks set to the second argument, if given;
+ *   exits with a usage message if the tick count is 0
+ */
+void bench_parse_args(int argc, char *argv[], size_t *bodies, size_t *ticks);
+
+/**
+ * Ticks a scene repeatedly and prints its throughput, then frees the scene.
+ * One extra tick is run first and left out of the numbers,
+ * so one-time setup inside the library does not count as per-tick work.
+ *
+ * @param name the benchmark name to print
+ * @param scene the scene to tick
+ * @param ticks the number of ticks to run
+ * @param dt the time step passed to scene_tick
+ * @param step run before each tick, or NULL
+ * @param aux passed to step
+ */
+void bench_run(const char *name, scene_t *scene, size_t ticks, double dt, bench_step_t step, void *aux);
+
+#endif // #ifndef __BENCH_UTIL_H__
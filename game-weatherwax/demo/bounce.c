@@ -7,6 +7,7 @@
 #include "list.h"
 #include <stdbool.h>
 #include "shape.h"
+#include "shape_cache.h"
 #include <assert.h>
 
 const vector_t WINDOW_MIN = {0.0, 0.0};
@@ -22,54 +23,27 @@ const double B = 40.0/255.0;
 const double ELASTICITY = 1.0;
 const double MASS = 1.0;
 
-void hit_wall(body_t *star) {
-    bool coll_x = false;
-    bool coll_y = false;
+void hit_wall(shape_cache_t *shapes, body_t *star) {
+    bounds_t bounds = shape_cache_view(shapes, star).bounds;
+    vector_t shift = {0.0, 0.0};
+    vector_t currvel = body_get_velocity(star);
 
-    list_t *star_shape = body_get_shape(star);
-
-    for (int i = 0; i < list_size(star_shape); i++) {
-        vector_t *vec = (vector_t *)list_get(star_shape, i);
-        double y = vec->y;
-        double x = vec->x;
-        if (!coll_x) {
-            if (x <= WINDOW_MIN.x) {
-                body_set_centroid(star, vec_add(body_get_centroid(star), (vector_t) {WINDOW_MIN.x - x, 0.0}));
-                vector_t currvel = body_get_velocity(star);
-                currvel.x = (double) body_get_elasticity(star) * -currvel.x;
-                body_set_velocity(star, currvel);
-                coll_x = true;
-            }
-            if (x >= WINDOW_MAX.x) {
-                body_set_centroid(star, vec_add(body_get_centroid(star), (vector_t) {WINDOW_MAX.x - x, 0.0}));
-                vector_t currvel = body_get_velocity(star);
-                currvel.x = (double) body_get_elasticity(star) * -currvel.x;
-                body_set_velocity(star, currvel);
-                coll_x = true;
-            }
-        }
-        if (!coll_y) {
-            if (y <= WINDOW_MIN.y) {
-                body_set_centroid(star, vec_add(body_get_centroid(star), (vector_t) {0.0, WINDOW_MIN.y - y}));
-                vector_t currvel = body_get_velocity(star);
-                currvel.y = (double) body_get_elasticity(star) * -currvel.y;
-                body_set_velocity(star, currvel);
-                coll_y = true;
-            }
-            if (y >= WINDOW_MAX.y) {
-                body_set_centroid(star, vec_add(body_get_centroid(star), (vector_t) {0.0, WINDOW_MAX.y - y}));
-                vector_t currvel = body_get_velocity(star);
-                currvel.y = (double) body_get_elasticity(star) * -currvel.y;
-                body_set_velocity(star, currvel);
-                coll_y = true;
-            }
-        }
+    if (bounds.min.x <= WINDOW_MIN.x || bounds.max.x >= WINDOW_MAX.x) {
+        shift.x = bounds.min.x <= WINDOW_MIN.x ? WINDOW_MIN.x - bounds.min.x : WINDOW_MAX.x - bounds.max.x;
+        currvel.x = (double) body_get_elasticity(star) * -currvel.x;
+    }
+    if (bounds.min.y <= WINDOW_MIN.y || bounds.max.y >= WINDOW_MAX.y) {
+        shift.y = bounds.min.y <= WINDOW_MIN.y ? WINDOW_MIN.y - bounds.min.y : WINDOW_MAX.y - bounds.max.y;
+        currvel.y = (double) body_get_elasticity(star) * -currvel.y;
     }
+    body_set_centroid(star, vec_add(body_get_centroid(star), shift));
+    body_set_velocity(star, currvel);
 }
 
 
 int main (int arc, char *argv[]) {
     scene_t *scene = scene_init();
+    shape_cache_t *shapes = create_shape_cache(scene);
 
     sdl_init(WINDOW_MIN, WINDOW_MAX);
     vector_t start = (vector_t) {(WINDOW_MAX.x / 2.0), (WINDOW_MAX.y / 2.0)};
@@ -89,7 +63,7 @@ int main (int arc, char *argv[]) {
         scene_tick(scene, dt);
 
         // Check for collisions and update velocity
-        hit_wall(star);
+        hit_wall(shapes, star);
 
         sdl_render_scene(scene);
     }
@@ -12,6 +12,7 @@
 #include "scene.h"
 #include "forces.h" 
 #include "collision.h"
+#include "scene_snapshot.h"
 
 // CONSTANTS: 
 const vector_t WINDOW_MIN = {0.0, 0.0};
@@ -57,6 +58,16 @@ typedef enum {
     HEALTH
 } body_type3_t;
 
+// what each body in the level snapshot is, so a removed one can be made again
+typedef enum {
+    BALL_KIND,
+    PLAYER_KIND,
+    BRICK_KIND
+} body_kind_t;
+
+// the level as it is at the start of every life, taken once it is built
+scene_snapshot_t *level_start = NULL;
+
 list_t *make_shape_rect(double width, double length, vector_t centroid){
     list_t *rect_points = list_init(4, (free_func_t) free);
     for (size_t i = 1; i <= 4; i ++){
@@ -130,12 +141,8 @@ void brick_collisions_handler(body_t *body1, body_t *body2, vector_t axis, void
     body_add_impulse(body2, vec_multiply(-impulse, axis));
     size_t health = (size_t) body_get_type(body1);
     if (health > 1){
-        rgb_color_t color = body_get_color(body1); 
-        vector_t center = body_get_centroid(body1);
-        size_t new_health = health - 1;
-        body_remove(body1);
-        body_t *brick = make_one_brick((scene_t*) aux, center, color, new_health);
-        create_collision((scene_t*) aux, brick, scene_get_body((scene_t*) aux, 0), brick_collisions_handler, (scene_t*) aux, NULL);
+        // the brick stays the same body, so the level snapshot can still restore it
+        body_set_type(body1, health - 1);
     }
     else{
         body_remove(body1);
@@ -173,12 +180,33 @@ void make_all_bricks(scene_t *scene){
     }
 }
 
-scene_t *reset(scene_t *scene_old){
-    scene_free(scene_old); 
-    scene_t *scene = scene_init();
+// makes a brick the ball broke since the start of the life again, with its collision
+body_t *respawn_brick(scene_t *scene, const body_state_t *state, void *aux){
+    if (state->kind != BRICK_KIND){
+        return NULL;
+    }
+    body_t *brick = make_one_brick(scene, state->centroid, state->color, state->type);
+    create_collision(scene, brick, scene_get_body(scene, 0), brick_collisions_handler, scene, NULL);
+    return brick;
+}
+
+// builds the level once and snapshots it, so losing a life only restores the snapshot
+scene_t *build(scene_t *scene){
     body_t *ball = make_ball(scene);
-    make_player(scene, ball); 
+    body_t *player = make_player(scene, ball); 
     make_all_bricks(scene);
+
+    level_start = create_scene_snapshot(scene, respawn_brick, NULL);
+    scene_snapshot_add(level_start, ball, BALL_KIND);
+    scene_snapshot_add(level_start, player, PLAYER_KIND);
+    for (size_t i = 2; i < scene_bodies(scene); i++){
+        scene_snapshot_add(level_start, scene_get_body(scene, i), BRICK_KIND);
+    }
+    return scene;
+}
+
+scene_t *reset(scene_t *scene){
+    scene_snapshot_restore(level_start);
     return scene;
 }
 
@@ -240,7 +268,7 @@ int main(int argc, char *argv[]) {
 
     scene_t *scene = scene_init();
     double time = 0;
-    scene = reset(scene); 
+    scene = build(scene); 
 
     sdl_on_key(on_key);
 
@@ -1,3 +1,4 @@
+#include <SDL2/SDL.h>
 #include <stdio.h>
 #include <vector.h>
 #include <math.h>
@@ -11,6 +12,7 @@
 #include "scene.h"
 #include "forces.h"
 #include "rand_utils.h"
+#include "spring_field.h"
 
 vector_t WINDOW_MIN = {0.0, 0.0};
 vector_t WINDOW_MAX = {1000.0, 500.0};
@@ -26,6 +28,8 @@ double DRAG = 0.5;
 
 scene_t *balls(){
     scene_t *scene = scene_init();
+    spring_field_t *springs = create_spring_field(scene);
+    spring_field_set_threads(springs, SDL_GetCPUCount());
 
     double scale_x = WINDOW_MAX.x / NUM_BALLS;
     double scale_y = WINDOW_MAX.y / (2 * pow(CENTER.x, 2));
@@ -53,8 +57,8 @@ scene_t *balls(){
         scene_add_body(scene, no_circle);
         scene_add_body(scene, circle);
 
-        create_spring(scene, SPRING1, circle, no_circle);
-        create_drag(scene, DRAG, circle);
+        spring_field_add_spring(springs, SPRING1, circle, no_circle);
+        spring_field_add_drag(springs, DRAG, circle);
     }
     return scene;
 }
@@ -14,6 +14,18 @@
 #include "scene.h"
 #include "forces.h" 
 #include "collision.h"
+#include "body_pool.h"
+#include "body_table.h"
+#include "type_index.h"
+#include "broad_phase.h"
+#include "batch_render.h"
+#include "camera.h"
+#include "fixed_step.h"
+#include "texture_cache.h"
+#include "level_stream.h"
+#include "placement.h"
+#include "rng.h"
+#include "input_log.h"
 #include "rand_utils.h"
 
 #include "game_make_objects.h"
@@ -55,6 +67,7 @@ const double PLATFORM_WIDTH = 80.0;
 const double PLATFORM_MASS = INFINITY; 
 const double PLATFORM_ELASTICITY = 1.0;
 const double NUM_PLATFORMS_PER_SCREEN = 8.0;
+const size_t MAX_PLACEMENT_ATTEMPTS = 32;
 const vector_t VEC_MOVING = {50.0, 0.0};
 
 const rgb_color_t PLATFORM_COLOR = {0.0, 0.0, 1.0};
@@ -92,6 +105,17 @@ const rgb_color_t DEFEND_COLOR = {0.0, 0.8, 0.0};
 const vector_t DEFEND_SHOT_VELOCITY = {0.0, 800.0};
 const size_t SHOT_RESOLUTION = 20;
 
+// collision categories for the broad phase's rules
+const uint32_t SHOT_CATEGORY = 1 << 0;
+const uint32_t MONSTER_CATEGORY = 1 << 1;
+
+// broad phase information
+const double CELL_SIZE = 100.0;
+
+// physics runs at a fixed rate, independent of the frame rate
+const double PHYSICS_HZ = 240.0;
+const size_t MAX_SUBSTEPS = 8;
+
 // spring information
 const double SPRING_SIZE = 20.0;
 const double SPRING_MASS = 1.0;
@@ -131,37 +155,127 @@ const double SCORETILE_SIZE = 1;
 
 
 
+// broad phase and shot pool of the current scene; replaced whenever reset() rebuilds the scene
+broad_phase_t *broad_phase = NULL;
+body_pool_t *shot_pool = NULL;
+// scrolls the view up the level; the bodies themselves never move to scroll
+camera_t *camera = NULL;
+// handles into the current scene, so the sprite is not found by its index in the scene
+body_table_t *handles = NULL;
+body_handle_t sprite_handle;
+// the current scene's bodies by type, so per-frame checks only visit the bodies they need
+type_index_t *types = NULL;
+// every image the game shows, loaded once in main() and kept across resets
+texture_cache_t *textures = NULL;
+// lays out the current scene's level ahead of the camera; replaced along with the scene
+level_stream_t *level = NULL;
+// the session being recorded with --record or replayed with --replay, or NULL
+input_log_t *input_log = NULL;
+// seeded once in main(); lays out every level, so the seed alone decides the layout
+rng_t level_rng;
+
+// the player's body, or NULL once it has been removed
+body_t *get_sprite(void) {
+    return body_table_get(handles, sprite_handle);
+}
+
+// whether the player has been killed or has fallen below the screen
+bool sprite_dead(void) {
+    body_t *sprite = get_sprite();
+    if (sprite == NULL) {
+        return true;
+    }
+    body_type_t type = body_get_type(sprite);
+    return (type != SPRITE && type != SPRITE_INVUL) || camera_to_view(camera, body_get_centroid(sprite)).y < WINDOW_MIN.y;
+}
+
+// a shot destroys the monster it hits and goes back to the pool
+void shoot_monster(body_t *shot, body_t *monster, vector_t axis, void *aux) {
+    body_remove(monster);
+    body_pool_release(shot_pool, shot);
+}
+
+// makes a shot for the pool; the shot/monster rule added in reset() lets it hit monsters
+body_t *make_pooled_shot(body_pool_t *pool, void *aux) {
+    scene_t *scene = body_pool_get_scene(pool);
+    body_t *shot = make_shot(scene, VEC_ZERO, SHOT_SIZE, SHOT_MASS, DEFEND_COLOR, DEFEND_SHOT_VELOCITY, SHOT_RESOLUTION);
+    // shots are fast enough to skip over a monster between frames
+    broad_phase_set_bullet(broad_phase, shot, true);
+    broad_phase_set_category(broad_phase, shot, SHOT_CATEGORY, ALL_CATEGORIES);
+    return shot;
+}
+
 // ===== GROUPINGS =====
-// makes num_platforms unmovable platform randomly spaced in the x direction at the top of the screen
-// these range a double of height above the screen so then when we move them down they will fill the right area
-// Returns the max height of the top rendered object, relative to the screen base.
-double make_constant_platforms(scene_t *scene, double start_y, double height, double min_jump) {
+// kinds of bodies a level chunk spawns
+typedef enum {
+    PLATFORM_SPAWN,
+    MOVING_PLATFORM_SPAWN,
+    BREAKING_PLATFORM_SPAWN,
+    SPRING_SPAWN,
+    JET_SPAWN,
+    MONSTER_SPAWN
+} spawn_kind_t;
+
+// level tuning copied when a level stream starts; generate_chunk() runs on the stream's thread,
+// so it reads this instead of globals the game may change
+typedef struct level_layout {
+    double moving_plat_ratio;
+    // where the current chunk's spawns are, so breaking platforms go in the gaps
+    placement_t *placement;
+    // the previous chunk's spawns reaching within a platform height of its top,
+    // which the next chunk's breaking platforms must also stay clear of
+    spawn_t *seam;
+    size_t seam_count;
+    size_t seam_capacity;
+} level_layout_t;
+
+// the room a spawn takes up in the level
+vector_t spawn_footprint(spawn_kind_t kind) {
+    switch (kind) {
+        case SPRING_SPAWN:
+            return (vector_t) {SPRING_SIZE, SPRING_SIZE};
+        case JET_SPAWN:
+            return (vector_t) {JET_SIZE, JET_SIZE};
+        case MONSTER_SPAWN:
+            return (vector_t) {2 * MONSTER_RAD, 2 * MONSTER_RAD};
+        default:
+            return (vector_t) {PLATFORM_WIDTH, PLATFORM_HEIGHT};
+    }
+}
+
+// adds a spawn to a chunk and marks its room as taken
+void place_spawn(level_chunk_t *chunk, placement_t *placement, spawn_t spawn) {
+    level_chunk_add(chunk, spawn);
+    placement_add(placement, spawn.position, spawn_footprint(spawn.kind));
+}
+
+// lays out unmovable and moving platforms randomly spaced in the x direction, with springs and jets on some of them
+// Returns the height of the highest platform.
+double make_constant_platforms(level_chunk_t *chunk, level_layout_t *layout, placement_t *placement, double start_y, double height, double min_jump) {
     double y_pos = start_y;
     while (y_pos < start_y + height) {
-        y_pos += rand_range(min_jump, BOUNCE_HEIGHT - EPSILON);
-        vector_t center = {rand_range(WINDOW_MIN.x, WINDOW_MAX.x - EPSILON), y_pos};
+        y_pos += level_chunk_rand(chunk, min_jump, BOUNCE_HEIGHT - EPSILON);
+        vector_t center = {level_chunk_rand(chunk, WINDOW_MIN.x, WINDOW_MAX.x - EPSILON), y_pos};
         vector_t velo = (vector_t) {0.0, 0.0};
-        rgb_color_t color = PLATFORM_COLOR;
-        image_t image = PLATFORM_IMAGE;
-        if (rand_range(0, 1) < moving_plat_ratio) {
-            if (rand_range(0, 1) > 0.5) {
+        spawn_kind_t kind = PLATFORM_SPAWN;
+        if (level_chunk_rand(chunk, 0, 1) < layout->moving_plat_ratio) {
+            if (level_chunk_rand(chunk, 0, 1) > 0.5) {
                 velo = vec_subtract(velo, VEC_MOVING);
             }
             else{
                 velo = vec_add(velo, VEC_MOVING);
             }
-            color = MOVING_COLOR;
-            image = MOVING_PLAT_IMAGE;
+            kind = MOVING_PLATFORM_SPAWN;
         }
-        if (velo.x == 0.0 && rand_range(0, 1) < SPRING_PROB) {
-            vector_t base = vec_add(center, (vector_t) {rand_range(-PLATFORM_WIDTH/2 + SPRING_SIZE/2, PLATFORM_WIDTH/2 - SPRING_SIZE/2), PLATFORM_HEIGHT/2});
-            make_spring(scene, base, SPRING_SIZE, SPRING_MASS, ACC, SPRING_BOUNCE_HEIGHT, SPRING_COLOR, SPRING_IMAGE);
+        if (velo.x == 0.0 && level_chunk_rand(chunk, 0, 1) < SPRING_PROB) {
+            vector_t base = vec_add(center, (vector_t) {level_chunk_rand(chunk, -PLATFORM_WIDTH/2 + SPRING_SIZE/2, PLATFORM_WIDTH/2 - SPRING_SIZE/2), PLATFORM_HEIGHT/2});
+            place_spawn(chunk, placement, (spawn_t) {SPRING_SPAWN, base, VEC_ZERO});
         }
-        else if (velo.x == 0.0 && rand_range(0, 1) < JET_PROB) {
-            vector_t base = vec_add(center, (vector_t) {rand_range(-PLATFORM_WIDTH/2 + JET_SIZE/2, PLATFORM_WIDTH/2 - JET_SIZE/2), PLATFORM_HEIGHT/2});
-            make_jet(scene, base, JET_SIZE, JET_MASS, JET_COLOR, ACC, LOW_ACC, HIGH_ACC, STOP_ACC, START_DEC);
+        else if (velo.x == 0.0 && level_chunk_rand(chunk, 0, 1) < JET_PROB) {
+            vector_t base = vec_add(center, (vector_t) {level_chunk_rand(chunk, -PLATFORM_WIDTH/2 + JET_SIZE/2, PLATFORM_WIDTH/2 - JET_SIZE/2), PLATFORM_HEIGHT/2});
+            place_spawn(chunk, placement, (spawn_t) {JET_SPAWN, base, VEC_ZERO});
         }
-        make_platform(scene, center, PLATFORM_WIDTH, PLATFORM_HEIGHT, PLATFORM_MASS, velo, color, image, ACC, BOUNCE_HEIGHT, platform_collision);
+        place_spawn(chunk, placement, (spawn_t) {kind, center, velo});
     }
 
     return y_pos;
@@ -182,60 +296,55 @@ level_info_t levels(double elevation) {
             break;
         }
     }
+    // Past the last trigger, stay on the last level
+    if (level_index == LEVEL_COUNT) {
+        level_index--;
+    }
+    return LEVEL_INFO[level_index];
+}
 
-
-
-void make_breaking_platforms(scene_t *scene, double start_y, double height, double num_platforms_per_screen) {
+void make_breaking_platforms(level_chunk_t *chunk, placement_t *placement, double start_y, double height, double num_platforms_per_screen) {
     double num_platforms = num_platforms_per_screen * height / WINDOW_MAX.y;
 
     if (num_platforms < 0) {
         num_platforms = - num_platforms;
     }
 
-    if (rand_range(0.0, 1.0) < num_platforms - (double) floor(num_platforms)) {
+    if (level_chunk_rand(chunk, 0.0, 1.0) < num_platforms - (double) floor(num_platforms)) {
         num_platforms ++;
     }
 
-    bool overlap = true;
-    vector_t center;
+    vector_t size = {PLATFORM_WIDTH, PLATFORM_HEIGHT};
     for (size_t i = 0; i < (size_t) num_platforms; i++) {
-        while (overlap) {
-            center = (vector_t) {rand_range(WINDOW_MIN.x, WINDOW_MAX.x), start_y + rand_range(0.0, height)};
-            body_t *plat = make_platform(scene, center, PLATFORM_WIDTH, PLATFORM_HEIGHT, PLATFORM_MASS, VEC_ZERO, BREAKING_PLAT_COLOR, BREAKING_PLAT_IMAGE, ACC, BOUNCE_HEIGHT, breaking_platform_collision);
-
-            // Check for overlap
-            overlap = false;
-            for (size_t i = 0; i < scene_bodies(scene)-1; i++) {
-                body_t *body = scene_get_body(scene, i);
-                if (body_get_type(body) == PLATFORM && find_collision(body_get_shape(plat), body_get_shape(body)).collided && !overlap) {
-                    overlap = true;
-                    scene_remove_body(scene, scene_bodies(scene) - 1);
-                }
+        // Try other spots until the platform does not overlap another one; give up on a crowded chunk
+        for (size_t attempt = 0; attempt < MAX_PLACEMENT_ATTEMPTS; attempt++) {
+            vector_t center = {level_chunk_rand(chunk, WINDOW_MIN.x, WINDOW_MAX.x), start_y + level_chunk_rand(chunk, 0.0, height)};
+            if (placement_fits(placement, center, size)) {
+                place_spawn(chunk, placement, (spawn_t) {BREAKING_PLATFORM_SPAWN, center, VEC_ZERO});
+                break;
             }
         }
     }
 
 }
 
-// Spawns in monsters
-double make_monsters(scene_t *scene, double start_y, double height, double min_distance, double max_distance) {
+// Lays out monsters
+double make_monsters(level_chunk_t *chunk, placement_t *placement, double start_y, double height, double min_distance, double max_distance) {
     double y_pos = start_y;
     while (y_pos < start_y + height) {
-        y_pos += rand_range(min_distance, max_distance);
-        vector_t center = {rand_range(WINDOW_MIN.x, WINDOW_MAX.x - EPSILON), y_pos};
+        y_pos += level_chunk_rand(chunk, min_distance, max_distance);
+        vector_t center = {level_chunk_rand(chunk, WINDOW_MIN.x, WINDOW_MAX.x - EPSILON), y_pos};
         vector_t velo = (vector_t) {0.0, 0.0};
-        rgb_color_t color = MONSTER_COLOR;
-        if (rand_range(0, 1) > 0.8) {
-            if (rand_range(0, 1) > 0.5){
+        if (level_chunk_rand(chunk, 0, 1) > 0.8) {
+            if (level_chunk_rand(chunk, 0, 1) > 0.5){
                 velo = vec_subtract(velo, MONSTER_MOVING_VEL);
             }
             else{
                 velo = vec_add(velo, MONSTER_MOVING_VEL);
             }
-            color = MOVING_MONSTER_COLOR;
         }
         if (y_pos < start_y + height) {
-            make_monster(scene, center, MONSTER_RAD, MONSTER_MASS, velo, color, MONSTER_RESOLUTION, MONSTER_FILE_NAME);
+            place_spawn(chunk, placement, (spawn_t) {MONSTER_SPAWN, center, velo});
         }
     }
 
@@ -243,24 +352,104 @@ double make_monsters(scene_t *scene, double start_y, double height, double min_d
 }
 // ===== SCREEN DYNAMICS =====
 
-// Adds one more screen height section to the scene. Returns the elevation of the highest platform created. that is the score
-double extend_scene(scene_t *scene, double start_y) {
-    double max_y = make_constant_platforms(scene, start_y, WINDOW_MAX.y - WINDOW_MIN.y, PLATFORM_HEIGHT);
-    make_breaking_platforms(scene, start_y, WINDOW_MAX.y - WINDOW_MIN.y, NUM_PLATFORMS_PER_SCREEN);
-    make_monsters(scene, start_y, WINDOW_MAX.y - WINDOW_MIN.y, MONSTER_MIN, MONSTER_MAX);
+// Lays out one more screen height section of the level. Runs on the level stream's thread.
+// Returns the elevation of the highest platform created. that is the score
+double generate_chunk(level_chunk_t *chunk, double start_y, void *aux) {
+    level_layout_t *layout = aux;
+    placement_t *placement = layout->placement;
+    placement_clear(placement);
+    for (size_t i = 0; i < layout->seam_count; i++) {
+        placement_add(placement, layout->seam[i].position, spawn_footprint(layout->seam[i].kind));
+    }
+    double max_y = make_constant_platforms(chunk, layout, placement, start_y, WINDOW_MAX.y - WINDOW_MIN.y, PLATFORM_HEIGHT);
+    make_breaking_platforms(chunk, placement, start_y, WINDOW_MAX.y - WINDOW_MIN.y, NUM_PLATFORMS_PER_SCREEN);
+    make_monsters(chunk, placement, start_y, WINDOW_MAX.y - WINDOW_MIN.y, MONSTER_MIN, MONSTER_MAX);
+
+    // the next chunk starts at max_y; keep what it could bump into
+    layout->seam_count = 0;
+    for (size_t i = 0; i < level_chunk_size(chunk); i++) {
+        spawn_t spawn = level_chunk_get(chunk, i);
+        if (spawn.position.y + spawn_footprint(spawn.kind).y / 2 > max_y - PLATFORM_HEIGHT) {
+            if (layout->seam_count == layout->seam_capacity) {
+                layout->seam_capacity = layout->seam_capacity == 0 ? 8 : 2 * layout->seam_capacity;
+                layout->seam = realloc(layout->seam, layout->seam_capacity * sizeof(spawn_t));
+                assert(layout->seam != NULL);
+            }
+            layout->seam[layout->seam_count++] = spawn;
+        }
+    }
     // levels(scene, start_y, WINDOW_MAX.y - WINDOW_MIN.y, PLATFORM_HEIGHT);
 
+    return max_y;
+}
 
-    double y = WINDOW_MAX.y * 0.75;
-    double x_min = WINDOW_MIN.x + MONSTER_RAD;
-    double x_max = WINDOW_MAX.x - MONSTER_RAD;
-    double x = rand_range(x_min, x_max);
-    vector_t vec = {x, y};
+// the same image without its file, so a make_* helper builds its skin without reading the disk
+image_t unloaded(image_t image) {
+    image.filename = NULL;
+    return image;
+}
 
-    return max_y;
+// replaces the skin a make_* helper built from an unloaded image with one from the texture cache
+body_t *use_cached_skin(body_t *body, image_t image) {
+    skin_t *unloaded_skin = body_get_skin(body);
+    list_t *images = list_init(1, free);
+    image_t *cached = malloc(sizeof(image_t));
+    *cached = image;
+    list_add(images, cached);
+    body_set_skin(body, skin_init(texture_cache_costumes(textures, images), true));
+    list_free(images);
+    if (unloaded_skin != NULL) {
+        skin_free(unloaded_skin);
+    }
+    return body;
+}
+
+// makes a platform whose skin comes from the texture cache
+body_t *spawn_platform(scene_t *scene, vector_t position, vector_t velocity, rgb_color_t color, image_t image, collision_handler_t handler) {
+    body_t *platform = make_platform(scene, position, PLATFORM_WIDTH, PLATFORM_HEIGHT, PLATFORM_MASS, velocity, color, unloaded(image), ACC, BOUNCE_HEIGHT, handler);
+    return use_cached_skin(platform, image);
+}
+
+// makes the body for a spawn laid out by generate_chunk()
+// skins come from the texture cache, so spawning never reads image files
+body_t *spawn_body(scene_t *scene, spawn_t spawn, void *aux) {
+    switch (spawn.kind) {
+        case PLATFORM_SPAWN:
+            return spawn_platform(scene, spawn.position, spawn.velocity, PLATFORM_COLOR, PLATFORM_IMAGE, platform_collision);
+        case MOVING_PLATFORM_SPAWN:
+            return spawn_platform(scene, spawn.position, spawn.velocity, MOVING_COLOR, MOVING_PLAT_IMAGE, platform_collision);
+        case BREAKING_PLATFORM_SPAWN:
+            return spawn_platform(scene, spawn.position, VEC_ZERO, BREAKING_PLAT_COLOR, BREAKING_PLAT_IMAGE, breaking_platform_collision);
+        case SPRING_SPAWN: {
+            body_t *spring = make_spring(scene, spawn.position, SPRING_SIZE, SPRING_MASS, ACC, SPRING_BOUNCE_HEIGHT, SPRING_COLOR, unloaded(SPRING_IMAGE));
+            return use_cached_skin(spring, SPRING_IMAGE);
+        }
+        case JET_SPAWN:
+            return make_jet(scene, spawn.position, JET_SIZE, JET_MASS, JET_COLOR, ACC, LOW_ACC, HIGH_ACC, STOP_ACC, START_DEC);
+        case MONSTER_SPAWN: {
+            rgb_color_t color = spawn.velocity.x == 0.0 ? MONSTER_COLOR : MOVING_MONSTER_COLOR;
+            body_t *monster = make_monster(scene, spawn.position, MONSTER_RAD, MONSTER_MASS, spawn.velocity, color, MONSTER_RESOLUTION, NULL);
+            use_cached_skin(monster, MONSTER_IMAGE);
+            broad_phase_set_category(broad_phase, monster, MONSTER_CATEGORY, ALL_CATEGORIES);
+            return monster;
+        }
+    }
+    return NULL;
+}
+
+// makes the first platform under the sprite and starts streaming the level above it
+// The previous level's stream stopped when reset() freed its scene, so its layout is no longer in use.
+void start_level(scene_t *scene, level_layout_t *layout) {
+    layout->moving_plat_ratio = moving_plat_ratio;
+    layout->seam_count = 0;
+    body_t *sprite = get_sprite();
+    vector_t first_plat_centroid = {body_get_centroid(sprite).x, rng_range(&level_rng, PLATFORM_HEIGHT, body_get_centroid(sprite).y * 0.5)};
+    spawn_platform(scene, first_plat_centroid, VEC_ZERO, PLATFORM_COLOR, PLATFORM_IMAGE, platform_collision);
+    level = create_level_stream(scene, first_plat_centroid.y, rng_next(&level_rng), generate_chunk, layout, spawn_body, NULL);
+    level_stream_update(level, camera_to_world(camera, WINDOW_MIN).y, camera_to_world(camera, WINDOW_MAX).y);
 }
 
-// moves the screen according to the sprite position. Returns current elevation of the screen view.
+// scrolls the camera up to follow the sprite. Returns the elevation of the highest platform created.
 double move_screen(scene_t *scene, double highest_plat_elevation, size_t level_index) {
     level_info_t level_info;
     // DEBUGGING LEVEL STUFF
@@ -271,39 +460,30 @@ double move_screen(scene_t *scene, double highest_plat_elevation, size_t level_i
         level_info = levels(highest_plat_elevation);
     }
 
-    body_t *sprite = scene_get_body(scene, 1);
-    double y_change = body_get_centroid(sprite).y - SPRITE_MAX_HEIGHT;
-    double elevation = -body_get_centroid(scene_get_body(scene, 0)).y;
+    body_t *sprite = get_sprite();
+    if (sprite == NULL) {
+        return highest_plat_elevation;
+    }
+    double y_change = camera_to_view(camera, body_get_centroid(sprite)).y - SPRITE_MAX_HEIGHT;
+    double elevation = camera_get_position(camera).y;
 
     if (y_change > 0) {
-        // Add enough objects to the scene to keep the game going.
-        while (highest_plat_elevation < elevation + (WINDOW_MAX.y - WINDOW_MIN.y) + y_change) {
-            highest_plat_elevation = extend_scene(scene, highest_plat_elevation - elevation) + elevation;
-        }
-
-        // Now we shift everything.
-        elevation += y_change;
-        for (size_t i = 0; i < scene_bodies(scene); i++) {
-            body_t *body = scene_get_body(scene, i);
-            vector_t center = body_get_centroid(body);
-            center = vec_add(center, (vector_t) {0.0, - y_change});
-            // Deletes bodies that exit the screen.
-            body_type_t type = body_get_type(body);
-            if (center.y <  WINDOW_MIN.y && (type != BASE) && (type != INDICATOR)) {
-                scene_remove_body(scene, i);
-            }
-            else {
-                body_set_centroid(body, center);
-            }
-        }
-    }  
+        // Only the view moves; the bodies keep their world positions.
+        camera_move(camera, (vector_t) {0.0, y_change});
+        // Chunks are laid out ahead of time, so this only adds bodies above the view
+        // and removes whole chunks that have dropped below it.
+        level_stream_update(level, camera_to_world(camera, WINDOW_MIN).y, camera_to_world(camera, WINDOW_MAX).y);
+    }
 
-    return highest_plat_elevation;
+    return level_stream_top(level);
 }
 
 // PERHAPS SHOULD BE A COLLISION HANDLER WITH LEFT/RIGHT WALLS BUT THIS WILL DO
 void wrap(scene_t *scene) {
-    body_t *sprite = scene_get_body(scene, 1);
+    body_t *sprite = get_sprite();
+    if (sprite == NULL) {
+        return;
+    }
     vector_t curr_centroid = body_get_centroid(sprite);
 
     if (curr_centroid.x < WINDOW_MIN.x) {
@@ -318,9 +498,11 @@ void wrap(scene_t *scene) {
 }
 
 void blocks_wrap(scene_t *scene) {
-    for (int i = 0; i < scene_bodies(scene); i++) {
-        body_t *body = scene_get_body(scene, i);
-        if (body_get_type(body) == PLATFORM || body_get_type(body) == MONSTER) {
+    body_type_t wrapping[] = {PLATFORM, MONSTER};
+    for (size_t t = 0; t < sizeof(wrapping) / sizeof(wrapping[0]); t++) {
+        size_t count = type_index_bodies(types, wrapping[t]);
+        for (size_t i = 0; i < count; i++) {
+            body_t *body = type_index_get_body(types, wrapping[t], i);
             vector_t curr_centroid = body_get_centroid(body);
             if (curr_centroid.x < WINDOW_MIN.x || curr_centroid.x > WINDOW_MAX.x) {
                 vector_t v = body_get_velocity(body);
@@ -333,13 +515,17 @@ void blocks_wrap(scene_t *scene) {
 // ===== BODY ACTIONS =====
 // shoots a bullet from player 
 void defend(scene_t *scene) {
-    vector_t location = body_get_centroid(scene_get_body(scene, 1));
-    body_t *shot = make_shot(scene, location, SHOT_SIZE, SHOT_MASS, DEFEND_COLOR, DEFEND_SHOT_VELOCITY, SHOT_RESOLUTION);
-    size_t size = scene_bodies(scene);
-    for (size_t i = 0; i < size; i++) {
-        body_t *body = scene_get_body(scene, i);
-        if (body_get_type(body) == MONSTER) {
-            create_destructive_collision(scene, body, shot);
+    vector_t location = body_get_centroid(get_sprite());
+    body_pool_acquire(shot_pool, location, DEFEND_SHOT_VELOCITY);
+}
+
+// parks shots that have flown off the top of the screen
+void recycle_shots(scene_t *scene) {
+    size_t count = type_index_bodies(types, SHOT);
+    for (size_t i = 0; i < count; i++) {
+        body_t *body = type_index_get_body(types, SHOT, i);
+        if (camera_to_view(camera, body_get_centroid(body)).y > WINDOW_MAX.y) {
+            body_pool_release(shot_pool, body);
         }
     }
 }
@@ -364,9 +550,16 @@ scene_t *reset(scene_t *old_scene) {
     
     scene_free(old_scene);
     scene_t *scene = scene_init();
+    camera_set_position(camera, VEC_ZERO);
+    broad_phase = create_broad_phase(scene, CELL_SIZE);
+    broad_phase_add_rule(broad_phase, SHOT_CATEGORY, MONSTER_CATEGORY, shoot_monster, NULL, NULL);
+    shot_pool = create_body_pool(scene, make_pooled_shot, NULL, NULL);
+    handles = create_body_table(scene);
+    types = create_type_index(scene);
     body_t *base = make_base(scene, (vector_t) {(WINDOW_MAX.x - WINDOW_MIN.x)/2, WINDOW_MIN.y}, BASE_MASS, BASE_SIZE, BASE_COLOR);
     vector_t start = {0.5 * WINDOW_MAX.x, WINDOW_MAX.y * 0.5};
     body_t *sprite = make_sprite(scene, start, SPRITE_RAD, SPRITE_MASS, SPRITE_COLOR, SPRITE_RESOLUTION, ACC, SPRITE_IMAGE, SPRITE_JET_IMAGE);
+    sprite_handle = body_table_add(handles, sprite);
     // Make sprite jump up at start so player has time to move
     make_indicators(scene, centroids);
     make_scoretiles(scene, centroids);
@@ -379,7 +572,7 @@ scene_t *reset(scene_t *old_scene) {
 // makes the start screen 
 void start_screen(scene_t *scene) {
     // counter sprite movement: 
-    body_t *sprite = scene_get_body(scene, 1);
+    body_t *sprite = get_sprite();
     list_t *bodies = list_init(1, NULL);
     list_add(bodies, sprite);
     double *acc = malloc(sizeof(double));
@@ -396,7 +589,8 @@ void start_screen(scene_t *scene) {
     image_t *image = malloc(sizeof(image_t));
     *image = START_SCREEN_IMAGE;
     list_add(images, image);
-    body_set_skin(screen, skin_init(make_costumes_from_images(images), true));
+    body_set_skin(screen, skin_init(texture_cache_costumes(textures, images), true));
+    list_free(images);
 
     scene_add_body(scene, screen);
 }
@@ -404,7 +598,7 @@ void start_screen(scene_t *scene) {
 scene_t *death_screen(scene_t *scene){
     scene = reset(scene); 
     for (size_t i = 0; i < scene_bodies(scene); i++){
-        scene_remove_body(scene, 0);
+        body_remove(scene_get_body(scene, i));
     }
     vector_t center = vec_add(WINDOW_MIN, vec_multiply(0.5, WINDOW_MAX));
     list_t *screen_points = make_shape_rectangle(WINDOW_MAX.x - WINDOW_MIN.x, WINDOW_MAX.y - WINDOW_MIN.y, center);
@@ -414,7 +608,8 @@ scene_t *death_screen(scene_t *scene){
     image_t *image = malloc(sizeof(image_t));
     *image = DEATH_SCREEN_IMAGE;
     list_add(images, image);
-    body_set_skin(screen, skin_init(make_costumes_from_images(images), true));
+    body_set_skin(screen, skin_init(texture_cache_costumes(textures, images), true));
+    list_free(images);
     
     scene_add_body(scene, screen);
     return scene;
@@ -426,7 +621,7 @@ scene_t *death_screen(scene_t *scene){
 scene_t *death(scene_t *scene) {
     body_t *base = scene_get_body(scene, 0);
     double distance = SPRITE_MAX_HEIGHT;
-    vector_t cent = {(WINDOW_MAX.x - (0.5 * INDICATOR_WIDTH)), distance};
+    vector_t cent = camera_to_world(camera, (vector_t) {(WINDOW_MAX.x - (0.5 * INDICATOR_WIDTH)), distance});
     body_t *indicator = make_indicator(scene, cent, INDICATOR_MASS, INDICATOR_WIDTH, INDICATOR_HEIGHT, INDICATOR_COLOR);
     body_t *scoretile = make_scoretile(scene, cent, SCORETILE_MASS, SCORETILE_WIDTH, SCORETILE_HEIGHT, SCORETILE_COLOR);
     scene = reset(scene);
@@ -434,23 +629,11 @@ scene_t *death(scene_t *scene) {
 }
 
 bool dead(scene_t *scene){
-    for (size_t i = 0; i < scene_bodies(scene); i++){
-        body_t *body = scene_get_body(scene, i);
-        if (body_get_type(body) == DEATH_SCREEN) {
-            return true;
-        }
-    }
-    return false;
+    return type_index_bodies(types, DEATH_SCREEN) > 0;
 }
 
 bool start(scene_t *scene){
-    for (size_t i = 0; i < scene_bodies(scene); i++){
-        body_t *body = scene_get_body(scene, i);
-        if (body_get_type(body) == START_SCREEN){
-            return true;
-        }
-    }
-    return false;
+    return type_index_bodies(types, START_SCREEN) > 0;
 }
 
 
@@ -462,7 +645,10 @@ bool start(scene_t *scene){
 
 // handles key input from player
 void on_key(scene_t *scene, char key, key_event_type_t type, double held_time) {
-    body_t *sprite = scene_get_body(scene, 1);
+    body_t *sprite = get_sprite();
+    if (sprite == NULL) {
+        return;
+    }
     vector_t vel = body_get_velocity(sprite);
     vector_t curr_centroid = body_get_centroid(sprite);
     if (type == KEY_PRESSED) {
@@ -480,7 +666,7 @@ void on_key(scene_t *scene, char key, key_event_type_t type, double held_time) {
                 break;
 
             case SDLK_s: 
-                body_set_type(sprite, SPRITE_DEAD);
+                type_index_set_type(types, sprite, SPRITE_DEAD);
                 break;
         }
     }
@@ -501,14 +687,62 @@ void on_key(scene_t *scene, char key, key_event_type_t type, double held_time) {
     }
 }
 
+// ===== RECORD AND REPLAY =====
+
+bool replaying(void) {
+    return input_log != NULL && input_log_is_replay(input_log);
+}
+
+// passes the player's keys to on_key, logging them first when recording
+void record_key(scene_t *scene, char key, key_event_type_t type, double held_time) {
+    if (input_log != NULL) {
+        input_log_key(input_log, key, type, held_time);
+    }
+    on_key(scene, key, type, held_time);
+}
+
+// handles the next frame's keys, from the player or the replayed log; returns whether the game is over
+bool frame_done(scene_t *scene) {
+    if (replaying()) {
+        return !input_log_replay_keys(input_log, scene, on_key);
+    }
+    return sdl_is_done(scene);
+}
+
+// the time to step the next frame by, logged when recording
+double frame_dt(void) {
+    if (replaying()) {
+        return input_log_replay_tick(input_log);
+    }
+    double dt = time_since_last_tick();
+    if (input_log != NULL) {
+        input_log_tick(input_log, dt);
+    }
+    return dt;
+}
+
 // int main to test code periodically, update as necessary 
-int main() {
+// "--record <file>" saves the session and "--replay <file>" reruns it without drawing
+int main(int argc, char *argv[]) {
+    input_log = input_log_from_args(argc, argv, (uint64_t) time(NULL));
     sdl_init(WINDOW_MIN, WINDOW_MAX);
-    srand(time(NULL));
+    uint64_t seed = input_log != NULL ? input_log_seed(input_log) : (uint64_t) time(NULL);
+    srand(seed);
+    level_rng = rng_init(seed);
+    level_layout_t layout = {0};
+    layout.placement = placement_init(PLATFORM_WIDTH);
+    camera = camera_init();
+    batch_render_t *batch = batch_render_init();
+    textures = texture_cache_init();
+    image_t images[] = {
+        SPRITE_IMAGE, SPRITE_JET_IMAGE, PLATFORM_IMAGE, MOVING_PLAT_IMAGE, BREAKING_PLAT_IMAGE,
+        START_SCREEN_IMAGE, DEATH_SCREEN_IMAGE, MONSTER_IMAGE, SPRING_IMAGE, JET_IMAGE
+    };
+    texture_cache_preload(textures, images, sizeof(images) / sizeof(image_t));
 
     scene_t *scene = scene_init();
     scene = reset(scene);
-    sdl_on_key(on_key);
+    sdl_on_key(record_key);
     // start_screen(scene);
 
     // DEBUGGING LEVELS
@@ -517,52 +751,66 @@ int main() {
         level_index = atoi(argv[1]);
     }
 
-    body_t *sprite = scene_get_body(scene, 1);
     // Make a first platform and make this one the start point.
-    vector_t first_plat_centroid = {body_get_centroid(sprite).x, rand_range(PLATFORM_HEIGHT, body_get_centroid(sprite).y * 0.5)};
-    make_platform(scene, first_plat_centroid, PLATFORM_WIDTH, PLATFORM_HEIGHT, PLATFORM_MASS, VEC_ZERO, PLATFORM_COLOR, PLATFORM_IMAGE, ACC, BOUNCE_HEIGHT, platform_collision);
-
-
-    double highest_plat_elevation = extend_scene(scene, first_plat_centroid.y, LEVEL_INFO[0]);
+    start_level(scene, &layout);
+    double highest_plat_elevation = level_stream_top(level);
 
     // double highest_plat_elevation = 0;
     start_screen(scene);
+    fixed_step_t *stepper = fixed_step_init(PHYSICS_HZ, MAX_SUBSTEPS);
+    // where the camera was before the last physics step, so it is drawn partway between steps like the bodies
+    vector_t camera_from = camera_get_position(camera);
 
-    while (!sdl_is_done(scene)) {
+    while (!frame_done(scene)) {
 
-        double dt = time_since_last_tick();
+        double dt = frame_dt();
 
         if (!dead(scene)){
             wrap(scene);
             blocks_wrap(scene);
+            recycle_shots(scene);
 
-        if ((body_get_type(scene_get_body(scene, 1)) != SPRITE && body_get_type(scene_get_body(scene, 1)) != SPRITE_INVUL) || body_get_centroid(sprite).y < WINDOW_MIN.y) {
-            scene = death(scene);
-            vector_t first_plat_centroid = {body_get_centroid(sprite).x, rand_range(PLATFORM_HEIGHT, body_get_centroid(sprite).y * 0.5)};
-            make_platform(scene, first_plat_centroid, PLATFORM_WIDTH, PLATFORM_HEIGHT, PLATFORM_MASS, VEC_ZERO, PLATFORM_COLOR, ACC, BOUNCE_HEIGHT, platform_collision);
-            highest_plat_elevation = extend_scene(scene, first_plat_centroid.y);
-            sprite = scene_get_body(scene, 1); 
-        }
-
-        highest_plat_elevation = move_screen(scene, highest_plat_elevation);
-            if ((body_get_type(scene_get_body(scene, 1)) != SPRITE && body_get_type(scene_get_body(scene, 1)) != SPRITE_INVUL) || body_get_centroid(sprite).y < WINDOW_MIN.y) {
+            if (sprite_dead()) {
                 scene = death(scene);
-                vector_t first_plat_centroid = {body_get_centroid(sprite).x, rand_range(PLATFORM_HEIGHT, body_get_centroid(sprite).y * 0.5)};
-                make_platform(scene, first_plat_centroid, PLATFORM_WIDTH, PLATFORM_HEIGHT, PLATFORM_MASS, VEC_ZERO, PLATFORM_COLOR, PLATFORM_IMAGE, ACC, BOUNCE_HEIGHT, platform_collision);
-                highest_plat_elevation = extend_scene(scene, first_plat_centroid.y, LEVEL_INFO[0]);
-                sprite = scene_get_body(scene, 1); 
+                start_level(scene, &layout);
+                highest_plat_elevation = level_stream_top(level);
+                // the camera jumps back to the start, so there is nothing to blend from
+                camera_from = camera_get_position(camera);
             }
 
+        }
+        if (fixed_step_advance(stepper, scene, dt) > 0) {
+            camera_from = camera_get_position(camera);
+        }
+        // the camera follows the sprite to where the physics steps left it
+        if (!dead(scene)) {
             highest_plat_elevation = move_screen(scene, highest_plat_elevation, level_index);
-
         }
-        scene_tick(scene, dt);
-        
-        sdl_render_scene(scene);
-        sdl_draw_sprite(SPRITE_FILE_NAME, sprite, WINDOW_MAX);
+        if (replaying()) {
+            continue;
+        }
+
+        // drawn through the camera between physics steps, with the sprite over everything else
+        const draw_pose_t *poses = fixed_step_interpolate(stepper, scene);
+        vector_t camera_to = camera_get_position(camera);
+        vector_t camera_drawn = vec_add(camera_from, vec_multiply(fixed_step_alpha(stepper), vec_subtract(camera_to, camera_from)));
+        render_view_t view = {camera_drawn, get_sprite(), poses, scene_bodies(scene)};
+        batch_render_scene_view(batch, scene, broad_phase_get_shapes(broad_phase), &view);
 
     }
 
+    if (input_log != NULL) {
+        input_log_end(input_log, scene);
+    }
+    fixed_step_free(stepper);
+    batch_render_free(batch);
+    camera_free(camera);
     scene_free(scene);
+    placement_free(layout.placement);
+    free(layout.seam);
+    texture_cache_free(textures);
+    if (input_log != NULL) {
+        input_log_free(input_log);
+    }
     return 0;
 }
\ No newline at end of file
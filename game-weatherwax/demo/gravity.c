@@ -9,6 +9,7 @@
 #include "shape.h"
 #include "scene.h"
 #include "rand_utils.h"
+#include "shape_cache.h"
 
 #define WINDOW_TITLE "CS 3"
 #define WINDOW_WIDTH 1000
@@ -32,55 +33,31 @@ const double MIN_ELAST = 0.85;
 const double MAX_ELAST = 0.95;
 
 
-void hit_wall(body_t *star) {
-
-    bool coll_y = false;
-
-    list_t *star_shape = body_get_shape(star);
-
-    for (int i = 0; i < list_size(star_shape); i++) {
-        vector_t *vec = (vector_t *)list_get(star_shape, i);
-        double y = vec->y;
-        if (y <= MIN.y) {
-            if (!coll_y) {
-                body_set_centroid(star, vec_add(body_get_centroid(star), (vector_t) {0.0, -(y - MIN.y)}));
-                vector_t currvel = body_get_velocity(star);
-                currvel.y = (double) body_get_elasticity(star) * -currvel.y;
-                body_set_velocity(star, currvel);
-                coll_y = true;
-            }
-        }
+void hit_wall(shape_cache_t *shapes, body_t *star) {
+    double y = shape_cache_view(shapes, star).bounds.min.y;
+    if (y <= MIN.y) {
+        body_set_centroid(star, vec_add(body_get_centroid(star), (vector_t) {0.0, -(y - MIN.y)}));
+        vector_t currvel = body_get_velocity(star);
+        currvel.y = (double) body_get_elasticity(star) * -currvel.y;
+        body_set_velocity(star, currvel);
     }
-
-    list_free(star_shape);
 }
 
-bool exited_right_wall(body_t *star) {
-    list_t *star_shape = body_get_shape(star);
-
-    for (int i = 0; i < list_size(star_shape); i++) {
-        vector_t *vec = (vector_t *) list_get(star_shape, i);
-        double x = vec->x;
-        if (x <= MAX.x) {
-            list_free(star_shape);
-            return false;
-        }
-    }
-    list_free(star_shape);
-    return true;
+bool exited_right_wall(shape_cache_t *shapes, body_t *star) {
+    return shape_cache_view(shapes, star).bounds.min.x > MAX.x;
 }
 
-void update_all_stars(scene_t *scene, double dt) {
+void update_all_stars(scene_t *scene, shape_cache_t *shapes, double dt) {
     scene_tick(scene, dt);
 
     for (size_t i = 0; i < scene_bodies(scene); i++) {
         body_t *star = scene_get_body(scene, i);
         body_set_velocity(star, vec_add(body_get_velocity(star), (vector_t) {0.0, -ACC * dt}));
-        if (exited_right_wall(star)) {
-            scene_remove_body(scene, i);
+        if (exited_right_wall(shapes, star)) {
+            body_remove(star);
         }
         else {
-            hit_wall(star);
+            hit_wall(shapes, star);
         }
     }
 }
@@ -121,6 +98,7 @@ int main(){
     sdl_init(MIN, MAX);
 
     scene_t *scene = scene_init();
+    shape_cache_t *shapes = create_shape_cache(scene);
     
     double run_time = 0;
     size_t count = 0;
@@ -133,7 +111,7 @@ int main(){
             count = make_random_star(scene, count);
         }
         
-        update_all_stars(scene, dt);
+        update_all_stars(scene, shapes, dt);
 
         sdl_render_scene(scene);
     }
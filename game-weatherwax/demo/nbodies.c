@@ -1,8 +1,10 @@
+#include <SDL2/SDL.h>
 #include "scene.h"
 #include "sdl_wrapper.h"
 #include <stdlib.h>
 #include "shape.h"
 #include "forces.h"
+#include "gravity_field.h"
 #include "rand_utils.h"
 
 
@@ -20,6 +22,7 @@ const double SCALE = 2.0;
 const double MASS_MIN = 1.0;
 const double MASS_MAX = 5.0;
 const double G = 10000.0;
+const double THETA = 0.5;
 
 
 scene_t *make_bodies_scene() {
@@ -45,10 +48,10 @@ scene_t *make_bodies_scene() {
 }
 
 void apply_gravity(scene_t *scene) {
+    gravity_field_t *field = create_gravity_field(scene, G, THETA);
+    gravity_field_set_threads(field, SDL_GetCPUCount());
     for (size_t i = 0; i < scene_bodies(scene); i++) {
-        for (size_t j = 0; j < i; j++) {
-            create_newtonian_gravity(scene, G, scene_get_body(scene, i), scene_get_body(scene, j));
-        }
+        gravity_field_add_body(field, scene_get_body(scene, i));
     }
 }
 
@@ -4,11 +4,13 @@
 #include <stdlib.h>
 #include "polygon.h"
 #include "sdl_wrapper.h"
+#include "batch_render.h"
 #include "list.h"
 #include "body.h"
 #include "shape.h"
 #include "scene.h"
 #include "rand_utils.h"
+#include "shape_cache.h"
 
 vector_t WINDOW_MIN = {0.0, 0.0};
 vector_t WINDOW = {1000.0, 500.0};
@@ -73,16 +75,14 @@ void make_ball(scene_t *scene, int circ_count) {
     }
 }
 
-void pacman_eat_balls(scene_t *scene){
-    body_t *pacman = scene_get_body(scene, 0);
+void pacman_eat_balls(scene_t *scene, shape_cache_t *shapes){
+    shape_view_t man = shape_cache_view(shapes, scene_get_body(scene, 0));
     for (size_t i = 1; i < scene_bodies(scene); i++){
-        list_t *man = body_get_shape(pacman);
-        list_t *ball = body_get_shape(scene_get_body(scene, i));
-        if(polygon_overlap(man, ball)){
-            scene_remove_body(scene, i);
+        body_t *body = scene_get_body(scene, i);
+        shape_view_t ball = shape_cache_view(shapes, body);
+        if(shape_view_overlap(&man, &ball)){
+            body_remove(body);
         }
-        list_free(man);
-        list_free(ball);
     }
 }
 
@@ -182,6 +182,8 @@ int main(){
     sdl_init(WINDOW_MIN, WINDOW);
 
     scene_t *scene = scene_init();
+    shape_cache_t *shapes = create_shape_cache(scene);
+    batch_render_t *batch = batch_render_init();
     double time = 0;
 
     make_pacman(scene);
@@ -192,8 +194,8 @@ int main(){
         double dt = time_since_last_tick();
         collisions(scene);
         scene_tick(scene, dt);
-        pacman_eat_balls(scene);
-        sdl_render_scene(scene);
+        pacman_eat_balls(scene, shapes);
+        batch_render_scene(batch, scene, shapes);
         time += dt;
         if (time > 1.5) {
             make_ball(scene, CIRC_NUM / 6);
@@ -201,6 +203,7 @@ int main(){
         }
     }
 
+    batch_render_free(batch);
     scene_free(scene);
     return 0;
 }
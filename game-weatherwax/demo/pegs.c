@@ -2,9 +2,12 @@
 #include <stdio.h>
 #include <math.h>
 #include <time.h>
+#include "broad_phase.h"
 #include "forces.h"
 #include "polygon.h"
+#include "rng.h"
 #include "scene.h"
+#include "batch_render.h"
 #include "sdl_wrapper.h"
 
 #define CIRCLE_POINTS 40
@@ -28,6 +31,12 @@
 #define START_VELOCITY ((vector_t) {.x = 0.0, .y = -8.0})
 
 #define BALL_MASS 2.0
+#define CELL_SIZE (4 * BALL_RADIUS)
+
+// Collision categories, so each new body is set up in O(1)
+#define BALL_CATEGORY (1u << 0)
+#define FROZEN_CATEGORY (1u << 1)
+#define WALL_CATEGORY (1u << 2)
 
 #define BALL_COLOR ((rgb_color_t) {1, 0, 0})
 #define PEG_COLOR ((rgb_color_t) {0, 1, 0})
@@ -45,9 +54,12 @@ typedef enum {
     GRAVITY
 } body_type2_t;
 
+// Seeded in main(); only this demo draws from it
+rng_t rng;
+
 /** Generates a random number between 0 and 1 */
 double rand_double(void) {
-    return (double) rand() / RAND_MAX;
+    return rng_double(&rng);
 }
 
 /** Constructs a rectangle with the given dimensions centered at (0, 0) */
@@ -94,7 +106,7 @@ vector_t get_peg_center(size_t row, size_t col) {
 }
 
 /** Creates an Earth-like mass to accelerate the balls */
-void add_gravity_body(scene_t *scene) {
+body_t *add_gravity_body(scene_t *scene) {
     // Will be offscreen, so shape is irrelevant
     list_t *gravity_ball = rect_init(1, 1);
     body_t *body = body_init_with_info(
@@ -108,6 +120,7 @@ void add_gravity_body(scene_t *scene) {
     vector_t gravity_center = {.x = MAX.x / 2, .y = -R};
     body_set_centroid(body, gravity_center);
     scene_add_body(scene, body);
+    return body;
 }
 
 /** Creates a ball with the given starting position and velocity */
@@ -135,55 +148,33 @@ void freeze(body_t *ball, body_t *target, vector_t axis, void *aux) {
     body_remove(ball);
     body_t *frozen = get_ball(body_get_centroid(ball), VEC_ZERO);
     *((body_type2_t *) body_get_info(frozen)) = FROZEN;
-    scene_t *scene = aux;
+    broad_phase_t *broad_phase = aux;
+    scene_t *scene = broad_phase_get_scene(broad_phase);
     scene_add_body(scene, frozen);
 
     // Make other falling bodies freeze when they collide with this body
-    size_t body_count = scene_bodies(scene);
-    for (size_t i = 0; i < body_count; i++) {
-        body_t *body = scene_get_body(scene, i);
-        if (body_get_type(body) == BALL) {
-            create_collision(scene, body, frozen, freeze, scene, NULL);
-        }
-    }
+    broad_phase_set_category(broad_phase, frozen, FROZEN_CATEGORY, ALL_CATEGORIES);
 }
 
 /** Adds a ball to the scene */
-void add_ball(scene_t *scene) {
+void add_ball(scene_t *scene, broad_phase_t *broad_phase, body_t *gravity) {
     // Add the ball to the scene.
     vector_t ball_center = {
         .x = MAX.x / 2 + (rand_double() - 0.5) * DELTA_X,
         .y = DROP_Y
     };
     body_t *ball = get_ball(ball_center, START_VELOCITY);
-    size_t body_count = scene_bodies(scene);
     scene_add_body(scene, ball);
 
-    // Add force creators with other bodies
-    for (size_t i = 0; i < body_count; i++) {
-        body_t *body = scene_get_body(scene, i);
-        switch (body_get_type(body)) {
-            case BALL:
-                // Bounce off other balls
-                create_physics_collision(scene, BALL_ELASTICITY, ball, body);
-                break;
-            case WALL:
-                // Bounce off walls and pegs
-                create_physics_collision(scene, PEG_ELASTICITY, ball, body);
-                break;
-            case FROZEN:
-                // Freeze when hitting the ground or frozen balls
-                create_collision(scene, ball, body, freeze, scene, NULL);
-                break;
-            case GRAVITY:
-                // Simulate earth's gravity acting on the ball
-                create_newtonian_gravity(scene, G, body, ball);
-        }
-    }
+    // Bounce off balls, walls, and pegs, and freeze on frozen bodies,
+    // through the rules added in main
+    broad_phase_set_category(broad_phase, ball, BALL_CATEGORY, ALL_CATEGORIES);
+    // Simulate earth's gravity acting on the ball
+    create_newtonian_gravity(scene, G, gravity, ball);
 }
 
 /** Adds the pegs to the scene */
-void add_pegs(scene_t *scene) {
+void add_pegs(scene_t *scene, broad_phase_t *broad_phase) {
     // Add N_ROWS and N_COLS of pegs.
     for (size_t i = 1; i <= N_ROWS; i++) {
         for (size_t j = 0; j <= i; j++) {
@@ -196,12 +187,13 @@ void add_pegs(scene_t *scene) {
             );
             body_set_centroid(body, get_peg_center(i, j));
             scene_add_body(scene, body);
+            broad_phase_set_category(broad_phase, body, WALL_CATEGORY, ALL_CATEGORIES);
         }
     }
 }
 
 /** Adds the walls to the scene */
-void add_walls(scene_t *scene) {
+void add_walls(scene_t *scene, broad_phase_t *broad_phase) {
     // Add walls
     list_t *rect = rect_init(WALL_LENGTH, WALL_WIDTH);
     polygon_translate(rect, (vector_t) {.x = WALL_LENGTH / 2, .y = 0.0});
@@ -213,32 +205,40 @@ void add_walls(scene_t *scene) {
         WALL
     );
     scene_add_body(scene, body);
+    broad_phase_set_category(broad_phase, body, WALL_CATEGORY, ALL_CATEGORIES);
 
     rect = rect_init(WALL_LENGTH, WALL_WIDTH);
     polygon_translate(rect, (vector_t) {.x = MAX.x - WALL_LENGTH / 2, .y = 0.0});
     polygon_rotate(rect, -WALL_ANGLE, (vector_t) {.x = MAX.x, .y = 0.0});
     body = body_init_with_info(rect, INFINITY, WALL_COLOR, WALL);
     scene_add_body(scene, body);
+    broad_phase_set_category(broad_phase, body, WALL_CATEGORY, ALL_CATEGORIES);
 
     // Ground is special; it freezes balls when they touch it
     rect = rect_init(MAX.x, WALL_WIDTH);
     body = body_init_with_info(rect, INFINITY, WALL_COLOR, FROZEN);
     body_set_centroid(body, (vector_t) {.x = MAX.x / 2, .y = WALL_WIDTH / 2});
     scene_add_body(scene, body);
+    broad_phase_set_category(broad_phase, body, FROZEN_CATEGORY, ALL_CATEGORIES);
 }
 
 int main(void) {
     // Initialize the random number generator
-    srand(time(NULL));
+    rng = rng_init((uint64_t) time(NULL));
 
     // Initialize scene
     sdl_init(VEC_ZERO, MAX);
     scene_t *scene = scene_init();
+    broad_phase_t *broad_phase = create_broad_phase(scene, CELL_SIZE);
+    broad_phase_add_physics_rule(broad_phase, BALL_ELASTICITY, BALL_CATEGORY, BALL_CATEGORY);
+    broad_phase_add_physics_rule(broad_phase, PEG_ELASTICITY, BALL_CATEGORY, WALL_CATEGORY);
+    broad_phase_add_rule(broad_phase, BALL_CATEGORY, FROZEN_CATEGORY, freeze, broad_phase, NULL);
 
     // Add elements to the scene
-    add_gravity_body(scene);
-    add_pegs(scene);
-    add_walls(scene);
+    body_t *gravity = add_gravity_body(scene);
+    add_pegs(scene, broad_phase);
+    add_walls(scene, broad_phase);
+    batch_render_t *batch = batch_render_init();
 
     // Repeatedly render scene
     double time_since_drop = INFINITY;
@@ -248,14 +248,15 @@ int main(void) {
         // Add a new ball every DROP_INTERVAL seconds
         time_since_drop += dt;
         if (time_since_drop > DROP_INTERVAL) {
-            add_ball(scene);
+            add_ball(scene, broad_phase, gravity);
             time_since_drop = 0.0;
         }
 
         scene_tick(scene, dt);
-        sdl_render_scene(scene);
+        batch_render_scene(batch, scene, broad_phase_get_shapes(broad_phase));
     }
 
     // Clean up scene
+    batch_render_free(batch);
     scene_free(scene);
 }
\ No newline at end of file
@@ -2,6 +2,7 @@
 #include <vector.h>
 #include <math.h>
 #include <stdlib.h>
+#include <time.h>
 #include <SDL2/SDL.h>
 #include <SDL2/SDL2_gfxPrimitives.h>
 #include "polygon.h"
@@ -13,6 +14,10 @@
 #include "forces.h" 
 #include "collision.h"
 #include "rand_utils.h"
+#include "body_pool.h"
+#include "broad_phase.h"
+#include "type_index.h"
+#include "input_log.h"
 
 const vector_t WINDOW_MIN = {0.0, 0.0};
 const vector_t WINDOW = {1000.0, 500.0};
@@ -57,6 +62,14 @@ const double STAR_MAX = 30.0;
 const double STAR_VEL = 1000.0;
 const double EXIT_SPEED = 60.0;
 
+// collision categories, so shots are matched by the broad phase instead of pair by pair
+const uint32_t PLAYER_CATEGORY = 1 << 0;
+const uint32_t ATTACKER_CATEGORY = 1 << 1;
+const uint32_t DEFEND_SHOT_CATEGORY = 1 << 2;
+const uint32_t ATTACK_SHOT_CATEGORY = 1 << 3;
+// about the size of an attacker
+const double CELL_SIZE = 60.0;
+
 typedef enum {
     PLAYER,
     ATTACKER,
@@ -64,10 +77,20 @@ typedef enum {
     STAR
 } body_type1_t;
 
+// shots and stars are reused rather than freed once they leave the screen
+body_pool_t *defend_shots = NULL;
+body_pool_t *attack_shots = NULL;
+body_pool_t *galaxy_stars = NULL;
+// the scene's bodies by type, so per-frame logic only visits the bodies it needs
+type_index_t *types = NULL;
+// checks shots against the bodies they can hit; parked shots are far from everything, so they cost nothing
+broad_phase_t *broad_phase = NULL;
+
 body_t *make_player(scene_t *scene) {
     list_t *player_points = make_shape_ellipse(2*M_PI, PLAYER_X_RAD, PLAYER_Y_RAD, PLAYER_START, N);
     body_t *player = body_init_with_info(player_points, MASS, PLAYER_COLOR, PLAYER);
     scene_add_body(scene, player);
+    broad_phase_set_category(broad_phase, player, PLAYER_CATEGORY, ALL_CATEGORIES);
     return player;
 }
 
@@ -79,6 +102,7 @@ body_t *make_one_attacker(scene_t *scene, vector_t start){
     body_set_velocity(attacker, ATTACKER_VELOCITY);
     scene_add_body(scene, attacker); 
     create_destructive_collision(scene, attacker, scene_get_body(scene, 0));
+    broad_phase_set_category(broad_phase, attacker, ATTACKER_CATEGORY, ALL_CATEGORIES);
     return attacker;
 }
 
@@ -96,49 +120,55 @@ size_t make_attackers(scene_t *scene, size_t count){
 
 // checks if bodies hit walls
 void wall(scene_t *scene) {
-    for (size_t i = 0; i < scene_bodies(scene); i++) {
-        body_t *body = scene_get_body(scene, i);
-        body_type1_t type = body_get_type(body);
+    size_t players = type_index_bodies(types, PLAYER);
+    for (size_t i = 0; i < players; i++) {
+        body_t *body = type_index_get_body(types, PLAYER, i);
         vector_t centroid = body_get_centroid(body);
-        if (type == PLAYER) {
-            if (centroid.x + PLAYER_X_RAD > WINDOW.x) {
-                body_set_velocity(body, VEC_ZERO);
-                body_set_centroid(body, (vector_t) {WINDOW.x - PLAYER_X_RAD, PLAYER_START.y});
-            }
-            if (centroid.x - PLAYER_X_RAD < WINDOW_MIN.x) {
-                body_set_velocity(body, VEC_ZERO);
-                body_set_centroid(body, (vector_t) {WINDOW_MIN.x + PLAYER_X_RAD, PLAYER_START.y});
-            }
-            if (centroid.y - PLAYER_Y_RAD > WINDOW.y) {
-                body_set_velocity(body, VEC_ZERO);
-            }
+        if (centroid.x + PLAYER_X_RAD > WINDOW.x) {
+            body_set_velocity(body, VEC_ZERO);
+            body_set_centroid(body, (vector_t) {WINDOW.x - PLAYER_X_RAD, PLAYER_START.y});
         }
-        else if (type == ATTACKER) {
-            vector_t velo = body_get_velocity(body);
-            if (centroid.x > WINDOW.x) {
-                body_set_velocity(body, vec_negate(velo));
-                body_set_centroid(body, vec_subtract(vec_add(centroid, CHANGE), MICRO_SHIFT));
-            }
-            if (centroid.x < WINDOW_MIN.x) {
-                body_set_velocity(body, vec_negate(velo));
-                body_set_centroid(body, vec_add(vec_add(centroid, CHANGE), MICRO_SHIFT));
-            }
-            if (centroid.y + ATTACKER_RADIUS < WINDOW_MIN.y) {
-                body_remove(body);
-            }
+        if (centroid.x - PLAYER_X_RAD < WINDOW_MIN.x) {
+            body_set_velocity(body, VEC_ZERO);
+            body_set_centroid(body, (vector_t) {WINDOW_MIN.x + PLAYER_X_RAD, PLAYER_START.y});
         }
-        else if (type == SHOT1) {
-            if (centroid.y - SHOT_Y_RAD > WINDOW.y) {
-                body_remove(body);
-            }
-            if (centroid.y + SHOT_Y_RAD < WINDOW_MIN.y) {
-                body_remove(body);
-            }
+        if (centroid.y - PLAYER_Y_RAD > WINDOW.y) {
+            body_set_velocity(body, VEC_ZERO);
         }
-        else if (type == STAR) {
-            if (centroid.y + STAR_MAX < WINDOW_MIN.y) {
-                body_remove(body);
-            }
+    }
+    size_t attackers = type_index_bodies(types, ATTACKER);
+    for (size_t i = 0; i < attackers; i++) {
+        body_t *body = type_index_get_body(types, ATTACKER, i);
+        vector_t centroid = body_get_centroid(body);
+        vector_t velo = body_get_velocity(body);
+        if (centroid.x > WINDOW.x) {
+            body_set_velocity(body, vec_negate(velo));
+            body_set_centroid(body, vec_subtract(vec_add(centroid, CHANGE), MICRO_SHIFT));
+        }
+        if (centroid.x < WINDOW_MIN.x) {
+            body_set_velocity(body, vec_negate(velo));
+            body_set_centroid(body, vec_add(vec_add(centroid, CHANGE), MICRO_SHIFT));
+        }
+        if (centroid.y + ATTACKER_RADIUS < WINDOW_MIN.y) {
+            body_remove(body);
+        }
+    }
+    size_t shots = type_index_bodies(types, SHOT1);
+    for (size_t i = 0; i < shots; i++) {
+        body_t *body = type_index_get_body(types, SHOT1, i);
+        vector_t centroid = body_get_centroid(body);
+        if (centroid.y - SHOT_Y_RAD > WINDOW.y) {
+            body_pool_release(defend_shots, body);
+        }
+        if (centroid.y + SHOT_Y_RAD < WINDOW_MIN.y) {
+            body_pool_release(attack_shots, body);
+        }
+    }
+    size_t stars = type_index_bodies(types, STAR);
+    for (size_t i = 0; i < stars; i++) {
+        body_t *body = type_index_get_body(types, STAR, i);
+        if (body_get_centroid(body).y + STAR_MAX < WINDOW_MIN.y) {
+            body_pool_release(galaxy_stars, body);
         }
     }
 }
@@ -155,24 +185,50 @@ void wall(scene_t *scene) {
 //     return shot;
 // }
 
-void make_galaxy_star(scene_t *scene) {
+// a shot destroys what it hits and goes back to its pool
+void shot_hit(body_t *shot, body_t *target, vector_t axis, void *aux) {
+    body_remove(target);
+    body_pool_release(aux, shot);
+}
+
+// makes a galaxy star for the pool; each keeps its random size when reused
+body_t *make_pooled_star(body_pool_t *pool, void *aux) {
     double radius = rand_range(STAR_MIN, STAR_MAX);
-    list_t *galaxy_star_points = make_shape_star((vector_t) {rand_range(WINDOW_MIN.x, WINDOW.x), WINDOW.y + STAR_SHIFT}, 4, radius, radius/4);
+    list_t *galaxy_star_points = make_shape_star(VEC_ZERO, 4, radius, radius/4);
     body_t *galaxy_star = body_init_with_info(galaxy_star_points, MASS, ATTACKER_COLOR, STAR);
-    body_set_velocity(galaxy_star, (vector_t) {0.0, -STAR_VEL});
-    scene_add_body(scene, galaxy_star);
+    scene_add_body(body_pool_get_scene(pool), galaxy_star);
+    return galaxy_star;
+}
+
+// makes an attacker's shot for the pool, able to hit the player
+body_t *make_attack_shot(body_pool_t *pool, void *aux) {
+    scene_t *scene = body_pool_get_scene(pool);
+    body_t *shot = make_shot(scene, VEC_ZERO, SHOT_Y_RAD, SMALL_MASS, ATTACK_COLOR, ATTACK_SHOT_VELOCITY);
+    broad_phase_set_category(broad_phase, shot, ATTACK_SHOT_CATEGORY, PLAYER_CATEGORY);
+    return shot;
+}
+
+// makes a player's shot for the pool, able to hit every attacker
+body_t *make_defend_shot(body_pool_t *pool, void *aux) {
+    scene_t *scene = body_pool_get_scene(pool);
+    body_t *shot = make_shot(scene, VEC_ZERO, SHOT_Y_RAD, SMALL_MASS, DEFEND_COLOR, DEFEND_SHOT_VELOCITY);
+    broad_phase_set_category(broad_phase, shot, DEFEND_SHOT_CATEGORY, ATTACKER_CATEGORY);
+    return shot;
+}
+
+void make_galaxy_star(scene_t *scene) {
+    vector_t start = {rand_range(WINDOW_MIN.x, WINDOW.x), WINDOW.y + STAR_SHIFT};
+    body_pool_acquire(galaxy_stars, start, (vector_t) {0.0, -STAR_VEL});
 }
 
 // makes a random attacker shoot a bullet
 void attack(scene_t *scene) {
-    for (size_t i = 0; i < scene_bodies(scene); i++) {
-        body_t *body = scene_get_body(scene, i);
-        if (body_get_type(body) == ATTACKER) {
-            if ((double) rand()/(double) RAND_MAX < FIRE_PROB) {
-                vector_t location = body_get_centroid(body);
-                body_t *shot = make_shot(scene, location, SHOT_Y_RAD, SMALL_MASS, ATTACK_COLOR, ATTACK_SHOT_VELOCITY);
-                create_destructive_collision(scene, scene_get_body(scene, 0), shot);
-            }
+    size_t count = type_index_bodies(types, ATTACKER);
+    for (size_t i = 0; i < count; i++) {
+        body_t *body = type_index_get_body(types, ATTACKER, i);
+        if ((double) rand()/(double) RAND_MAX < FIRE_PROB) {
+            vector_t location = body_get_centroid(body);
+            body_pool_acquire(attack_shots, location, ATTACK_SHOT_VELOCITY);
         }
     }
 }
@@ -180,13 +236,7 @@ void attack(scene_t *scene) {
 // shoots a bullet from player 
 void defend(scene_t *scene, size_t attacker_count) {
     vector_t location = body_get_centroid(scene_get_body(scene, 0));
-    body_t *shot = make_shot(scene, location, SHOT_Y_RAD, SMALL_MASS, DEFEND_COLOR, DEFEND_SHOT_VELOCITY);
-    for (size_t i = 0; i < scene_bodies(scene); i++) {
-        body_t *body = scene_get_body(scene, i);
-        if (body_get_type(body) == ATTACKER) {
-            create_destructive_collision(scene, body, shot);
-        }
-    }
+    body_pool_acquire(defend_shots, location, DEFEND_SHOT_VELOCITY);
 }
 
 void on_key(scene_t *scene, char key, key_event_type_t type, double held_time) {
@@ -229,20 +279,66 @@ void on_key(scene_t *scene, char key, key_event_type_t type, double held_time) {
     }
 }
 
-int main() {
+// the session being recorded with --record or replayed with --replay, or NULL
+input_log_t *input_log = NULL;
+
+bool replaying(void) {
+    return input_log != NULL && input_log_is_replay(input_log);
+}
+
+// passes the player's keys to on_key, logging them first when recording
+void record_key(scene_t *scene, char key, key_event_type_t type, double held_time) {
+    if (input_log != NULL) {
+        input_log_key(input_log, key, type, held_time);
+    }
+    on_key(scene, key, type, held_time);
+}
+
+// handles the next frame's keys, from the player or the replayed log; returns whether the game is over
+bool frame_done(scene_t *scene) {
+    if (replaying()) {
+        return !input_log_replay_keys(input_log, scene, on_key);
+    }
+    return sdl_is_done(scene);
+}
+
+// the time to step the next frame by, logged when recording
+double frame_dt(void) {
+    if (replaying()) {
+        return input_log_replay_tick(input_log);
+    }
+    double dt = time_since_last_tick();
+    if (input_log != NULL) {
+        input_log_tick(input_log, dt);
+    }
+    return dt;
+}
+
+// "--record <file>" saves the session and "--replay <file>" reruns it without drawing
+int main(int argc, char *argv[]) {
+    input_log = input_log_from_args(argc, argv, (uint64_t) time(NULL));
     sdl_init(WINDOW_MIN, WINDOW);
+    srand(input_log != NULL ? input_log_seed(input_log) : time(NULL));
 
     scene_t *scene = scene_init();
+    types = create_type_index(scene);
+    broad_phase = create_broad_phase(scene, CELL_SIZE);
     double time = 0;
 
     body_t *player = make_player(scene);
     vector_t player_location = PLAYER_START;
     size_t attacker_count = make_attackers(scene, NUM_ATTACKERS); 
+    defend_shots = create_body_pool(scene, make_defend_shot, NULL, NULL);
+    attack_shots = create_body_pool(scene, make_attack_shot, NULL, NULL);
+    galaxy_stars = create_body_pool(scene, make_pooled_star, NULL, NULL);
+    // a shot goes back to its own pool when it hits
+    broad_phase_add_rule(broad_phase, DEFEND_SHOT_CATEGORY, ATTACKER_CATEGORY, shot_hit, defend_shots, NULL);
+    broad_phase_add_rule(broad_phase, ATTACK_SHOT_CATEGORY, PLAYER_CATEGORY, shot_hit, attack_shots, NULL);
 
-    sdl_on_key(on_key);
+    sdl_on_key(record_key);
 
-    while (!sdl_is_done(scene)){
-        double dt = time_since_last_tick();
+    while (!frame_done(scene)){
+        double dt = frame_dt();
         if (body_get_type(scene_get_body(scene, 0)) == PLAYER) {
             wall(scene);
             time += dt;
@@ -279,9 +375,17 @@ int main() {
             body_t *explosion = body_init(explosion_star, MASS, PLAYER_COLOR);
             scene_add_body(scene, explosion);
         }
-        sdl_render_scene(scene);
+        if (!replaying()) {
+            sdl_render_scene(scene);
+        }
     }
 
+    if (input_log != NULL) {
+        input_log_end(input_log, scene);
+    }
     scene_free(scene);
+    if (input_log != NULL) {
+        input_log_free(input_log);
+    }
     return 0;
 }
\ No newline at end of file
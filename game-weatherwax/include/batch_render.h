@@ -0,0 +1,81 @@
+#ifndef __BATCH_RENDER_H__
+#define __BATCH_RENDER_H__
+
+#include "body.h"
+#include "fixed_step.h"
+#include "scene.h"
+#include "shape_cache.h"
+#include "vector.h"
+
+/**
+ * A renderer that draws a whole scene with as few draw calls as it can.
+ * sdl_render_scene() converts and fills every body's polygon separately;
+ * this instead triangulates every visible body into one vertex buffer,
+ * reused from frame to frame, and submits it with SDL_RenderGeometry().
+ * Bodies entirely outside the window are skipped.
+ *
+ * Each polygon is drawn as a fan around its centroid, which is correct for
+ * convex shapes and for shapes like pacman's that can be seen whole from it.
+ * Bodies with a visible skin are drawn as their active costume instead,
+ * like sdl_draw_sprite(), as textured quads batched the same way: sprites in
+ * a row with the same texture share one draw call. What is queued is only
+ * drawn early when the texture changes or a sprite would cover a polygon
+ * queued before it, so bodies still overlap in scene order.
+ * SDL_RenderGeometry() needs SDL 2.0.18 or later.
+ *
+ * This draws through sdl_wrapper.c's renderer, so it is only linked into demos.
+ */
+typedef struct batch_render batch_render_t;
+
+/** How to look at a scene: what the renderer shows without moving any body */
+typedef struct render_view {
+    // The world point drawn where the scene's origin would be, e.g. camera_get_position()
+    vector_t camera;
+    // A body to draw over all the others, like the player, or NULL
+    body_t *top;
+    // Where to draw each body, in scene order, e.g. from fixed_step_interpolate(),
+    // or NULL to draw every body where it is
+    const draw_pose_t *poses;
+    size_t pose_count;
+} render_view_t;
+
+/**
+ * Allocates a batch renderer. Call this after sdl_init().
+ *
+ * @return the new renderer
+ */
+batch_render_t *batch_render_init(void);
+
+/**
+ * Releases the memory allocated for a batch renderer.
+ *
+ * @param batch the renderer
+ */
+void batch_render_free(batch_render_t *batch);
+
+/**
+ * Clears the window, draws every visible body of a scene and shows the result.
+ * Replaces sdl_render_scene() in the main loop.
+ *
+ * @param batch the renderer
+ * @param scene the scene
+ * @param shapes the scene's shape cache, so shapes are not copied every frame
+ */
+void batch_render_scene(batch_render_t *batch, scene_t *scene, shape_cache_t *shapes);
+
+/**
+ * Same as batch_render_scene(), but looks at the scene through a view.
+ * The view only changes where things are drawn: no body is moved, and the
+ * shape cache only gains copies of shapes it had not seen, so drawing never
+ * affects how the scene plays out.
+ * Bodies outside the window are skipped.
+ *
+ * @param batch the renderer
+ * @param scene the scene
+ * @param shapes the scene's shape cache
+ * @param view how to look at the scene, or NULL for the plain view
+ */
+void batch_render_scene_view(batch_render_t *batch, scene_t *scene, shape_cache_t *shapes,
+    const render_view_t *view);
+
+#endif // #ifndef __BATCH_RENDER_H__
@@ -0,0 +1,93 @@
+#ifndef __BODY_POOL_H__
+#define __BODY_POOL_H__
+
+#include <stddef.h>
+#include "body.h"
+#include "scene.h"
+
+/**
+ * A pool of interchangeable bodies, such as shots, that are reused
+ * instead of being freed and reallocated every time one is fired.
+ *
+ * Pooled bodies stay in the scene for their whole lifetime.
+ * A released body is parked: it is hidden, stopped,
+ * and moved far outside the play area until it is acquired again.
+ * body_visible() tells parked bodies apart from bodies in use.
+ *
+ * Because a pooled body is never freed, force creators registered on it
+ * persist across uses and only have to be set up once.
+ * They also keep running while it is parked, so a pairwise collision from
+ * create_collision() is still checked every tick. Give pooled bodies a
+ * broad-phase category instead (see broad_phase_add_rule()): parked bodies
+ * are far from every cell in play, so the broad phase never pairs them.
+ */
+typedef struct body_pool body_pool_t;
+
+/**
+ * Builds a new body for a pool when every pooled body is in use.
+ * It must add the body to the pool's scene.
+ *
+ * @param pool the pool the body will belong to
+ * @param aux the auxiliary value passed to create_body_pool()
+ * @return the new body
+ */
+typedef body_t *(*body_maker_t)(body_pool_t *pool, void *aux);
+
+/**
+ * Allocates a body pool for a scene.
+ * The scene owns it; it is freed along with the scene.
+ *
+ * @param scene the scene the pooled bodies live in
+ * @param maker builds a body whenever the pool runs out
+ * @param aux passed to maker
+ * @param freer if non-NULL, a function to call to free aux
+ * @return the new pool
+ */
+body_pool_t *create_body_pool(scene_t *scene, body_maker_t maker, void *aux, free_func_t freer);
+
+/**
+ * Gets the scene a pool's bodies live in.
+ *
+ * @param pool the pool
+ * @return the scene
+ */
+scene_t *body_pool_get_scene(body_pool_t *pool);
+
+/**
+ * Takes a parked body out of the pool, or makes a new one if none are parked.
+ * The body is shown and placed at the given position with the given velocity.
+ *
+ * @param pool the pool
+ * @param centroid the body's new centroid
+ * @param velocity the body's new velocity
+ * @return the body
+ */
+body_t *body_pool_acquire(body_pool_t *pool, vector_t centroid, vector_t velocity);
+
+/**
+ * Parks a body acquired from a pool so it can be reused.
+ * Releasing a body that is already parked does nothing.
+ *
+ * @param pool the pool the body was acquired from
+ * @param body the body
+ */
+void body_pool_release(body_pool_t *pool, body_t *body);
+
+/**
+ * Gets the number of bodies that belong to a pool, parked or not.
+ *
+ * @param pool the pool
+ * @return the number of pooled bodies
+ */
+size_t body_pool_size(body_pool_t *pool);
+
+/**
+ * Gets a body that belongs to a pool, parked or not.
+ *
+ * @param pool the pool
+ * @param index the index of the body, less than body_pool_size()
+ * @return the body
+ */
+body_t *body_pool_get(body_pool_t *pool, size_t index);
+
+#endif // #ifndef __BODY_POOL_H__
@@ -0,0 +1,97 @@
+#ifndef __BODY_TABLE_H__
+#define __BODY_TABLE_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "body.h"
+#include "scene.h"
+
+/**
+ * A stable reference to a body in a body table.
+ * Scene indices shift whenever an earlier body is removed, and a body pointer
+ * dangles once the scene frees the body. A handle does neither:
+ * after the body goes away, looking the handle up gives NULL,
+ * even if its slot has since been reused for another body.
+ */
+typedef struct body_handle {
+    uint32_t index;
+    uint32_t generation;
+} body_handle_t;
+
+/** A handle that never refers to a body */
+extern const body_handle_t NO_BODY_HANDLE;
+
+/**
+ * A table of handles to bodies in one scene.
+ * Bodies are also kept in a dense array, so the live bodies in the table
+ * can be looped over without skipping or revisiting any.
+ * When the scene drops a body, its entry is swapped with the last one
+ * and popped, so removal is O(1) however many bodies go at once.
+ *
+ * Handles are for code that holds on to bodies it does not hear about
+ * being removed, like a game's player sprite, the level stream and scene
+ * snapshots. Modules that keep per-body records, like the broad phase,
+ * the gravity and spring fields, the shape cache, the type index and body
+ * pools, still hold body pointers and drop them through body_watch.h when
+ * the scene frees the body, which is just as safe and skips the lookup.
+ */
+typedef struct body_table body_table_t;
+
+/**
+ * Allocates a body table for a scene.
+ * The scene owns it; it is freed along with the scene.
+ *
+ * @param scene the scene whose bodies will be added
+ * @return the new table
+ */
+body_table_t *create_body_table(scene_t *scene);
+
+/**
+ * Adds a body to a table and gets a handle to it.
+ * A body must be added to a table at most once.
+ *
+ * @param table the table
+ * @param body a body in the table's scene
+ * @return the body's handle
+ */
+body_handle_t body_table_add(body_table_t *table, body_t *body);
+
+/**
+ * Looks up the body a handle refers to.
+ *
+ * @param table the table the handle came from
+ * @param handle the handle
+ * @return the body, or NULL if it has been removed from the scene
+ */
+body_t *body_table_get(body_table_t *table, body_handle_t handle);
+
+/**
+ * Gets the number of bodies in a table that the scene has not yet dropped.
+ *
+ * @param table the table
+ * @return the number of bodies
+ */
+size_t body_table_size(body_table_t *table);
+
+/**
+ * Gets a body from a table's dense array.
+ * Entries are not in insertion order, and are reordered
+ * as the scene drops bodies, i.e. during scene_tick().
+ *
+ * @param table the table
+ * @param index the index of the body, less than body_table_size()
+ * @return the body
+ */
+body_t *body_table_body(body_table_t *table, size_t index);
+
+/**
+ * Checks whether two handles refer to the same body.
+ *
+ * @param a a handle
+ * @param b another handle
+ * @return whether the handles are equal
+ */
+bool body_handle_equal(body_handle_t a, body_handle_t b);
+
+#endif // #ifndef __BODY_TABLE_H__
@@ -0,0 +1,25 @@
+#ifndef __BODY_WATCH_H__
+#define __BODY_WATCH_H__
+
+#include "body.h"
+#include "list.h"
+#include "scene.h"
+
+/**
+ * Registers a callback that runs once the scene drops a body.
+ * The callback fires when scene_tick frees the removed body,
+ * or when the scene itself is freed, whichever comes first.
+ *
+ * This is a no-op force creator tied to the body, so it reuses the
+ * bookkeeping scene_tick already does for force creators of removed bodies.
+ * Modules that keep their own tables of body pointers use it to forget a
+ * body before the pointer dangles.
+ *
+ * @param scene the scene the body belongs to
+ * @param body the body to watch
+ * @param on_removed the function called with aux when the body goes away
+ * @param aux the value passed to on_removed
+ */
+void body_watch(scene_t *scene, body_t *body, free_func_t on_removed, void *aux);
+
+#endif // #ifndef __BODY_WATCH_H__
@@ -0,0 +1,242 @@
+#ifndef __BROAD_PHASE_H__
+#define __BROAD_PHASE_H__
+
+#include "body.h"
+#include "forces.h"
+#include "list.h"
+#include "scene.h"
+#include "shape_cache.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * A uniform-grid broad phase for collisions.
+ * Instead of one force creator per colliding pair, the scene gets a single
+ * force creator that buckets every tracked body's bounding box into grid
+ * cells each tick. Only pairs that share a cell reach find_collision.
+ *
+ * Collisions can be registered per pair, or by category: give bodies
+ * category bits and add one rule per pair of categories, and every pair of
+ * bodies matching a rule is handled as if it had been registered directly.
+ * A rule's pair is registered when the two bodies share a cell, and dropped
+ * once they no longer share one and are not touching.
+ *
+ * Bodies at rest are put to sleep: bodies with infinite mass that stop
+ * moving, and bodies that stay within a hundredth of a cell of one spot
+ * for 30 ticks. Sleep never changes a body's velocity. A sleeping body keeps
+ * its grid cells from when it fell asleep, padded by that hundredth of a cell,
+ * and is only checked against awake bodies, or in a tick it drifted in;
+ * two still sleeping bodies that are touching stay touching.
+ * Moving further than that from where it fell asleep wakes it up.
+ */
+typedef struct broad_phase broad_phase_t;
+
+/** A mask that lets a body collide with bodies in any category */
+extern const uint32_t ALL_CATEGORIES;
+
+/**
+ * Handlers for the stages of a contact between two bodies.
+ * The broad phase remembers which pairs are touching and their last contact
+ * axis, so each stage is reported once per tick at most.
+ * Any handler may be NULL.
+ */
+typedef struct contact_handlers {
+    /** Called on the first tick the bodies touch */
+    collision_handler_t begin;
+    /** Called on every later tick they are still touching */
+    collision_handler_t persist;
+    /**
+     * Called on the first tick they no longer touch, with the last contact axis.
+     * Not called if either body is removed from the scene.
+     */
+    collision_handler_t end;
+} contact_handlers_t;
+
+/**
+ * Allocates a broad phase and adds it to the scene as a force creator.
+ * The scene owns it; it is freed along with the scene.
+ *
+ * @param scene the scene whose collisions the broad phase will check
+ * @param cell_size the side length of a grid cell. Roughly the size of
+ * the typical moving body works best.
+ * @return the new broad phase
+ */
+broad_phase_t *create_broad_phase(scene_t *scene, double cell_size);
+
+/**
+ * Gets the scene a broad phase was created for.
+ *
+ * @param broad_phase the broad phase
+ * @return the scene passed to create_broad_phase
+ */
+scene_t *broad_phase_get_scene(broad_phase_t *broad_phase);
+
+/**
+ * Gets the shape cache the broad phase reads body shapes from,
+ * so other code working on the same scene can share it.
+ *
+ * @param broad_phase the broad phase
+ * @return the broad phase's shape cache, owned by the scene
+ */
+shape_cache_t *broad_phase_get_shapes(broad_phase_t *broad_phase);
+
+/**
+ * Same as create_collision, but the pair is only checked
+ * on ticks where the two bodies share a grid cell.
+ * The handler is called when the bodies start colliding.
+ * The registration is dropped when either body is removed from the scene.
+ *
+ * @param broad_phase the broad phase of the scene containing the bodies
+ * @param body1 the first body
+ * @param body2 the second body
+ * @param handler a function to call whenever the bodies collide
+ * @param aux an auxiliary value to pass to the handler
+ * @param freer if non-NULL, a function to call in order to free aux
+ */
+void broad_phase_add_collision(
+    broad_phase_t *broad_phase,
+    body_t *body1,
+    body_t *body2,
+    collision_handler_t handler,
+    void *aux,
+    free_func_t freer
+);
+
+/**
+ * Registers handlers for each stage of the contact between two bodies.
+ * The pair is only checked on ticks where the two bodies share a grid cell.
+ * The registration is dropped when either body is removed from the scene.
+ *
+ * @param broad_phase the broad phase of the scene containing the bodies
+ * @param body1 the first body
+ * @param body2 the second body
+ * @param handlers the functions to call as the bodies touch and separate
+ * @param aux an auxiliary value to pass to the handlers
+ * @param freer if non-NULL, a function to call in order to free aux
+ */
+void broad_phase_add_contact(
+    broad_phase_t *broad_phase,
+    body_t *body1,
+    body_t *body2,
+    contact_handlers_t handlers,
+    void *aux,
+    free_func_t freer
+);
+
+/**
+ * Same as create_physics_collision, but filtered by the broad phase.
+ * While the bodies stay overlapped after the bounce, they are also kept
+ * from moving further into each other, so resting bodies stay put.
+ *
+ * @param broad_phase the broad phase of the scene containing the bodies
+ * @param elasticity the "coefficient of restitution" of the collision
+ * @param body1 the first body
+ * @param body2 the second body
+ */
+void broad_phase_add_physics_collision(
+    broad_phase_t *broad_phase,
+    double elasticity,
+    body_t *body1,
+    body_t *body2
+);
+
+/**
+ * Same as create_destructive_collision, but filtered by the broad phase.
+ *
+ * @param broad_phase the broad phase of the scene containing the bodies
+ * @param body1 the first body
+ * @param body2 the second body
+ */
+void broad_phase_add_destructive_collision(
+    broad_phase_t *broad_phase,
+    body_t *body1,
+    body_t *body2
+);
+
+/**
+ * Marks a body as a bullet: fast enough to pass completely through
+ * another body between two ticks. A bullet's collisions are checked along
+ * the whole path it took since the last tick, not only where it ended up.
+ * On a hit, the bullet is moved back to the point of contact
+ * before the handler is called.
+ * Jumps of more than 16 cells in a single tick are treated as teleports
+ * and are not swept.
+ *
+ * @param broad_phase the broad phase of the scene containing the body
+ * @param body the body
+ * @param bullet whether the body is a bullet
+ */
+void broad_phase_set_bullet(broad_phase_t *broad_phase, body_t *body, bool bullet);
+
+/**
+ * Puts a body in collision categories for the broad phase's rules.
+ * Bodies start in no category, so no rule applies to them.
+ * Two bodies are only matched against the rules if each body's mask
+ * shares a bit with the other body's category.
+ *
+ * @param broad_phase the broad phase of the scene containing the body
+ * @param body the body
+ * @param category the categories the body is in, as bits
+ * @param mask the categories the body may collide with, e.g. ALL_CATEGORIES
+ */
+void broad_phase_set_category(broad_phase_t *broad_phase, body_t *body, uint32_t category, uint32_t mask);
+
+/**
+ * Adds a collision handler for every pair of bodies in two categories,
+ * including bodies categorized later. The handler gets the body in
+ * category1 first. Like broad_phase_add_collision, it is called
+ * when a pair starts colliding.
+ *
+ * @param broad_phase the broad phase
+ * @param category1 the categories of the handler's first body
+ * @param category2 the categories of the handler's second body
+ * @param handler a function to call whenever two such bodies collide
+ * @param aux an auxiliary value to pass to the handler
+ * @param freer if non-NULL, a function to call to free aux along with the broad phase
+ */
+void broad_phase_add_rule(
+    broad_phase_t *broad_phase,
+    uint32_t category1,
+    uint32_t category2,
+    collision_handler_t handler,
+    void *aux,
+    free_func_t freer
+);
+
+/**
+ * Same as broad_phase_add_contact, but for every pair of bodies in two
+ * categories, as in broad_phase_add_rule.
+ *
+ * @param broad_phase the broad phase
+ * @param category1 the categories of the handlers' first body
+ * @param category2 the categories of the handlers' second body
+ * @param handlers the functions to call as two such bodies touch and separate
+ * @param aux an auxiliary value to pass to the handlers
+ * @param freer if non-NULL, a function to call to free aux along with the broad phase
+ */
+void broad_phase_add_contact_rule(
+    broad_phase_t *broad_phase,
+    uint32_t category1,
+    uint32_t category2,
+    contact_handlers_t handlers,
+    void *aux,
+    free_func_t freer
+);
+
+/**
+ * Same as broad_phase_add_physics_collision, but for every pair of bodies
+ * in two categories.
+ *
+ * @param broad_phase the broad phase
+ * @param elasticity the "coefficient of restitution" of the collisions
+ * @param category1 the categories of one body
+ * @param category2 the categories of the other body
+ */
+void broad_phase_add_physics_rule(
+    broad_phase_t *broad_phase,
+    double elasticity,
+    uint32_t category1,
+    uint32_t category2
+);
+
+#endif // #ifndef __BROAD_PHASE_H__
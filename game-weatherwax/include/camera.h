@@ -0,0 +1,76 @@
+#ifndef __CAMERA_H__
+#define __CAMERA_H__
+
+#include "vector.h"
+
+/**
+ * A view that can scroll over a scene whose bodies stay in world coordinates.
+ * The view is the rectangle passed to sdl_init; the camera's position is
+ * how far it has scrolled, the world point shown at the view's origin.
+ *
+ * Moving the camera is O(1) and never touches a body. The renderer offsets
+ * each body by the camera's position as it draws it, and skips the ones out
+ * of view:
+ *
+ *     render_view_t view = {camera_get_position(camera), NULL};
+ *     batch_render_scene_view(batch, scene, shapes, &view);
+ */
+typedef struct camera camera_t;
+
+/**
+ * Allocates a camera positioned at the world origin.
+ *
+ * @return the new camera
+ */
+camera_t *camera_init(void);
+
+/**
+ * Releases the memory allocated for a camera.
+ *
+ * @param camera the camera
+ */
+void camera_free(camera_t *camera);
+
+/**
+ * Gets the world point shown at the view's origin.
+ *
+ * @param camera the camera
+ * @return the camera's position
+ */
+vector_t camera_get_position(camera_t *camera);
+
+/**
+ * Moves the camera to a new world position.
+ *
+ * @param camera the camera
+ * @param position the world point to show at the view's origin
+ */
+void camera_set_position(camera_t *camera, vector_t position);
+
+/**
+ * Scrolls the camera by an offset.
+ *
+ * @param camera the camera
+ * @param offset how far to scroll, in world units
+ */
+void camera_move(camera_t *camera, vector_t offset);
+
+/**
+ * Converts a point in world coordinates to view coordinates.
+ *
+ * @param camera the camera
+ * @param point the point in the world
+ * @return where the point appears in the view
+ */
+vector_t camera_to_view(camera_t *camera, vector_t point);
+
+/**
+ * Converts a point in view coordinates to world coordinates.
+ *
+ * @param camera the camera
+ * @param point the point in the view
+ * @return the world point shown there
+ */
+vector_t camera_to_world(camera_t *camera, vector_t point);
+
+#endif // #ifndef __CAMERA_H__
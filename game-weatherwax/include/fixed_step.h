@@ -0,0 +1,78 @@
+#ifndef __FIXED_STEP_H__
+#define __FIXED_STEP_H__
+
+#include <stddef.h>
+#include "scene.h"
+#include "vector.h"
+
+/**
+ * Runs a scene at a fixed physics rate regardless of the frame rate.
+ * Frame time is accumulated and spent in whole steps of 1 / hz seconds,
+ * so the simulation does not depend on how long each frame took.
+ * At most max_substeps steps are run per frame; time beyond that is dropped,
+ * so one slow frame cannot snowball into ever slower ones.
+ *
+ * The leftover fraction of a step can be used to draw bodies
+ * between their last two physics states, without moving them:
+ *   fixed_step_advance(stepper, scene, time_since_last_tick());
+ *   const draw_pose_t *poses = fixed_step_interpolate(stepper, scene);
+ *   render_view_t view = {VEC_ZERO, NULL, poses, scene_bodies(scene)};
+ *   batch_render_scene_view(batch, scene, shapes, &view);
+ */
+typedef struct fixed_step fixed_step_t;
+
+/** Where to draw a body, which may differ from where it is */
+typedef struct draw_pose {
+    vector_t centroid;
+    double angle;
+} draw_pose_t;
+
+/**
+ * Allocates memory for a fixed-step accumulator.
+ *
+ * @param hz the number of physics steps per simulated second
+ * @param max_substeps the most steps to run for a single frame
+ * @return the new accumulator
+ */
+fixed_step_t *fixed_step_init(double hz, size_t max_substeps);
+
+/**
+ * Releases the memory allocated for a fixed-step accumulator.
+ *
+ * @param stepper a pointer returned from fixed_step_init()
+ */
+void fixed_step_free(fixed_step_t *stepper);
+
+/**
+ * Adds a frame's time to the accumulator and ticks the scene
+ * once for every whole step that has built up.
+ *
+ * @param stepper the accumulator
+ * @param scene the scene to tick
+ * @param dt the time elapsed since the last frame
+ * @return the number of steps run
+ */
+size_t fixed_step_advance(fixed_step_t *stepper, scene_t *scene, double dt);
+
+/**
+ * Gets how far the accumulated time is into the next step.
+ *
+ * @param stepper the accumulator
+ * @return a number in [0, 1)
+ */
+double fixed_step_alpha(fixed_step_t *stepper);
+
+/**
+ * Works out where each body would be partway through the next step,
+ * by blending its position and rotation before and after the last step.
+ * Bodies added during the last step are given their current pose.
+ * No body is changed, so the scene ticks the same whether or not this is called.
+ *
+ * @param stepper the accumulator
+ * @param scene the scene most recently passed to fixed_step_advance()
+ * @return one pose per body, in scene order; the array belongs to the
+ *   accumulator and is overwritten by the next call
+ */
+const draw_pose_t *fixed_step_interpolate(fixed_step_t *stepper, scene_t *scene);
+
+#endif // #ifndef __FIXED_STEP_H__
@@ -0,0 +1,49 @@
+#ifndef __GRAVITY_FIELD_H__
+#define __GRAVITY_FIELD_H__
+
+#include "body.h"
+#include "scene.h"
+
+/**
+ * Newtonian gravity between every pair of bodies in a set,
+ * computed with a Barnes-Hut quadtree in O(n log n) per tick.
+ * This replaces one create_newtonian_gravity force creator per pair.
+ */
+typedef struct gravity_field gravity_field_t;
+
+/**
+ * Allocates a gravity field and adds it to the scene as a force creator.
+ * The scene owns it; it is freed along with the scene.
+ *
+ * @param scene the scene containing the bodies
+ * @param G the gravitational proportionality constant
+ * @param theta the Barnes-Hut opening angle. A quadtree cell of size s at
+ * distance d is treated as a single mass when s / d < theta.
+ * 0 computes every pair exactly; 0.5 is a common tradeoff.
+ * A cell containing the body being pulled is always opened, whatever theta is.
+ * @return the new gravity field
+ */
+gravity_field_t *create_gravity_field(scene_t *scene, double G, double theta);
+
+/**
+ * Adds a body to the gravity field.
+ * The body is attracted by, and attracts, every other body in the field.
+ * It leaves the field when it is removed from the scene.
+ *
+ * @param field the gravity field
+ * @param body the body to add
+ */
+void gravity_field_add_body(gravity_field_t *field, body_t *body);
+
+/**
+ * Sets how many threads compute the field's forces each tick.
+ * Forces are applied in the same order whatever the thread count,
+ * so the simulation does not change; only how fast it runs.
+ * A new field runs on 1 thread.
+ *
+ * @param field the gravity field
+ * @param threads the number of threads, at least 1
+ */
+void gravity_field_set_threads(gravity_field_t *field, size_t threads);
+
+#endif // #ifndef __GRAVITY_FIELD_H__
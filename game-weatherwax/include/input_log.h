@@ -0,0 +1,147 @@
+#ifndef __INPUT_LOG_H__
+#define __INPUT_LOG_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "scene.h"
+#include "sdl_wrapper.h"
+
+/**
+ * A recording of a play session: the random seed, then every key event and
+ * every frame's dt, in the order the game saw them. A game that seeds its
+ * randomness from the log and only changes with its key handler and dt
+ * plays out the same way when the log is replayed.
+ *
+ * Recording, once per frame:
+ *   while (!sdl_is_done(scene)) {          // key handler calls input_log_key()
+ *       double dt = time_since_last_tick();
+ *       input_log_tick(log, dt);
+ *       ...
+ *   }
+ *   input_log_end(log, scene);
+ *
+ * Replaying, as fast as the game can tick, without drawing:
+ *   while (input_log_replay_keys(log, scene, on_key)) {
+ *       double dt = input_log_replay_tick(log);
+ *       ...
+ *   }
+ *   input_log_end(log, scene);
+ *
+ * Skipping the drawing is only safe if drawing changes nothing in the scene.
+ *
+ * The file is a 4-byte tag and the 8-byte seed, then one record per event:
+ * a 1-byte kind, then for a tick its dt, for a key the key and its held time,
+ * or for the end a checksum of the final scene.
+ * Numbers are little-endian and doubles are stored exactly.
+ * The checksum covers the exact bits of every body's vertices, position,
+ * velocity and rotation, so input_log_end() can tell whether a replay really ended in the
+ * state the recording did.
+ */
+typedef struct input_log input_log_t;
+
+/**
+ * Starts recording a session to a file, replacing the file if it exists.
+ *
+ * @param path the file to write
+ * @param seed the seed the game will use
+ * @return the new log, or NULL if the file cannot be written
+ */
+input_log_t *input_log_record(const char *path, uint64_t seed);
+
+/**
+ * Opens a recorded session to replay.
+ *
+ * @param path the file to read
+ * @return the log, or NULL if the file cannot be read or is not a log
+ */
+input_log_t *input_log_replay(const char *path);
+
+/**
+ * Opens a log from "--record <file>" or "--replay <file>" on a demo's command line.
+ * When replaying, also points SDL at its dummy video driver,
+ * so sdl_init() opens no window. Exits with a message if the file cannot be opened.
+ *
+ * @param argc the argument count passed to main
+ * @param argv the arguments passed to main
+ * @param seed the seed to record if recording
+ * @return the log, or NULL if neither option was given
+ */
+input_log_t *input_log_from_args(int argc, char *argv[], uint64_t seed);
+
+/**
+ * Finishes a log and releases its memory.
+ * A replayed log prints how many ticks it ran and how fast, like the benchmarks,
+ * and how its final state compared with the recording's:
+ *   replay ticks=3600 simulated_s=60.0 ticks/s=21345.2 final_state=matched
+ * final_state is unknown if input_log_end() was not called or the recording has no end.
+ *
+ * @param log the log
+ */
+void input_log_free(input_log_t *log);
+
+/**
+ * Checks whether a log is being replayed rather than recorded.
+ *
+ * @param log the log
+ * @return whether the log was opened with input_log_replay()
+ */
+bool input_log_is_replay(input_log_t *log);
+
+/**
+ * Gets the seed the session was played with.
+ *
+ * @param log the log
+ * @return the seed
+ */
+uint64_t input_log_seed(input_log_t *log);
+
+/**
+ * Records a key event, from a key handler passed to sdl_on_key().
+ *
+ * @param log a recording log
+ * @param key the key, as passed to the handler
+ * @param type whether the key was pressed or released
+ * @param held_time how long the key has been held
+ */
+void input_log_key(input_log_t *log, char key, key_event_type_t type, double held_time);
+
+/**
+ * Records the end of a frame's input and the time it stepped the game by.
+ *
+ * @param log a recording log
+ * @param dt the frame's time step
+ */
+void input_log_tick(input_log_t *log, double dt);
+
+/**
+ * Ends a session, once the game loop is done.
+ * A recording log saves a checksum of the scene's bodies.
+ * A replaying log compares the scene with the checksum the recording saved.
+ *
+ * @param log the log
+ * @param scene the scene as it is at the end of the session
+ * @return whether the replay ended in the recorded state; always true when recording
+ */
+bool input_log_end(input_log_t *log, scene_t *scene);
+
+/**
+ * Replays the key events of the next frame, in place of sdl_is_done().
+ *
+ * @param log a replaying log
+ * @param scene the scene to pass to the handler
+ * @param handler the game's key handler
+ * @return whether there is another frame to tick; false at the end of the log
+ */
+bool input_log_replay_keys(input_log_t *log, scene_t *scene, key_handler_t handler);
+
+/**
+ * Gets the time step of the frame whose keys were just replayed,
+ * in place of time_since_last_tick().
+ *
+ * @param log a replaying log
+ * @return the recorded dt
+ */
+double input_log_replay_tick(input_log_t *log);
+
+#endif // #ifndef __INPUT_LOG_H__
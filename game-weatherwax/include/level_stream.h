@@ -0,0 +1,137 @@
+#ifndef __LEVEL_STREAM_H__
+#define __LEVEL_STREAM_H__
+
+#include <stddef.h>
+#include <stdint.h>
+#include "body.h"
+#include "rng.h"
+#include "scene.h"
+#include "vector.h"
+
+/**
+ * A level that is built in horizontal chunks, ahead of time, as the view climbs.
+ *
+ * A background thread lays out chunks from a seeded random stream and queues
+ * a few of them ready to use. A chunk is only a list of spawns, so laying it
+ * out never touches the scene. As the view moves up, level_stream_update()
+ * makes the bodies of the next ready chunk and removes every body of a chunk
+ * at once when the whole chunk has dropped below the view.
+ *
+ * The scene owns the stream; the thread stops when the scene is freed.
+ */
+typedef struct level_stream level_stream_t;
+
+/** A chunk being laid out */
+typedef struct level_chunk level_chunk_t;
+
+/** A body to add when a chunk is added to the scene */
+typedef struct spawn {
+    // What to make; the meaning is up to the game
+    size_t kind;
+    vector_t position;
+    vector_t velocity;
+} spawn_t;
+
+/**
+ * Lays out a chunk with level_chunk_add().
+ * Runs on the stream's thread, so it may only use the chunk, its own aux
+ * and data no other thread writes; in particular not the scene or rand().
+ *
+ * @param chunk the chunk, whose spawns must be at or above bottom
+ * @param bottom where the chunk starts, the top of the previous chunk
+ * @param aux the generator's auxiliary value
+ * @return the top of the chunk, where the next one starts; must be above bottom
+ */
+typedef double (*chunk_generator_t)(level_chunk_t *chunk, double bottom, void *aux);
+
+/**
+ * Makes the body for a spawn, on the thread calling level_stream_update().
+ *
+ * @param scene the stream's scene
+ * @param spawn the spawn
+ * @param aux the spawner's auxiliary value
+ * @return the body, added to the scene, or NULL if none was made
+ */
+typedef body_t *(*chunk_spawner_t)(scene_t *scene, spawn_t spawn, void *aux);
+
+/**
+ * Allocates a level stream and starts laying out its first chunks.
+ *
+ * @param scene the scene to add the level's bodies to
+ * @param bottom where the first chunk starts
+ * @param seed seeds every chunk's random values; the same seed lays out the same level
+ * @param generate lays out each chunk
+ * @param generate_aux passed to generate
+ * @param spawn makes the bodies of each chunk
+ * @param spawn_aux passed to spawn
+ * @return the new stream
+ */
+level_stream_t *create_level_stream(scene_t *scene, double bottom, uint64_t seed,
+    chunk_generator_t generate, void *generate_aux, chunk_spawner_t spawn, void *spawn_aux);
+
+/**
+ * Adds chunks until they reach the top of the view, plus at most one more
+ * chunk above it, and removes the bodies of chunks entirely below the view.
+ * Only waits for the stream's thread if no chunk is ready yet.
+ *
+ * @param stream the stream
+ * @param view_bottom the lowest world y in view
+ * @param view_top the highest world y in view
+ */
+void level_stream_update(level_stream_t *stream, double view_bottom, double view_top);
+
+/**
+ * Gets the top of the highest chunk added to the scene so far.
+ *
+ * @param stream the stream
+ * @return the top of the level's bodies
+ */
+double level_stream_top(level_stream_t *stream);
+
+/**
+ * Adds a spawn to a chunk.
+ *
+ * @param chunk the chunk
+ * @param spawn the spawn
+ */
+void level_chunk_add(level_chunk_t *chunk, spawn_t spawn);
+
+/**
+ * Gets the number of spawns in a chunk so far.
+ *
+ * @param chunk the chunk
+ * @return the number of spawns
+ */
+size_t level_chunk_size(level_chunk_t *chunk);
+
+/**
+ * Gets one of a chunk's spawns, in the order they were added.
+ *
+ * @param chunk the chunk
+ * @param index the index of the spawn, less than level_chunk_size()
+ * @return the spawn
+ */
+spawn_t level_chunk_get(level_chunk_t *chunk, size_t index);
+
+/**
+ * Gets a random number from a chunk's own random stream. Each chunk's generator
+ * is split off the stream's, so it only depends on the stream's seed and the
+ * chunk's position in the level.
+ *
+ * @param chunk the chunk
+ * @param min the smallest value
+ * @param max the largest value
+ * @return a uniform random number in [min, max)
+ */
+double level_chunk_rand(level_chunk_t *chunk, double min, double max);
+
+/**
+ * Gets a chunk's random number generator, which level_chunk_rand() draws from,
+ * for drawing many numbers at once with rng_fill_uniform().
+ *
+ * @param chunk the chunk
+ * @return the chunk's generator; it belongs to the chunk
+ */
+rng_t *level_chunk_rng(level_chunk_t *chunk);
+
+#endif // #ifndef __LEVEL_STREAM_H__
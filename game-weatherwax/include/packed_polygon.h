@@ -0,0 +1,222 @@
+#ifndef __PACKED_POLYGON_H__
+#define __PACKED_POLYGON_H__
+
+#include "collision.h"
+#include "list.h"
+#include "vector.h"
+#include <stdbool.h>
+
+/**
+ * A polygon stored as two contiguous coordinate arrays
+ * instead of a list_t of individually allocated vector_t's.
+ * The functions below mirror polygon.h and collision.h for this layout,
+ * so hot loops walk the vertices without chasing pointers.
+ *
+ * Vertex i is (x[i], y[i]). Vertices are listed counterclockwise,
+ * with an edge between each consecutive pair plus the last and first.
+ */
+typedef struct packed_polygon {
+    size_t size;
+    size_t capacity;
+    double *x;
+    double *y;
+} packed_polygon_t;
+
+/**
+ * The result of a swept collision test: whether two moving polygons touched
+ * at any point during their motion, and if so, when and along which axis.
+ */
+typedef struct swept_collision_info {
+    bool collided;
+    vector_t axis;
+    // Fraction of the motion completed at first contact, in [0, 1]
+    double time;
+} swept_collision_info_t;
+
+/**
+ * Bounding volumes of a polygon: an axis-aligned box and a circle.
+ * Either one lets a collision test reject far-apart polygons
+ * without looking at their vertices.
+ */
+typedef struct bounds {
+    vector_t min;
+    vector_t max;
+    vector_t center;
+    double radius;
+} bounds_t;
+
+/**
+ * Allocates memory for an empty packed polygon.
+ *
+ * @param initial_capacity the number of vertices to allocate space for
+ * @return the new polygon
+ */
+packed_polygon_t *packed_polygon_init(size_t initial_capacity);
+
+/**
+ * Allocates a packed polygon holding a copy of a list_t polygon.
+ *
+ * @param polygon the list of vertices to copy
+ * @return the new polygon
+ */
+packed_polygon_t *packed_polygon_from_list(list_t *polygon);
+
+/**
+ * Overwrites a packed polygon with the vertices of a list_t polygon,
+ * reusing its arrays when they are large enough.
+ *
+ * @param packed the polygon to overwrite
+ * @param polygon the list of vertices to copy
+ */
+void packed_polygon_copy_list(packed_polygon_t *packed, list_t *polygon);
+
+/**
+ * Allocates a list_t polygon holding a copy of a packed polygon,
+ * e.g. to pass to body_init.
+ *
+ * @param packed the polygon to copy
+ * @return a list of newly allocated vector_t's
+ */
+list_t *packed_polygon_to_list(const packed_polygon_t *packed);
+
+/**
+ * Releases the memory allocated for a packed polygon.
+ *
+ * @param packed a pointer returned from packed_polygon_init()
+ */
+void packed_polygon_free(packed_polygon_t *packed);
+
+/**
+ * Appends a vertex to a packed polygon, growing it if needed.
+ *
+ * @param packed the polygon
+ * @param vertex the vertex to add
+ */
+void packed_polygon_add(packed_polygon_t *packed, vector_t vertex);
+
+/**
+ * Gets a vertex of a packed polygon.
+ *
+ * @param packed the polygon
+ * @param index the index of the vertex
+ * @return the vertex
+ */
+vector_t packed_polygon_get(const packed_polygon_t *packed, size_t index);
+
+/**
+ * Computes the area of a packed polygon. See polygon_area().
+ *
+ * @param packed the polygon
+ * @return the area of the polygon
+ */
+double packed_polygon_area(const packed_polygon_t *packed);
+
+/**
+ * Computes the center of mass of a packed polygon. See polygon_centroid().
+ *
+ * @param packed the polygon
+ * @return the centroid of the polygon
+ */
+vector_t packed_polygon_centroid(const packed_polygon_t *packed);
+
+/**
+ * Computes the polar second moment of area of a packed polygon
+ * about its centroid. Multiplied by the density (mass / area),
+ * this is the polygon's moment of inertia.
+ *
+ * @param packed the polygon
+ * @return the second moment of area about the centroid
+ */
+double packed_polygon_moment(const packed_polygon_t *packed);
+
+/**
+ * Translates all vertices in a packed polygon by a given vector.
+ * Note: mutates the original polygon.
+ *
+ * @param packed the polygon
+ * @param translation the vector to add to each vertex's position
+ */
+void packed_polygon_translate(packed_polygon_t *packed, vector_t translation);
+
+/**
+ * Rotates vertices in a packed polygon by a given angle about a given point.
+ * Note: mutates the original polygon.
+ *
+ * @param packed the polygon
+ * @param angle the angle to rotate the polygon, in radians.
+ * A positive angle means counterclockwise.
+ * @param point the point to rotate around
+ */
+void packed_polygon_rotate(packed_polygon_t *packed, double angle, vector_t point);
+
+/**
+ * Overwrites a packed polygon with another one, given in body-local
+ * coordinates, rotated about the origin and then moved to a centroid.
+ * This is how a rigid body's vertices follow its centroid and rotation.
+ *
+ * @param packed the polygon to overwrite
+ * @param local the vertices relative to the centroid, at zero rotation
+ * @param centroid where the local origin ends up
+ * @param angle the angle to rotate by, in radians, counterclockwise
+ */
+void packed_polygon_place(packed_polygon_t *packed, const packed_polygon_t *local, vector_t centroid, double angle);
+
+/**
+ * Computes the bounding box of a packed polygon,
+ * and a bounding circle around the box's center.
+ *
+ * @param packed the polygon
+ * @return the polygon's bounds
+ */
+bounds_t packed_polygon_bounds(const packed_polygon_t *packed);
+
+/**
+ * Determines whether two bounding volumes overlap.
+ * If they don't, neither do the polygons they bound.
+ *
+ * @param bounds1 the first polygon's bounds
+ * @param bounds2 the second polygon's bounds
+ * @return false if the bounding circles or boxes are apart
+ */
+bool bounds_overlap(const bounds_t *bounds1, const bounds_t *bounds2);
+
+/**
+ * Determines whether two convex packed polygons intersect.
+ * See find_collision().
+ *
+ * @param shape1 the first polygon
+ * @param shape2 the second polygon
+ * @return whether the polygons collided, and if so, the collision axis
+ */
+collision_info_t packed_find_collision(const packed_polygon_t *shape1, const packed_polygon_t *shape2);
+
+/**
+ * Determines whether two convex packed polygons touched while moving
+ * in a straight line, without rotating, to where they are now.
+ * Unlike packed_find_collision(), this catches polygons that passed
+ * completely through each other during the motion.
+ *
+ * @param shape1 the first polygon, at the end of its motion
+ * @param motion1 how far the first polygon moved
+ * @param shape2 the second polygon, at the end of its motion
+ * @param motion2 how far the second polygon moved
+ * @return whether the polygons touched, and if so, when they first did
+ * and the collision axis at that moment
+ */
+swept_collision_info_t packed_find_swept_collision(
+    const packed_polygon_t *shape1,
+    vector_t motion1,
+    const packed_polygon_t *shape2,
+    vector_t motion2
+);
+
+/**
+ * Determines whether two packed polygons overlap. See polygon_overlap().
+ *
+ * @param shape1 the first polygon
+ * @param shape2 the second polygon
+ * @return true if the polygons overlap
+ */
+bool packed_polygon_overlap(const packed_polygon_t *shape1, const packed_polygon_t *shape2);
+
+#endif // #ifndef __PACKED_POLYGON_H__
@@ -0,0 +1,66 @@
+#ifndef __PLACEMENT_H__
+#define __PLACEMENT_H__
+
+#include <stdbool.h>
+#include "vector.h"
+
+/**
+ * An occupancy grid of axis-aligned rectangles, for laying out a level
+ * before any of its bodies exist.
+ * A candidate rectangle is only tested against the rectangles in the grid
+ * cells it covers, so each test is O(1) for evenly spread rectangles:
+ *
+ *     do {
+ *         center = random point;
+ *     } while (!placement_fits(placement, center, size));
+ *     placement_add(placement, center, size);
+ *
+ * To keep a gap between rectangles, as in Poisson-disk sampling,
+ * test and add them with their size grown by the gap.
+ */
+typedef struct placement placement_t;
+
+/**
+ * Allocates an empty occupancy grid.
+ *
+ * @param cell_size the width and height of the grid cells; about the size
+ * of the rectangles being placed is best
+ * @return the new grid
+ */
+placement_t *placement_init(double cell_size);
+
+/**
+ * Releases the memory allocated for an occupancy grid.
+ *
+ * @param placement the grid
+ */
+void placement_free(placement_t *placement);
+
+/**
+ * Removes every rectangle from an occupancy grid, keeping its memory.
+ *
+ * @param placement the grid
+ */
+void placement_clear(placement_t *placement);
+
+/**
+ * Checks whether a rectangle is clear of every rectangle in the grid.
+ * Rectangles that only touch along an edge do not overlap.
+ *
+ * @param placement the grid
+ * @param center the center of the rectangle
+ * @param size the width and height of the rectangle
+ * @return whether the rectangle overlaps nothing in the grid
+ */
+bool placement_fits(placement_t *placement, vector_t center, vector_t size);
+
+/**
+ * Adds a rectangle to the grid, whether or not it fits.
+ *
+ * @param placement the grid
+ * @param center the center of the rectangle
+ * @param size the width and height of the rectangle
+ */
+void placement_add(placement_t *placement, vector_t center, vector_t size);
+
+#endif // #ifndef __PLACEMENT_H__
@@ -0,0 +1,83 @@
+#ifndef __RNG_H__
+#define __RNG_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * A seeded random number generator with its own state (xoshiro256**).
+ * Unlike rand(), each generator only changes when it is used, so code that
+ * keeps its own generator gets the same numbers from the same seed
+ * no matter what else calls rand(). A generator must not be used from
+ * two threads at once; give each thread its own with rng_split().
+ *
+ * The state is plain data, so a generator can be copied to replay it.
+ */
+typedef struct rng {
+    uint64_t state[4];
+} rng_t;
+
+/**
+ * Makes a generator from a seed. Nearby seeds give unrelated sequences.
+ *
+ * @param seed the seed
+ * @return the generator
+ */
+rng_t rng_init(uint64_t seed);
+
+/**
+ * Gets the next 64 random bits.
+ *
+ * @param rng the generator
+ * @return a uniform random integer
+ */
+uint64_t rng_next(rng_t *rng);
+
+/**
+ * Gets a random number in [0, 1).
+ *
+ * @param rng the generator
+ * @return a uniform random double
+ */
+double rng_double(rng_t *rng);
+
+/**
+ * Gets a random number in [min, max), like rand_range().
+ *
+ * @param rng the generator
+ * @param min the smallest value
+ * @param max the upper bound
+ * @return a uniform random double
+ */
+double rng_range(rng_t *rng, double min, double max);
+
+/**
+ * Fills an array with random numbers in [min, max).
+ * Gives the same numbers as calling rng_range() count times.
+ *
+ * @param rng the generator
+ * @param values the array to fill
+ * @param count the length of the array
+ * @param min the smallest value
+ * @param max the upper bound
+ */
+void rng_fill_uniform(rng_t *rng, double *values, size_t count, double min, double max);
+
+/**
+ * Advances a generator by 2^128 numbers, as if rng_next() had been called that often.
+ *
+ * @param rng the generator
+ */
+void rng_jump(rng_t *rng);
+
+/**
+ * Splits off a generator for another stream of numbers.
+ * The new generator continues from where rng is, and rng jumps ahead,
+ * so the two never overlap for 2^128 numbers.
+ *
+ * @param rng the generator to split
+ * @return the new generator
+ */
+rng_t rng_split(rng_t *rng);
+
+#endif // #ifndef __RNG_H__
@@ -0,0 +1,115 @@
+#ifndef __SCENE_SNAPSHOT_H__
+#define __SCENE_SNAPSHOT_H__
+
+#include <stddef.h>
+#include <stdint.h>
+#include "body.h"
+#include "color.h"
+#include "scene.h"
+#include "vector.h"
+
+/**
+ * A saved state of some of a scene's bodies, to go back to without rebuilding
+ * the scene, e.g. to restart a level or rewind.
+ *
+ * The states are kept in one flat array of plain data, so they can be copied,
+ * written to a file or mapped back in as they are, on machines with the same
+ * byte order. Every field has a fixed width and they are ordered so that there
+ * is no padding between them, and unused bytes are zeroed, so a state's bytes
+ * only depend on the body.
+ * Restoring writes each state back onto its body if the body is still in the
+ * scene. Bodies removed since are made again by a respawner, which also adds
+ * the forces and collisions the game gives that kind of body; those cannot be
+ * saved as data, since they are functions with aux pointers.
+ *
+ * The scene owns the snapshot; it is freed along with the scene.
+ */
+typedef struct scene_snapshot scene_snapshot_t;
+
+/** The saved state of one body: 64 bytes, with no padding */
+typedef struct body_state {
+    // What kind of body it is; the meaning is up to the game
+    uint32_t kind;
+    // The body's type from body_get_type()
+    int32_t type;
+    vector_t centroid;
+    vector_t velocity;
+    double rotation;
+    // Three floats
+    rgb_color_t color;
+    // 1 if the body is shown, 0 if it is hidden
+    uint32_t visible;
+} body_state_t;
+
+/**
+ * Makes a body again from its saved state, on restoring a snapshot.
+ * The snapshot then sets the body's state, so only the shape, mass, color
+ * and forces need to come from the respawner.
+ *
+ * @param scene the snapshot's scene
+ * @param state the saved state
+ * @param aux the respawner's auxiliary value
+ * @return the body, added to the scene, or NULL to leave it out
+ */
+typedef body_t *(*body_respawner_t)(scene_t *scene, const body_state_t *state, void *aux);
+
+/**
+ * Allocates an empty snapshot of a scene.
+ *
+ * @param scene the scene whose bodies will be added
+ * @param respawn makes bodies that were removed since the snapshot was taken
+ * @param aux passed to respawn
+ * @return the new snapshot
+ */
+scene_snapshot_t *create_scene_snapshot(scene_t *scene, body_respawner_t respawn, void *aux);
+
+/**
+ * Adds a body to a snapshot and saves its current state.
+ * A body must be added to a snapshot at most once.
+ *
+ * @param snapshot the snapshot
+ * @param body a body in the snapshot's scene
+ * @param kind passed to the respawner in the body's state
+ */
+void scene_snapshot_add(scene_snapshot_t *snapshot, body_t *body, uint32_t kind);
+
+/**
+ * Saves the current state of every body in a snapshot,
+ * dropping the bodies the scene has removed.
+ *
+ * @param snapshot the snapshot
+ */
+void scene_snapshot_take(scene_snapshot_t *snapshot);
+
+/**
+ * Puts every body in a snapshot back in its saved state,
+ * respawning the ones that have been removed.
+ * Bodies that are not in the snapshot are left alone.
+ *
+ * @param snapshot the snapshot
+ */
+void scene_snapshot_restore(scene_snapshot_t *snapshot);
+
+/**
+ * Gets the saved states, in the order their bodies were added.
+ *
+ * @param snapshot the snapshot
+ * @param count set to the number of states
+ * @return the states; they belong to the snapshot and change when it is taken
+ */
+const body_state_t *scene_snapshot_states(scene_snapshot_t *snapshot, size_t *count);
+
+/**
+ * Replaces the saved states, e.g. with ones read from a file.
+ * The first states go with the bodies already in the snapshot, in order;
+ * any beyond those have no body yet and are respawned on restoring.
+ * A body cannot be taken out of a snapshot, so there must be a state
+ * for every body already in it.
+ *
+ * @param snapshot the snapshot
+ * @param states the states to copy
+ * @param count the number of states, at least the number of bodies in the snapshot
+ */
+void scene_snapshot_load(scene_snapshot_t *snapshot, const body_state_t *states, size_t count);
+
+#endif // #ifndef __SCENE_SNAPSHOT_H__
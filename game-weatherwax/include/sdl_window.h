@@ -0,0 +1,42 @@
+#ifndef __SDL_WINDOW_H__
+#define __SDL_WINDOW_H__
+
+#include <SDL2/SDL.h>
+#include "vector.h"
+
+/**
+ * The parts of sdl_wrapper.c that sdl_wrapper.h leaves out, for renderers
+ * that draw with SDL directly instead of one body at a time.
+ * Only demos link sdl_wrapper.o, so only demo-only modules may include this.
+ */
+
+/** The window's renderer, created by sdl_init() */
+extern SDL_Renderer *renderer;
+
+/**
+ * Gets the center of the window, in pixels.
+ *
+ * @return the window's center
+ */
+vector_t get_window_center(void);
+
+/**
+ * Gets how many pixels one scene unit takes up,
+ * so the whole area passed to sdl_init() fits in the window.
+ *
+ * @param window_center the window's center, from get_window_center()
+ * @return the scene's scale
+ */
+double get_scene_scale(vector_t window_center);
+
+/**
+ * Converts a scene position to a window position.
+ * The window's y axis points down, unlike the scene's.
+ *
+ * @param scene_pos the position in the scene
+ * @param window_center the window's center, from get_window_center()
+ * @return the position in the window, in pixels
+ */
+vector_t get_window_position(vector_t scene_pos, vector_t window_center);
+
+#endif // #ifndef __SDL_WINDOW_H__
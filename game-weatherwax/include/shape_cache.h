@@ -0,0 +1,135 @@
+#ifndef __SHAPE_CACHE_H__
+#define __SHAPE_CACHE_H__
+
+#include "body.h"
+#include "packed_polygon.h"
+#include "scene.h"
+
+/**
+ * Read-only access to body shapes without copying them.
+ * body_get_shape returns a fresh deep copy on every call; the cache instead
+ * copies each body's shape once, in body-local coordinates, and keeps a
+ * world-space packed polygon that is re-derived from the body's centroid
+ * and rotation only when one of them has changed.
+ *
+ * The area and moment of inertia of a rigid body never change,
+ * so they are computed once, when the body's shape is first copied.
+ *
+ * Each body's bounding volumes are cached alongside its vertices.
+ * The bounding circle is centered on the centroid and never changes size;
+ * the bounding box is rebuilt together with the world-space vertices.
+ *
+ * This relies on bodies being rigid: a body's shape may only change
+ * through body_set_centroid and body_set_rotation.
+ */
+typedef struct shape_cache shape_cache_t;
+
+/**
+ * A body's shape together with its bounding volumes.
+ * The polygon is borrowed from the cache, with the same lifetime
+ * as the pointer returned by shape_cache_get().
+ */
+typedef struct shape_view {
+    const packed_polygon_t *polygon;
+    bounds_t bounds;
+} shape_view_t;
+
+/**
+ * Allocates a shape cache for the bodies of a scene.
+ * The scene owns it; it is freed along with the scene.
+ *
+ * @param scene the scene whose bodies will be looked up
+ * @return the new shape cache
+ */
+shape_cache_t *create_shape_cache(scene_t *scene);
+
+/**
+ * Gets a borrowed view of a body's current shape.
+ * The first call for a body copies its shape; later calls allocate nothing.
+ * The view must not be modified or freed. It stays valid until the body
+ * moves or rotates and the view is requested again, or until the body
+ * is removed from the scene.
+ *
+ * @param cache the shape cache of the scene containing the body
+ * @param body the body
+ * @return the body's vertices, in world coordinates
+ */
+const packed_polygon_t *shape_cache_get(shape_cache_t *cache, body_t *body);
+
+/**
+ * Gets a borrowed view of a body's current shape and bounding volumes.
+ * See shape_cache_get() for how long the view stays valid.
+ *
+ * @param cache the shape cache of the scene containing the body
+ * @param body the body
+ * @return the body's vertices and bounds, in world coordinates
+ */
+shape_view_t shape_cache_view(shape_cache_t *cache, body_t *body);
+
+/**
+ * Brings every cached body's world-space shape up to date at once,
+ * transforming the vertices of all the bodies that moved in one
+ * vertices_rotate_batch() call. Later lookups of those bodies this tick
+ * then do no work. Views of moved bodies are invalidated as if requested again.
+ *
+ * @param cache the shape cache
+ */
+void shape_cache_refresh(shape_cache_t *cache);
+
+/**
+ * Gets a borrowed view of a body's shape relative to its centroid at zero
+ * rotation, with its bounding circle centered on the origin,
+ * so a renderer can draw the body at any pose.
+ * Like the other lookups, the first call for a body copies its shape;
+ * no body is changed, and neither is any view handed out before.
+ * The view stays valid until the body is removed from the scene.
+ *
+ * @param cache the shape cache of the scene containing the body
+ * @param body the body
+ * @return the body's local vertices and bounds
+ */
+shape_view_t shape_cache_local(shape_cache_t *cache, body_t *body);
+
+/**
+ * Gets the area of a body's shape.
+ * Does not bring the body's world-space vertices up to date.
+ *
+ * @param cache the shape cache of the scene containing the body
+ * @param body the body
+ * @return the area of the body's shape
+ */
+double shape_cache_area(shape_cache_t *cache, body_t *body);
+
+/**
+ * Gets a body's moment of inertia about its centroid,
+ * assuming its mass is spread evenly over its shape.
+ * Does not bring the body's world-space vertices up to date.
+ *
+ * @param cache the shape cache of the scene containing the body
+ * @param body the body
+ * @return the body's moment of inertia
+ */
+double shape_cache_moment(shape_cache_t *cache, body_t *body);
+
+/**
+ * Determines whether two shapes intersect, and if so, the collision axis.
+ * Shapes whose bounding volumes are apart are rejected
+ * without running the separating axis test.
+ *
+ * @param shape1 the first shape
+ * @param shape2 the second shape
+ * @return whether the shapes are colliding, and if so, the collision axis
+ */
+collision_info_t shape_view_find_collision(const shape_view_t *shape1, const shape_view_t *shape2);
+
+/**
+ * Determines whether two shapes intersect,
+ * checking their bounding volumes first.
+ *
+ * @param shape1 the first shape
+ * @param shape2 the second shape
+ * @return whether the shapes overlap
+ */
+bool shape_view_overlap(const shape_view_t *shape1, const shape_view_t *shape2);
+
+#endif // #ifndef __SHAPE_CACHE_H__
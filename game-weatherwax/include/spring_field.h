@@ -0,0 +1,56 @@
+#ifndef __SPRING_FIELD_H__
+#define __SPRING_FIELD_H__
+
+#include "body.h"
+#include "scene.h"
+
+/**
+ * A set of springs and drag forces run as one force creator,
+ * in place of one create_spring or create_drag force creator each.
+ * Each force is computed on its own, so a tick's forces can be split across threads;
+ * they are then applied in the order they were added.
+ */
+typedef struct spring_field spring_field_t;
+
+/**
+ * Allocates an empty spring field and adds it to the scene as a force creator.
+ * The scene owns it; it is freed along with the scene.
+ *
+ * @param scene the scene containing the bodies
+ * @return the new spring field
+ */
+spring_field_t *create_spring_field(scene_t *scene);
+
+/**
+ * Adds a spring between two bodies, like create_spring.
+ * The spring goes away when either body is removed from the scene.
+ *
+ * @param field the spring field
+ * @param k the spring constant
+ * @param body1 the first body
+ * @param body2 the second body
+ */
+void spring_field_add_spring(spring_field_t *field, double k, body_t *body1, body_t *body2);
+
+/**
+ * Adds drag on a body, like create_drag.
+ * The drag goes away when the body is removed from the scene.
+ *
+ * @param field the spring field
+ * @param gamma the drag constant
+ * @param body the body to slow down
+ */
+void spring_field_add_drag(spring_field_t *field, double gamma, body_t *body);
+
+/**
+ * Sets how many threads compute the field's forces each tick.
+ * Forces are applied in the same order whatever the thread count,
+ * so the simulation does not change; only how fast it runs.
+ * A new field runs on 1 thread.
+ *
+ * @param field the spring field
+ * @param threads the number of threads, at least 1
+ */
+void spring_field_set_threads(spring_field_t *field, size_t threads);
+
+#endif // #ifndef __SPRING_FIELD_H__
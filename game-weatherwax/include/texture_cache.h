@@ -0,0 +1,76 @@
+#ifndef __TEXTURE_CACHE_H__
+#define __TEXTURE_CACHE_H__
+
+#include <stddef.h>
+#include "list.h"
+#include "sdl_wrapper.h"
+#include "skin.h"
+
+/**
+ * Image textures loaded once per file and shared by every skin that shows them.
+ * sdl_create_image_costume() reads the file and uploads a new texture each
+ * time it is called; costumes from a texture cache only do that the first
+ * time a file is asked for, so spawning bodies with a preloaded image
+ * does not touch the filesystem or the renderer.
+ *
+ * The cache owns its costumes and textures. Skins built from them must be
+ * freed before the cache, which should outlive every scene that uses it:
+ *
+ *     texture_cache_t *textures = texture_cache_init();
+ *     texture_cache_preload(textures, IMAGES, IMAGE_COUNT);
+ *     ...
+ *     body_set_skin(body, skin_init(texture_cache_costumes(textures, images), true));
+ *     ...
+ *     scene_free(scene);
+ *     texture_cache_free(textures);
+ *
+ * Textures are made with sdl_wrapper.c's create_image_texture(),
+ * so the cache is only linked into demos.
+ */
+typedef struct texture_cache texture_cache_t;
+
+/**
+ * Allocates an empty texture cache. Call this after sdl_init().
+ *
+ * @return the new cache
+ */
+texture_cache_t *texture_cache_init(void);
+
+/**
+ * Releases a texture cache, its costumes and their textures.
+ *
+ * @param cache the cache
+ */
+void texture_cache_free(texture_cache_t *cache);
+
+/**
+ * Loads images ahead of time, so later lookups of them are free.
+ *
+ * @param cache the cache
+ * @param images the images to load
+ * @param count the number of images
+ */
+void texture_cache_preload(texture_cache_t *cache, const image_t *images, size_t count);
+
+/**
+ * Gets the costume for an image, loading its file if it is not cached yet.
+ * Images with the same file share a texture.
+ * An image without a file gets a costume without a texture.
+ *
+ * @param cache the cache
+ * @param image the image
+ * @return the cached costume; it belongs to the cache
+ */
+costume_t *texture_cache_get(texture_cache_t *cache, image_t image);
+
+/**
+ * Builds a list of costumes for skin_init(), like make_costumes_from_images().
+ * The list does not own its costumes, so freeing the skin leaves them cached.
+ *
+ * @param cache the cache
+ * @param images a list of image_t *
+ * @return a new list of the images' costumes
+ */
+list_t *texture_cache_costumes(texture_cache_t *cache, list_t *images);
+
+#endif // #ifndef __TEXTURE_CACHE_H__
@@ -0,0 +1,65 @@
+#ifndef __THREAD_POOL_H__
+#define __THREAD_POOL_H__
+
+#include <stddef.h>
+
+/**
+ * A fixed set of worker threads for splitting a loop across cores.
+ * Work is handed out in small chunks of indices that idle threads claim
+ * one at a time, so a thread that finishes early takes over work
+ * that would otherwise wait for a slower one.
+ *
+ * Built on SDL's thread API, which works on every platform we build for.
+ */
+typedef struct thread_pool thread_pool_t;
+
+/**
+ * One iteration of a parallel loop.
+ * Iterations may run in any order and at the same time,
+ * so each must only write to data no other iteration touches.
+ *
+ * @param aux the auxiliary value passed to thread_pool_for()
+ * @param index the loop index
+ * @param thread which thread is running the iteration, less than
+ * thread_pool_threads(). No two iterations on the same thread overlap,
+ * so this can index per-thread scratch space.
+ */
+typedef void (*parallel_task_t)(void *aux, size_t index, size_t thread);
+
+/**
+ * Allocates a thread pool.
+ * The thread calling thread_pool_for() does a share of the work,
+ * so threads - 1 worker threads are started.
+ * A pool with 1 thread starts none and runs loops serially in index order.
+ *
+ * @param threads the number of threads to run loops on, at least 1
+ * @return the new thread pool
+ */
+thread_pool_t *thread_pool_init(size_t threads);
+
+/**
+ * Stops a thread pool's workers and frees it.
+ *
+ * @param pool the thread pool
+ */
+void thread_pool_free(thread_pool_t *pool);
+
+/**
+ * Gets the number of threads a pool runs loops on.
+ *
+ * @param pool the thread pool
+ * @return the thread count passed to thread_pool_init()
+ */
+size_t thread_pool_threads(thread_pool_t *pool);
+
+/**
+ * Runs task for every index in [0, count) and waits for all of them to finish.
+ *
+ * @param pool the thread pool
+ * @param count the number of iterations
+ * @param task the loop body
+ * @param aux passed to task
+ */
+void thread_pool_for(thread_pool_t *pool, size_t count, parallel_task_t task, void *aux);
+
+#endif // #ifndef __THREAD_POOL_H__
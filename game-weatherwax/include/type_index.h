@@ -0,0 +1,63 @@
+#ifndef __TYPE_INDEX_H__
+#define __TYPE_INDEX_H__
+
+#include <stddef.h>
+#include "body.h"
+#include "scene.h"
+
+/**
+ * Buckets of a scene's bodies by body type, so game logic that only cares
+ * about one type of body does not have to scan the whole scene.
+ *
+ * The index picks up bodies as they are added to the scene and forgets them
+ * when the scene drops them; only bodies added since the last query are
+ * looked at, and a dropped body is removed from its bucket in O(1).
+ * This relies on the scene appending new bodies and keeping the rest in order.
+ *
+ * A body whose type changes moves to its new bucket right away if the type is
+ * changed with type_index_set_type(). Otherwise it only moves the next time
+ * its old bucket is queried.
+ */
+typedef struct type_index type_index_t;
+
+/**
+ * Allocates a type index for a scene, which may already have bodies.
+ * The scene owns it; it is freed along with the scene.
+ *
+ * @param scene the scene
+ * @return the new index
+ */
+type_index_t *create_type_index(scene_t *scene);
+
+/**
+ * Gets the number of bodies of a type in the scene.
+ * Like scene_bodies(), this counts bodies removed since the last tick.
+ * Call this before type_index_get_body(); changing body types
+ * while looping over a bucket reorders it.
+ *
+ * @param index the index
+ * @param type the body type
+ * @return the number of bodies of that type
+ */
+size_t type_index_bodies(type_index_t *index, body_type_t type);
+
+/**
+ * Gets a body of a type. Bodies in a bucket are in no particular order.
+ *
+ * @param index the index
+ * @param type the body type
+ * @param i the index of the body in the bucket, less than type_index_bodies()
+ * @return the body
+ */
+body_t *type_index_get_body(type_index_t *index, body_type_t type, size_t i);
+
+/**
+ * Changes a body's type and moves it to the new type's bucket.
+ *
+ * @param index the index
+ * @param body a body in the index's scene
+ * @param type the body's new type
+ */
+void type_index_set_type(type_index_t *index, body_t *body, body_type_t type);
+
+#endif // #ifndef __TYPE_INDEX_H__
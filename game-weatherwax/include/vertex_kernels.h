@@ -0,0 +1,81 @@
+#ifndef __VERTEX_KERNELS_H__
+#define __VERTEX_KERNELS_H__
+
+#include <stddef.h>
+#include "vector.h"
+
+/**
+ * Transforms over vertex arrays stored as separate x and y arrays,
+ * as in packed_polygon_t.
+ *
+ * On x86-64, each kernel runs 4 vertices at a time with AVX2
+ * if the CPU supports it, and 2 at a time with SSE2 otherwise.
+ * Other CPUs use plain loops. Every version does the same arithmetic
+ * in the same order, so they all give bitwise identical results.
+ *
+ * vertices_rotate_batch() transforms many bodies' vertices in one call,
+ * choosing the kernel once for the whole batch.
+ */
+
+/** The arguments of one vertices_rotate() call, for vertices_rotate_batch() */
+typedef struct vertex_transform {
+    double *out_x;
+    double *out_y;
+    const double *x;
+    const double *y;
+    size_t n;
+    double angle;
+    vector_t pivot;
+    vector_t offset;
+} vertex_transform_t;
+
+/**
+ * Adds a vector to every vertex.
+ *
+ * @param x the vertices' x coordinates
+ * @param y the vertices' y coordinates
+ * @param n the number of vertices
+ * @param translation the vector to add
+ */
+void vertices_translate(double *x, double *y, size_t n, vector_t translation);
+
+/**
+ * Rotates vertices about a pivot, then moves the pivot to a new position:
+ * out = offset + rotate(in - pivot, angle).
+ * The output may be the same arrays as the input.
+ *
+ * @param out_x where to write the x coordinates
+ * @param out_y where to write the y coordinates
+ * @param x the input x coordinates
+ * @param y the input y coordinates
+ * @param n the number of vertices
+ * @param angle the angle to rotate by, in radians, counterclockwise
+ * @param pivot the point to rotate around
+ * @param offset where the pivot ends up
+ */
+void vertices_rotate(double *out_x, double *out_y, const double *x, const double *y, size_t n,
+    double angle, vector_t pivot, vector_t offset);
+
+/**
+ * Runs vertices_rotate() for each of a batch of polygons, e.g. every body
+ * that moved this tick. The kernel is chosen once for the whole batch,
+ * and the results are the same as calling vertices_rotate() on each polygon.
+ *
+ * @param transforms the polygons and how to move each one
+ * @param count the number of polygons
+ */
+void vertices_rotate_batch(const vertex_transform_t *transforms, size_t count);
+
+/**
+ * Finds the smallest and largest x and y over a set of vertices.
+ * With no vertices, min is infinite and max is negative infinite.
+ *
+ * @param x the vertices' x coordinates
+ * @param y the vertices' y coordinates
+ * @param n the number of vertices
+ * @param min set to the lowest x and y
+ * @param max set to the highest x and y
+ */
+void vertices_extent(const double *x, const double *y, size_t n, vector_t *min, vector_t *max);
+
+#endif // #ifndef __VERTEX_KERNELS_H__
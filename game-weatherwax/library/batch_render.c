@@ -0,0 +1,319 @@
+#include <assert.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <SDL2/SDL.h>
+#include "batch_render.h"
+#include "body.h"
+#include "packed_polygon.h"
+#include "sdl_window.h"
+#include "sdl_wrapper.h"
+#include "skin.h"
+
+#if !SDL_VERSION_ATLEAST(2, 0, 18)
+#error "batch_render needs SDL_RenderGeometry(), added in SDL 2.0.18"
+#endif
+
+static const size_t INITIAL_CAPACITY = 1024;
+static const size_t INITIAL_SHAPE_CAPACITY = 16;
+
+/** Triangles waiting to be drawn by one SDL_RenderGeometry() call */
+typedef struct geometry {
+    SDL_Vertex *vertices;
+    size_t vertex_count;
+    size_t vertex_capacity;
+
+    int *indices;
+    size_t index_count;
+    size_t index_capacity;
+} geometry_t;
+
+struct batch_render {
+    // Quads of the sprites queued so far, which all use sprite_texture
+    geometry_t sprites;
+    SDL_Texture *sprite_texture;
+
+    // Fans of the polygons queued so far, drawn over the queued sprites
+    geometry_t shapes;
+    // The window box around the queued polygons; empty when there are none
+    vector_t shapes_min;
+    vector_t shapes_max;
+
+    // A body's vertices where it is drawn, rebuilt for each body
+    packed_polygon_t *placed;
+};
+
+static void geometry_init(geometry_t *geometry) {
+    geometry->vertex_count = 0;
+    geometry->vertex_capacity = INITIAL_CAPACITY;
+    geometry->vertices = malloc(INITIAL_CAPACITY * sizeof(SDL_Vertex));
+    geometry->index_count = 0;
+    geometry->index_capacity = INITIAL_CAPACITY;
+    geometry->indices = malloc(INITIAL_CAPACITY * sizeof(int));
+    assert(geometry->vertices != NULL && geometry->indices != NULL);
+}
+
+static void geometry_free(geometry_t *geometry) {
+    free(geometry->vertices);
+    free(geometry->indices);
+}
+
+/** Makes room for more triangles, growing the buffers by doubling */
+static void reserve(geometry_t *geometry, size_t vertices, size_t indices) {
+    if (geometry->vertex_count + vertices > geometry->vertex_capacity) {
+        while (geometry->vertex_count + vertices > geometry->vertex_capacity) {
+            geometry->vertex_capacity *= 2;
+        }
+        geometry->vertices = realloc(geometry->vertices, geometry->vertex_capacity * sizeof(SDL_Vertex));
+        assert(geometry->vertices != NULL);
+    }
+    if (geometry->index_count + indices > geometry->index_capacity) {
+        while (geometry->index_count + indices > geometry->index_capacity) {
+            geometry->index_capacity *= 2;
+        }
+        geometry->indices = realloc(geometry->indices, geometry->index_capacity * sizeof(int));
+        assert(geometry->indices != NULL);
+    }
+}
+
+/** Draws the triangles added so far and empties the buffers */
+static void geometry_draw(geometry_t *geometry, SDL_Texture *texture) {
+    if (geometry->index_count > 0) {
+        SDL_RenderGeometry(renderer, texture, geometry->vertices, (int) geometry->vertex_count,
+            geometry->indices, (int) geometry->index_count);
+    }
+    geometry->vertex_count = 0;
+    geometry->index_count = 0;
+}
+
+/** Forgets the box around the queued polygons */
+static void clear_shapes_box(batch_render_t *batch) {
+    batch->shapes_min = (vector_t) {INFINITY, INFINITY};
+    batch->shapes_max = (vector_t) {-INFINITY, -INFINITY};
+}
+
+batch_render_t *batch_render_init(void) {
+    batch_render_t *batch = malloc(sizeof(batch_render_t));
+    assert(batch != NULL);
+    geometry_init(&batch->sprites);
+    batch->sprite_texture = NULL;
+    geometry_init(&batch->shapes);
+    clear_shapes_box(batch);
+    batch->placed = packed_polygon_init(INITIAL_SHAPE_CAPACITY);
+    return batch;
+}
+
+void batch_render_free(batch_render_t *batch) {
+    geometry_free(&batch->sprites);
+    geometry_free(&batch->shapes);
+    packed_polygon_free(batch->placed);
+    free(batch);
+}
+
+/** Where the window is looking this frame */
+typedef struct frame {
+    vector_t window_center;
+    double scale;
+    // Where the world's origin is in the window; every other point is offset from it
+    vector_t origin;
+    // The part of the world the window shows
+    vector_t view_min;
+    vector_t view_max;
+} frame_t;
+
+/** Gets the skin a body is drawn with, or NULL if it is drawn as a polygon */
+static skin_t *drawn_skin(body_t *body) {
+    skin_t *skin = body_get_skin(body);
+    return skin != NULL && skin_visible(skin) ? skin : NULL;
+}
+
+/** Draws everything queued so far: the sprites, then the polygons over them */
+static void flush(batch_render_t *batch) {
+    geometry_draw(&batch->sprites, batch->sprite_texture);
+    batch->sprite_texture = NULL;
+    geometry_draw(&batch->shapes, NULL);
+    clear_shapes_box(batch);
+}
+
+/**
+ * Queues a skin's active costume centered on a body's centroid, like sdl_draw_sprite(),
+ * unless it is entirely outside the window.
+ * The queued sprites are drawn before the queued polygons, so everything queued
+ * is drawn first if the sprite would cover one of those polygons,
+ * and likewise if it has another texture than the queued sprites.
+ */
+static void draw_sprite(batch_render_t *batch, const frame_t *frame, skin_t *skin, vector_t centroid) {
+    costume_t *costume = skin_get_active_costume(skin);
+    SDL_Texture *texture = costume_get_texture(costume);
+    if (texture == NULL) {
+        return;
+    }
+    double width = frame->scale * costume_get_width(costume);
+    double height = frame->scale * costume_get_height(costume);
+    SDL_FRect rect = {
+        frame->origin.x + frame->scale * centroid.x - 0.5 * width,
+        frame->origin.y - frame->scale * centroid.y - 0.5 * height,
+        width,
+        height
+    };
+    if (rect.x + rect.w < 0 || rect.x > 2 * frame->window_center.x
+            || rect.y + rect.h < 0 || rect.y > 2 * frame->window_center.y) {
+        return;
+    }
+    bool covers_shapes = rect.x <= batch->shapes_max.x && rect.x + rect.w >= batch->shapes_min.x
+        && rect.y <= batch->shapes_max.y && rect.y + rect.h >= batch->shapes_min.y;
+    if (covers_shapes || (batch->sprite_texture != NULL && batch->sprite_texture != texture)) {
+        flush(batch);
+    }
+    batch->sprite_texture = texture;
+
+    geometry_t *sprites = &batch->sprites;
+    reserve(sprites, 4, 6);
+    int corner = (int) sprites->vertex_count;
+    SDL_Color white = {255, 255, 255, 255};
+    SDL_Vertex *vertices = &sprites->vertices[sprites->vertex_count];
+    vertices[0] = (SDL_Vertex) {{rect.x, rect.y}, white, {0, 0}};
+    vertices[1] = (SDL_Vertex) {{rect.x + rect.w, rect.y}, white, {1, 0}};
+    vertices[2] = (SDL_Vertex) {{rect.x + rect.w, rect.y + rect.h}, white, {1, 1}};
+    vertices[3] = (SDL_Vertex) {{rect.x, rect.y + rect.h}, white, {0, 1}};
+    sprites->vertex_count += 4;
+
+    int *indices = &sprites->indices[sprites->index_count];
+    indices[0] = corner;
+    indices[1] = corner + 1;
+    indices[2] = corner + 2;
+    indices[3] = corner;
+    indices[4] = corner + 2;
+    indices[5] = corner + 3;
+    sprites->index_count += 6;
+}
+
+/** Adds a polygon as a fan of triangles around its centroid */
+static void add_fan(batch_render_t *batch, const frame_t *frame, const packed_polygon_t *polygon,
+        vector_t centroid, SDL_Color color) {
+    vector_t origin = frame->origin;
+    double scale = frame->scale;
+    size_t n = polygon->size;
+    geometry_t *shapes = &batch->shapes;
+    reserve(shapes, n + 1, 3 * n);
+    int center = (int) shapes->vertex_count;
+    SDL_Vertex *vertices = &shapes->vertices[shapes->vertex_count];
+    // Window y grows downwards
+    vertices[0] = (SDL_Vertex) {
+        {origin.x + scale * centroid.x, origin.y - scale * centroid.y}, color, {0, 0}
+    };
+    for (size_t i = 0; i < n; i++) {
+        vertices[i + 1] = (SDL_Vertex) {
+            {origin.x + scale * polygon->x[i], origin.y - scale * polygon->y[i]}, color, {0, 0}
+        };
+    }
+    // The fan lies within its outer vertices, so they bound it
+    for (size_t i = 1; i <= n; i++) {
+        batch->shapes_min.x = fmin(batch->shapes_min.x, vertices[i].position.x);
+        batch->shapes_min.y = fmin(batch->shapes_min.y, vertices[i].position.y);
+        batch->shapes_max.x = fmax(batch->shapes_max.x, vertices[i].position.x);
+        batch->shapes_max.y = fmax(batch->shapes_max.y, vertices[i].position.y);
+    }
+    shapes->vertex_count += n + 1;
+
+    int *indices = &shapes->indices[shapes->index_count];
+    for (size_t i = 0; i < n; i++) {
+        indices[3 * i] = center;
+        indices[3 * i + 1] = center + 1 + (int) i;
+        indices[3 * i + 2] = center + 1 + (int) ((i + 1) % n);
+    }
+    shapes->index_count += 3 * n;
+}
+
+/** Checks whether a bounding box is entirely outside the window */
+static bool out_of_view(const frame_t *frame, vector_t min, vector_t max) {
+    return max.x < frame->view_min.x || min.x > frame->view_max.x
+        || max.y < frame->view_min.y || min.y > frame->view_max.y;
+}
+
+/**
+ * Puts a body's vertices at the pose it is drawn in, in batch->placed.
+ * The body is left where it is; its shape comes from the cache, which copies
+ * it the first time the body is drawn, so later frames copy nothing.
+ *
+ * @return false if the body is out of view, so there is nothing to draw
+ */
+static bool place_body(batch_render_t *batch, const frame_t *frame, shape_cache_t *shapes,
+        body_t *body, draw_pose_t pose) {
+    shape_view_t local = shape_cache_local(shapes, body);
+    double radius = local.bounds.radius;
+    vector_t extent = {radius, radius};
+    if (out_of_view(frame, vec_subtract(pose.centroid, extent), vec_add(pose.centroid, extent))) {
+        return false;
+    }
+    packed_polygon_place(batch->placed, local.polygon, pose.centroid, pose.angle);
+    return true;
+}
+
+/** Queues one body at a pose, as a sprite or a polygon, unless it is out of view */
+static void draw_body(batch_render_t *batch, const frame_t *frame, shape_cache_t *shapes,
+        body_t *body, draw_pose_t pose) {
+    if (!body_visible(body)) {
+        return;
+    }
+    skin_t *skin = drawn_skin(body);
+    if (skin != NULL) {
+        draw_sprite(batch, frame, skin, pose.centroid);
+        return;
+    }
+    if (!place_body(batch, frame, shapes, body, pose) || batch->placed->size < 3) {
+        return;
+    }
+    rgb_color_t color = body_get_color(body);
+    SDL_Color sdl_color = {color.r * 255, color.g * 255, color.b * 255, 255};
+    add_fan(batch, frame, batch->placed, pose.centroid, sdl_color);
+}
+
+/** Gets where to draw the body at an index, from the view's poses if it has them */
+static draw_pose_t body_pose(const render_view_t *view, body_t *body, size_t index) {
+    if (view != NULL && view->poses != NULL && index < view->pose_count) {
+        return view->poses[index];
+    }
+    return (draw_pose_t) {body_get_centroid(body), body_get_rotation(body)};
+}
+
+void batch_render_scene(batch_render_t *batch, scene_t *scene, shape_cache_t *shapes) {
+    batch_render_scene_view(batch, scene, shapes, NULL);
+}
+
+void batch_render_scene_view(batch_render_t *batch, scene_t *scene, shape_cache_t *shapes,
+        const render_view_t *view) {
+    vector_t camera = view != NULL ? view->camera : VEC_ZERO;
+    body_t *top = view != NULL ? view->top : NULL;
+
+    frame_t frame;
+    frame.window_center = get_window_center();
+    frame.scale = get_scene_scale(frame.window_center);
+    // The window shows the camera's position where it would show the origin
+    frame.origin = get_window_position(vec_negate(camera), frame.window_center);
+    frame.view_min = (vector_t) {
+        -frame.origin.x / frame.scale,
+        (frame.origin.y - 2 * frame.window_center.y) / frame.scale
+    };
+    frame.view_max = (vector_t) {
+        (2 * frame.window_center.x - frame.origin.x) / frame.scale,
+        frame.origin.y / frame.scale
+    };
+
+    sdl_clear();
+    size_t bodies = scene_bodies(scene);
+    size_t top_index = bodies;
+    for (size_t i = 0; i < bodies; i++) {
+        body_t *body = scene_get_body(scene, i);
+        if (body == top) {
+            top_index = i;
+            continue;
+        }
+        draw_body(batch, &frame, shapes, body, body_pose(view, body, i));
+    }
+    if (top_index < bodies) {
+        draw_body(batch, &frame, shapes, top, body_pose(view, top, top_index));
+    }
+    flush(batch);
+    sdl_show();
+}
@@ -0,0 +1,137 @@
+#include <assert.h>
+#include <stdlib.h>
+#include "body_pool.h"
+#include "body_watch.h"
+
+static const size_t INITIAL_CAPACITY = 8;
+// Far enough away that parked bodies never touch anything in play
+static const vector_t PARKED_CENTROID = {-1e6, -1e6};
+
+typedef struct watch {
+    body_pool_t *pool;
+    body_t *body;
+} watch_t;
+
+struct body_pool {
+    scene_t *scene;
+    body_maker_t maker;
+    void *aux;
+    free_func_t freer;
+    size_t refs;
+
+    // Every body made for the pool
+    body_t **bodies;
+    size_t body_count;
+    // Parked bodies, used as a stack; as large as bodies, so parking never allocates
+    body_t **parked;
+    size_t parked_count;
+    size_t capacity;
+};
+
+static void body_pool_noop(void *aux) {}
+
+static void body_pool_release_ref(body_pool_t *pool) {
+    pool->refs--;
+    if (pool->refs == 0) {
+        if (pool->freer != NULL) {
+            pool->freer(pool->aux);
+        }
+        free(pool->bodies);
+        free(pool->parked);
+        free(pool);
+    }
+}
+
+/** Removes a body from an array by swapping in the last element */
+static void swap_remove(body_t **bodies, size_t *count, body_t *body) {
+    for (size_t i = 0; i < *count; i++) {
+        if (bodies[i] == body) {
+            bodies[i] = bodies[--*count];
+            return;
+        }
+    }
+}
+
+/** Forgets a pooled body that was removed from the scene */
+static void forget_body(watch_t *watch) {
+    body_pool_t *pool = watch->pool;
+    swap_remove(pool->bodies, &pool->body_count, watch->body);
+    swap_remove(pool->parked, &pool->parked_count, watch->body);
+    free(watch);
+    body_pool_release_ref(pool);
+}
+
+static body_t *make_body(body_pool_t *pool) {
+    if (pool->body_count == pool->capacity) {
+        pool->capacity *= 2;
+        pool->bodies = realloc(pool->bodies, pool->capacity * sizeof(body_t *));
+        pool->parked = realloc(pool->parked, pool->capacity * sizeof(body_t *));
+        assert(pool->bodies != NULL && pool->parked != NULL);
+    }
+    body_t *body = pool->maker(pool, pool->aux);
+    pool->bodies[pool->body_count++] = body;
+
+    watch_t *watch = malloc(sizeof(watch_t));
+    assert(watch != NULL);
+    watch->pool = pool;
+    watch->body = body;
+    pool->refs++;
+    body_watch(pool->scene, body, (free_func_t) forget_body, watch);
+    return body;
+}
+
+body_pool_t *create_body_pool(scene_t *scene, body_maker_t maker, void *aux, free_func_t freer) {
+    body_pool_t *pool = malloc(sizeof(body_pool_t));
+    assert(pool != NULL);
+    pool->scene = scene;
+    pool->maker = maker;
+    pool->aux = aux;
+    pool->freer = freer;
+    pool->refs = 1;
+    pool->body_count = 0;
+    pool->parked_count = 0;
+    pool->capacity = INITIAL_CAPACITY;
+    pool->bodies = malloc(INITIAL_CAPACITY * sizeof(body_t *));
+    pool->parked = malloc(INITIAL_CAPACITY * sizeof(body_t *));
+    assert(pool->bodies != NULL && pool->parked != NULL);
+    scene_add_force_creator(scene, body_pool_noop, pool, (free_func_t) body_pool_release_ref);
+    return pool;
+}
+
+scene_t *body_pool_get_scene(body_pool_t *pool) {
+    return pool->scene;
+}
+
+body_t *body_pool_acquire(body_pool_t *pool, vector_t centroid, vector_t velocity) {
+    body_t *body;
+    if (pool->parked_count > 0) {
+        body = pool->parked[--pool->parked_count];
+    }
+    else {
+        body = make_body(pool);
+    }
+    body_set_centroid(body, centroid);
+    body_set_velocity(body, velocity);
+    body_show(body);
+    return body;
+}
+
+void body_pool_release(body_pool_t *pool, body_t *body) {
+    if (!body_visible(body)) {
+        return;
+    }
+    assert(pool->parked_count < pool->body_count);
+    body_hide(body);
+    body_set_velocity(body, VEC_ZERO);
+    body_set_centroid(body, PARKED_CENTROID);
+    pool->parked[pool->parked_count++] = body;
+}
+
+size_t body_pool_size(body_pool_t *pool) {
+    return pool->body_count;
+}
+
+body_t *body_pool_get(body_pool_t *pool, size_t index) {
+    assert(index < pool->body_count);
+    return pool->bodies[index];
+}
@@ -0,0 +1,153 @@
+#include <assert.h>
+#include <stdlib.h>
+#include "body_table.h"
+#include "body_watch.h"
+
+static const size_t INITIAL_CAPACITY = 16;
+static const uint32_t NO_SLOT = UINT32_MAX;
+
+// Live slots start at generation 1, so generation 0 never matches
+const body_handle_t NO_BODY_HANDLE = {0, 0};
+
+/**
+ * A handle's target. A live slot stores where its body is in the dense array;
+ * a free slot stores the next free slot instead.
+ */
+typedef struct slot {
+    uint32_t generation;
+    uint32_t next;
+} slot_t;
+
+typedef struct watch {
+    body_table_t *table;
+    uint32_t slot;
+} watch_t;
+
+struct body_table {
+    scene_t *scene;
+    size_t refs;
+
+    slot_t *slots;
+    size_t slot_count;
+    size_t slot_capacity;
+    // Head of the free slot list
+    uint32_t free_slot;
+
+    // Live bodies, and the slot each one belongs to
+    body_t **bodies;
+    uint32_t *body_slots;
+    size_t body_count;
+    size_t body_capacity;
+};
+
+static void body_table_noop(void *aux) {}
+
+static void body_table_release_ref(body_table_t *table) {
+    table->refs--;
+    if (table->refs == 0) {
+        free(table->slots);
+        free(table->bodies);
+        free(table->body_slots);
+        free(table);
+    }
+}
+
+/** Swaps the last body into the dropped body's place and frees its slot */
+static void forget_body(watch_t *watch) {
+    body_table_t *table = watch->table;
+    slot_t *slot = &table->slots[watch->slot];
+    uint32_t index = slot->next;
+    uint32_t last = table->body_count - 1;
+    table->bodies[index] = table->bodies[last];
+    table->body_slots[index] = table->body_slots[last];
+    table->slots[table->body_slots[index]].next = index;
+    table->body_count--;
+
+    slot->generation++;
+    if (slot->generation == 0) {
+        slot->generation = 1;
+    }
+    slot->next = table->free_slot;
+    table->free_slot = watch->slot;
+
+    free(watch);
+    body_table_release_ref(table);
+}
+
+static uint32_t take_slot(body_table_t *table) {
+    if (table->free_slot != NO_SLOT) {
+        uint32_t index = table->free_slot;
+        table->free_slot = table->slots[index].next;
+        return index;
+    }
+    if (table->slot_count == table->slot_capacity) {
+        table->slot_capacity *= 2;
+        table->slots = realloc(table->slots, table->slot_capacity * sizeof(slot_t));
+        assert(table->slots != NULL);
+    }
+    assert(table->slot_count < NO_SLOT);
+    table->slots[table->slot_count].generation = 1;
+    return table->slot_count++;
+}
+
+body_table_t *create_body_table(scene_t *scene) {
+    body_table_t *table = malloc(sizeof(body_table_t));
+    assert(table != NULL);
+    table->scene = scene;
+    table->refs = 1;
+    table->slot_count = 0;
+    table->slot_capacity = INITIAL_CAPACITY;
+    table->slots = malloc(INITIAL_CAPACITY * sizeof(slot_t));
+    table->free_slot = NO_SLOT;
+    table->body_count = 0;
+    table->body_capacity = INITIAL_CAPACITY;
+    table->bodies = malloc(INITIAL_CAPACITY * sizeof(body_t *));
+    table->body_slots = malloc(INITIAL_CAPACITY * sizeof(uint32_t));
+    assert(table->slots != NULL && table->bodies != NULL && table->body_slots != NULL);
+    scene_add_force_creator(scene, body_table_noop, table, (free_func_t) body_table_release_ref);
+    return table;
+}
+
+body_handle_t body_table_add(body_table_t *table, body_t *body) {
+    if (table->body_count == table->body_capacity) {
+        table->body_capacity *= 2;
+        table->bodies = realloc(table->bodies, table->body_capacity * sizeof(body_t *));
+        table->body_slots = realloc(table->body_slots, table->body_capacity * sizeof(uint32_t));
+        assert(table->bodies != NULL && table->body_slots != NULL);
+    }
+    uint32_t index = take_slot(table);
+    table->slots[index].next = table->body_count;
+    table->bodies[table->body_count] = body;
+    table->body_slots[table->body_count] = index;
+    table->body_count++;
+
+    watch_t *watch = malloc(sizeof(watch_t));
+    assert(watch != NULL);
+    watch->table = table;
+    watch->slot = index;
+    table->refs++;
+    body_watch(table->scene, body, (free_func_t) forget_body, watch);
+    return (body_handle_t) {index, table->slots[index].generation};
+}
+
+body_t *body_table_get(body_table_t *table, body_handle_t handle) {
+    if (handle.index >= table->slot_count || table->slots[handle.index].generation != handle.generation) {
+        return NULL;
+    }
+    body_t *body = table->bodies[table->slots[handle.index].next];
+    // The scene only drops removed bodies at the end of the tick
+    return body_is_removed(body) ? NULL : body;
+}
+
+size_t body_table_size(body_table_t *table) {
+    return table->body_count;
+}
+
+body_t *body_table_body(body_table_t *table, size_t index) {
+    assert(index < table->body_count);
+    return table->bodies[index];
+}
+
+bool body_handle_equal(body_handle_t a, body_handle_t b) {
+    return a.index == b.index && a.generation == b.generation;
+}
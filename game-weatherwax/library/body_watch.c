@@ -0,0 +1,10 @@
+#include <stdlib.h>
+#include "body_watch.h"
+
+static void body_watch_noop(void *aux) {}
+
+void body_watch(scene_t *scene, body_t *body, free_func_t on_removed, void *aux) {
+    list_t *bodies = list_init(1, NULL);
+    list_add(bodies, body);
+    scene_add_bodies_force_creator(scene, body_watch_noop, aux, bodies, on_removed);
+}
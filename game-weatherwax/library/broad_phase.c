@@ -0,0 +1,991 @@
+#include <assert.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include "body_watch.h"
+#include "broad_phase.h"
+#include "collision.h"
+#include "packed_polygon.h"
+#include "shape_cache.h"
+#include "vector.h"
+
+#define NO_SLOT SIZE_MAX
+#define NO_RULE SIZE_MAX
+
+static const size_t INITIAL_CAPACITY = 16;
+// Moves longer than this many cells in one tick are teleports, not sweeps
+static const double MAX_SWEEP_CELLS = 16;
+// Bodies that stay within this many cells of one spot are resting.
+// A sleeping body's cells are padded by as much, so it may drift that far
+// (e.g. settling under gravity) without waking.
+static const double SLEEP_DISTANCE_CELLS = 0.01;
+// How many ticks in a row a body must rest before it sleeps.
+// Infinite-mass bodies are static and sleep sooner, once they have been checked.
+static const size_t SLEEP_TICKS = 30;
+static const size_t STATIC_SLEEP_TICKS = 2;
+
+const uint32_t ALL_CATEGORIES = UINT32_MAX;
+
+/** Handlers for every pair of bodies in two categories */
+typedef struct rule {
+    uint32_t category1;
+    uint32_t category2;
+    contact_handlers_t handlers;
+    void *aux;
+    free_func_t freer;
+} rule_t;
+
+/**
+ * One registered collision between two bodies.
+ * It is referenced from both bodies' record lists (and from the
+ * touching list while the bodies overlap), so it is refcounted.
+ */
+typedef struct pair_record {
+    size_t slot1;
+    size_t slot2;
+    body_t *body1;
+    body_t *body2;
+    contact_handlers_t handlers;
+    void *aux;
+    free_func_t freer;
+    // The contact axis as of the last tick the bodies touched
+    vector_t axis;
+    // The rule that made this record, or NO_RULE if it was added directly
+    size_t rule;
+    bool colliding;
+    bool dead;
+    size_t refs;
+    size_t stamp;
+    struct pair_record *next;
+} pair_record_t;
+
+/** A body that is part of at least one registered pair, or has a category */
+typedef struct tracked {
+    body_t *body;
+    list_t *records;
+    size_t live_records;
+    // The body's vertices and bounds as of the current tick, from the shape cache
+    shape_view_t shape;
+    // Centroid as of the last tick, and how far the body has moved since
+    vector_t previous;
+    vector_t motion;
+    bool bullet;
+    // Sleeping bodies keep their cells from when they fell asleep
+    // until they move away, so they cost nothing per tick while still
+    bool asleep;
+    // Where the body has stayed near for the last still_ticks ticks
+    vector_t rest_center;
+    size_t still_ticks;
+    // Which categories the body is in, and which it may collide with
+    uint32_t category;
+    uint32_t mask;
+    // Next slot in the same body bucket, or in the free list
+    size_t next;
+    bool active;
+} tracked_t;
+
+typedef struct cell_entry {
+    uint64_t cell;
+    size_t slot;
+} cell_entry_t;
+
+typedef struct watch {
+    broad_phase_t *broad_phase;
+    size_t slot;
+} watch_t;
+
+struct broad_phase {
+    scene_t *scene;
+    double cell_size;
+    size_t refs;
+    size_t tick;
+    shape_cache_t *shapes;
+
+    tracked_t *tracked;
+    size_t tracked_size;
+    size_t tracked_capacity;
+    size_t free_slot;
+    size_t active_count;
+    size_t bullet_count;
+    size_t *body_buckets;
+    size_t body_bucket_count;
+
+    pair_record_t **pair_buckets;
+    size_t pair_bucket_count;
+    size_t pair_count;
+
+    cell_entry_t *cells;
+    size_t cell_count;
+    size_t cell_capacity;
+
+    // Cells of sleeping bodies, sorted; rebuilt only when a body falls asleep or wakes
+    cell_entry_t *sleeping_cells;
+    size_t sleeping_cell_count;
+    size_t sleeping_cell_capacity;
+    bool sleeping_changed;
+
+    pair_record_t **candidates;
+    size_t candidate_count;
+    size_t candidate_capacity;
+
+    pair_record_t **touching;
+    size_t touching_count;
+    size_t touching_capacity;
+
+    rule_t *rules;
+    size_t rule_count;
+    size_t rule_capacity;
+
+    // Records made by rules, which are dropped once their bodies part
+    pair_record_t **rule_records;
+    size_t rule_record_count;
+    size_t rule_record_capacity;
+};
+
+/** Makes sure array has room for needed elements, doubling its capacity */
+static void *ensure_capacity(void *array, size_t *capacity, size_t needed, size_t elem_size) {
+    if (needed <= *capacity) {
+        return array;
+    }
+    size_t new_capacity = *capacity == 0 ? INITIAL_CAPACITY : *capacity;
+    while (new_capacity < needed) {
+        new_capacity *= 2;
+    }
+    array = realloc(array, new_capacity * elem_size);
+    assert(array != NULL);
+    *capacity = new_capacity;
+    return array;
+}
+
+static size_t hash_pointer(void *pointer) {
+    uint64_t h = (uint64_t) (uintptr_t) pointer;
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    return (size_t) h;
+}
+
+static size_t hash_pair(size_t slot1, size_t slot2) {
+    size_t lo = slot1 < slot2 ? slot1 : slot2;
+    size_t hi = slot1 < slot2 ? slot2 : slot1;
+    uint64_t h = (uint64_t) lo * 0x9e3779b97f4a7c15ULL ^ (uint64_t) hi * 0xc2b2ae3d27d4eb4fULL;
+    h ^= h >> 29;
+    return (size_t) h;
+}
+
+static bool record_matches(pair_record_t *record, size_t slot1, size_t slot2) {
+    return (record->slot1 == slot1 && record->slot2 == slot2)
+        || (record->slot1 == slot2 && record->slot2 == slot1);
+}
+
+static void record_release(pair_record_t *record) {
+    record->refs--;
+    if (record->refs == 0) {
+        free(record);
+    }
+}
+
+static void broad_phase_free(broad_phase_t *broad_phase) {
+    for (size_t i = 0; i < broad_phase->touching_count; i++) {
+        record_release(broad_phase->touching[i]);
+    }
+    for (size_t i = 0; i < broad_phase->rule_record_count; i++) {
+        record_release(broad_phase->rule_records[i]);
+    }
+    for (size_t i = 0; i < broad_phase->rule_count; i++) {
+        if (broad_phase->rules[i].freer != NULL) {
+            broad_phase->rules[i].freer(broad_phase->rules[i].aux);
+        }
+    }
+    free(broad_phase->rules);
+    free(broad_phase->tracked);
+    free(broad_phase->body_buckets);
+    free(broad_phase->pair_buckets);
+    free(broad_phase->cells);
+    free(broad_phase->sleeping_cells);
+    free(broad_phase->candidates);
+    free(broad_phase->touching);
+    free(broad_phase->rule_records);
+    free(broad_phase);
+}
+
+static void broad_phase_release(broad_phase_t *broad_phase) {
+    broad_phase->refs--;
+    if (broad_phase->refs == 0) {
+        broad_phase_free(broad_phase);
+    }
+}
+
+// ===== BODY TABLE =====
+
+static void rehash_bodies(broad_phase_t *broad_phase, size_t bucket_count) {
+    free(broad_phase->body_buckets);
+    broad_phase->body_buckets = malloc(bucket_count * sizeof(size_t));
+    assert(broad_phase->body_buckets != NULL);
+    broad_phase->body_bucket_count = bucket_count;
+    for (size_t i = 0; i < bucket_count; i++) {
+        broad_phase->body_buckets[i] = NO_SLOT;
+    }
+    for (size_t slot = 0; slot < broad_phase->tracked_size; slot++) {
+        tracked_t *tracked = &broad_phase->tracked[slot];
+        if (tracked->active) {
+            size_t bucket = hash_pointer(tracked->body) & (bucket_count - 1);
+            tracked->next = broad_phase->body_buckets[bucket];
+            broad_phase->body_buckets[bucket] = slot;
+        }
+    }
+}
+
+static size_t find_slot(broad_phase_t *broad_phase, body_t *body) {
+    size_t bucket = hash_pointer(body) & (broad_phase->body_bucket_count - 1);
+    size_t slot = broad_phase->body_buckets[bucket];
+    while (slot != NO_SLOT && broad_phase->tracked[slot].body != body) {
+        slot = broad_phase->tracked[slot].next;
+    }
+    return slot;
+}
+
+static void untrack_body(watch_t *watch);
+
+static size_t track_body(broad_phase_t *broad_phase, body_t *body) {
+    size_t slot = find_slot(broad_phase, body);
+    if (slot != NO_SLOT) {
+        return slot;
+    }
+
+    if (broad_phase->free_slot != NO_SLOT) {
+        slot = broad_phase->free_slot;
+        broad_phase->free_slot = broad_phase->tracked[slot].next;
+    }
+    else {
+        slot = broad_phase->tracked_size++;
+        broad_phase->tracked = ensure_capacity(broad_phase->tracked,
+            &broad_phase->tracked_capacity, broad_phase->tracked_size, sizeof(tracked_t));
+    }
+
+    tracked_t *tracked = &broad_phase->tracked[slot];
+    tracked->body = body;
+    tracked->records = list_init(1, NULL);
+    tracked->live_records = 0;
+    tracked->previous = body_get_centroid(body);
+    tracked->motion = VEC_ZERO;
+    tracked->bullet = false;
+    tracked->asleep = false;
+    tracked->rest_center = tracked->previous;
+    tracked->still_ticks = 0;
+    tracked->category = 0;
+    tracked->mask = ALL_CATEGORIES;
+    tracked->active = true;
+    broad_phase->active_count++;
+
+    if (broad_phase->active_count > broad_phase->body_bucket_count) {
+        rehash_bodies(broad_phase, broad_phase->body_bucket_count * 2);
+    }
+    else {
+        size_t bucket = hash_pointer(body) & (broad_phase->body_bucket_count - 1);
+        tracked->next = broad_phase->body_buckets[bucket];
+        broad_phase->body_buckets[bucket] = slot;
+    }
+
+    watch_t *watch = malloc(sizeof(watch_t));
+    assert(watch != NULL);
+    watch->broad_phase = broad_phase;
+    watch->slot = slot;
+    broad_phase->refs++;
+    body_watch(broad_phase->scene, body, (free_func_t) untrack_body, watch);
+    return slot;
+}
+
+// ===== PAIR TABLE =====
+
+static void rehash_pairs(broad_phase_t *broad_phase, size_t bucket_count) {
+    pair_record_t **buckets = calloc(bucket_count, sizeof(pair_record_t *));
+    assert(buckets != NULL);
+    for (size_t i = 0; i < broad_phase->pair_bucket_count; i++) {
+        pair_record_t *record = broad_phase->pair_buckets[i];
+        while (record != NULL) {
+            pair_record_t *next = record->next;
+            size_t bucket = hash_pair(record->slot1, record->slot2) & (bucket_count - 1);
+            record->next = buckets[bucket];
+            buckets[bucket] = record;
+            record = next;
+        }
+    }
+    free(broad_phase->pair_buckets);
+    broad_phase->pair_buckets = buckets;
+    broad_phase->pair_bucket_count = bucket_count;
+}
+
+/**
+ * Drops the dead records from a body's record list once they outnumber the live ones,
+ * so a body that outlives many partners does not keep every record it ever had
+ */
+static void compact_records(tracked_t *tracked) {
+    list_t *records = tracked->records;
+    // A body being untracked has already let go of its list
+    if (records == NULL || tracked->live_records * 2 >= list_size(records)) {
+        return;
+    }
+    list_t *live = list_init(tracked->live_records > 0 ? tracked->live_records : 1, NULL);
+    for (size_t i = 0; i < list_size(records); i++) {
+        pair_record_t *record = list_get(records, i);
+        if (record->dead) {
+            record_release(record);
+        }
+        else {
+            list_add(live, record);
+        }
+    }
+    list_free(records);
+    tracked->records = live;
+}
+
+static void kill_record(broad_phase_t *broad_phase, pair_record_t *record) {
+    size_t bucket = hash_pair(record->slot1, record->slot2) & (broad_phase->pair_bucket_count - 1);
+    pair_record_t **link = &broad_phase->pair_buckets[bucket];
+    while (*link != record) {
+        link = &(*link)->next;
+    }
+    *link = record->next;
+    broad_phase->pair_count--;
+
+    record->dead = true;
+    broad_phase->tracked[record->slot1].live_records--;
+    broad_phase->tracked[record->slot2].live_records--;
+    compact_records(&broad_phase->tracked[record->slot1]);
+    compact_records(&broad_phase->tracked[record->slot2]);
+    if (record->freer != NULL) {
+        record->freer(record->aux);
+    }
+}
+
+static pair_record_t *add_record(broad_phase_t *broad_phase, size_t slot1, size_t slot2,
+    contact_handlers_t handlers, void *aux, free_func_t freer, size_t rule) {
+    pair_record_t *record = malloc(sizeof(pair_record_t));
+    assert(record != NULL);
+    record->slot1 = slot1;
+    record->slot2 = slot2;
+    record->body1 = broad_phase->tracked[slot1].body;
+    record->body2 = broad_phase->tracked[slot2].body;
+    record->handlers = handlers;
+    record->axis = VEC_ZERO;
+    record->aux = aux;
+    record->freer = freer;
+    record->rule = rule;
+    record->colliding = false;
+    record->dead = false;
+    record->refs = 2;
+    record->stamp = broad_phase->tick;
+
+    list_add(broad_phase->tracked[slot1].records, record);
+    list_add(broad_phase->tracked[slot2].records, record);
+    broad_phase->tracked[slot1].live_records++;
+    broad_phase->tracked[slot2].live_records++;
+
+    broad_phase->pair_count++;
+    if (broad_phase->pair_count > broad_phase->pair_bucket_count) {
+        rehash_pairs(broad_phase, broad_phase->pair_bucket_count * 2);
+    }
+    size_t bucket = hash_pair(slot1, slot2) & (broad_phase->pair_bucket_count - 1);
+    record->next = broad_phase->pair_buckets[bucket];
+    broad_phase->pair_buckets[bucket] = record;
+    return record;
+}
+
+static void untrack_body(watch_t *watch) {
+    broad_phase_t *broad_phase = watch->broad_phase;
+    size_t slot = watch->slot;
+    free(watch);
+
+    tracked_t *tracked = &broad_phase->tracked[slot];
+    list_t *records = tracked->records;
+    tracked->records = NULL;
+    for (size_t i = 0; i < list_size(records); i++) {
+        pair_record_t *record = list_get(records, i);
+        if (!record->dead) {
+            kill_record(broad_phase, record);
+        }
+        record_release(record);
+    }
+    list_free(records);
+
+    size_t bucket = hash_pointer(tracked->body) & (broad_phase->body_bucket_count - 1);
+    size_t *link = &broad_phase->body_buckets[bucket];
+    while (*link != slot) {
+        link = &broad_phase->tracked[*link].next;
+    }
+    *link = tracked->next;
+
+    if (tracked->bullet) {
+        broad_phase->bullet_count--;
+    }
+    if (tracked->asleep) {
+        broad_phase->sleeping_changed = true;
+    }
+    tracked->active = false;
+    tracked->body = NULL;
+    tracked->next = broad_phase->free_slot;
+    broad_phase->free_slot = slot;
+    broad_phase->active_count--;
+
+    broad_phase_release(broad_phase);
+}
+
+// ===== TICK =====
+
+static int32_t cell_coord(double position, double cell_size) {
+    double cell = floor(position / cell_size);
+    if (cell < INT32_MIN) {
+        return INT32_MIN;
+    }
+    if (cell > INT32_MAX) {
+        return INT32_MAX;
+    }
+    return (int32_t) cell;
+}
+
+static int compare_cells(const void *a, const void *b) {
+    const cell_entry_t *entry1 = a;
+    const cell_entry_t *entry2 = b;
+    if (entry1->cell != entry2->cell) {
+        return entry1->cell < entry2->cell ? -1 : 1;
+    }
+    if (entry1->slot != entry2->slot) {
+        return entry1->slot < entry2->slot ? -1 : 1;
+    }
+    return 0;
+}
+
+/**
+ * Adds every cell the body's bounding box covers to a cell list.
+ * While there are bullets, the box also covers where the body was last tick,
+ * so a bullet's path meets everything it may have passed through.
+ */
+static void insert_cells(broad_phase_t *broad_phase, size_t slot,
+    cell_entry_t **cells, size_t *cell_count, size_t *cell_capacity) {
+    vector_t min = broad_phase->tracked[slot].shape.bounds.min;
+    vector_t max = broad_phase->tracked[slot].shape.bounds.max;
+    if (broad_phase->tracked[slot].asleep) {
+        double pad = SLEEP_DISTANCE_CELLS * broad_phase->cell_size;
+        min = vec_subtract(min, (vector_t) {pad, pad});
+        max = vec_add(max, (vector_t) {pad, pad});
+    }
+    if (broad_phase->bullet_count > 0) {
+        vector_t motion = broad_phase->tracked[slot].motion;
+        min = vec_subtract(min, (vector_t) {fmax(motion.x, 0), fmax(motion.y, 0)});
+        max = vec_subtract(max, (vector_t) {fmin(motion.x, 0), fmin(motion.y, 0)});
+    }
+
+    int32_t x_min = cell_coord(min.x, broad_phase->cell_size);
+    int32_t x_max = cell_coord(max.x, broad_phase->cell_size);
+    int32_t y_min = cell_coord(min.y, broad_phase->cell_size);
+    int32_t y_max = cell_coord(max.y, broad_phase->cell_size);
+    for (int64_t x = x_min; x <= x_max; x++) {
+        for (int64_t y = y_min; y <= y_max; y++) {
+            *cells = ensure_capacity(*cells, cell_capacity, *cell_count + 1, sizeof(cell_entry_t));
+            cell_entry_t *entry = &(*cells)[(*cell_count)++];
+            entry->cell = (uint64_t) (uint32_t) x << 32 | (uint32_t) y;
+            entry->slot = slot;
+        }
+    }
+}
+
+static void queue_candidate(broad_phase_t *broad_phase, pair_record_t *record) {
+    record->stamp = broad_phase->tick;
+    broad_phase->candidates = ensure_capacity(broad_phase->candidates,
+        &broad_phase->candidate_capacity, broad_phase->candidate_count + 1, sizeof(pair_record_t *));
+    broad_phase->candidates[broad_phase->candidate_count++] = record;
+}
+
+/** Queues every not-yet-seen record registered between the two slots */
+static void add_candidates(broad_phase_t *broad_phase, size_t slot1, size_t slot2) {
+    size_t bucket = hash_pair(slot1, slot2) & (broad_phase->pair_bucket_count - 1);
+    for (pair_record_t *record = broad_phase->pair_buckets[bucket]; record != NULL; record = record->next) {
+        if (record->stamp != broad_phase->tick && record_matches(record, slot1, slot2)) {
+            queue_candidate(broad_phase, record);
+        }
+    }
+}
+
+static bool has_rule_record(broad_phase_t *broad_phase, size_t slot1, size_t slot2, size_t rule) {
+    size_t bucket = hash_pair(slot1, slot2) & (broad_phase->pair_bucket_count - 1);
+    for (pair_record_t *record = broad_phase->pair_buckets[bucket]; record != NULL; record = record->next) {
+        if (record->rule == rule && record_matches(record, slot1, slot2)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Registers a record for each rule that applies to two bodies sharing a cell,
+ * unless they already have one. The pair is then handled like any other
+ * record until the bodies stop sharing a cell while not touching
+ * (see retire_rule_records), or either body is removed.
+ */
+static void apply_rules(broad_phase_t *broad_phase, size_t slot1, size_t slot2) {
+    uint32_t category1 = broad_phase->tracked[slot1].category;
+    uint32_t category2 = broad_phase->tracked[slot2].category;
+    if (!(broad_phase->tracked[slot1].mask & category2) || !(broad_phase->tracked[slot2].mask & category1)) {
+        return;
+    }
+    for (size_t i = 0; i < broad_phase->rule_count; i++) {
+        rule_t *rule = &broad_phase->rules[i];
+        size_t first;
+        size_t second;
+        if ((category1 & rule->category1) && (category2 & rule->category2)) {
+            first = slot1;
+            second = slot2;
+        }
+        else if ((category2 & rule->category1) && (category1 & rule->category2)) {
+            first = slot2;
+            second = slot1;
+        }
+        else {
+            continue;
+        }
+        if (!has_rule_record(broad_phase, slot1, slot2, i)) {
+            pair_record_t *record = add_record(broad_phase, first, second, rule->handlers, rule->aux, NULL, i);
+            record->refs++;
+            broad_phase->rule_records = ensure_capacity(broad_phase->rule_records,
+                &broad_phase->rule_record_capacity, broad_phase->rule_record_count + 1, sizeof(pair_record_t *));
+            broad_phase->rule_records[broad_phase->rule_record_count++] = record;
+            queue_candidate(broad_phase, record);
+        }
+    }
+}
+
+static void check_cell_pair(broad_phase_t *broad_phase, size_t slot1, size_t slot2) {
+    add_candidates(broad_phase, slot1, slot2);
+    if (broad_phase->rule_count > 0) {
+        apply_rules(broad_phase, slot1, slot2);
+    }
+}
+
+/**
+ * Updates whether a body is asleep, once per tick. A body falls asleep once it
+ * has stayed near one spot for long enough, and wakes once it leaves it.
+ * Its velocity is left alone, so sleeping never changes how it moves.
+ */
+static void update_sleep(broad_phase_t *broad_phase, tracked_t *tracked, vector_t centroid) {
+    double sleep_distance = SLEEP_DISTANCE_CELLS * broad_phase->cell_size;
+    vector_t drift = vec_subtract(centroid, tracked->rest_center);
+    bool resting = fabs(drift.x) <= sleep_distance && fabs(drift.y) <= sleep_distance;
+    if (tracked->asleep) {
+        if (!resting) {
+            tracked->asleep = false;
+            tracked->rest_center = centroid;
+            tracked->still_ticks = 0;
+            broad_phase->sleeping_changed = true;
+        }
+        return;
+    }
+
+    if (!resting) {
+        tracked->rest_center = centroid;
+        tracked->still_ticks = 0;
+        return;
+    }
+    tracked->still_ticks++;
+    size_t sleep_ticks = body_get_mass(tracked->body) == INFINITY ? STATIC_SLEEP_TICKS : SLEEP_TICKS;
+    if (tracked->still_ticks >= sleep_ticks) {
+        // Measure drift from the pose the sleeping cells are built from
+        tracked->rest_center = centroid;
+        tracked->asleep = true;
+        broad_phase->sleeping_changed = true;
+    }
+}
+
+static void rebuild_sleeping_cells(broad_phase_t *broad_phase) {
+    broad_phase->sleeping_cell_count = 0;
+    for (size_t slot = 0; slot < broad_phase->tracked_size; slot++) {
+        tracked_t *tracked = &broad_phase->tracked[slot];
+        if (tracked->active && tracked->asleep) {
+            insert_cells(broad_phase, slot, &broad_phase->sleeping_cells,
+                &broad_phase->sleeping_cell_count, &broad_phase->sleeping_cell_capacity);
+        }
+    }
+    if (broad_phase->sleeping_cell_count > 1) {
+        qsort(broad_phase->sleeping_cells, broad_phase->sleeping_cell_count, sizeof(cell_entry_t), compare_cells);
+    }
+    broad_phase->sleeping_changed = false;
+}
+
+/** Finds the first sleeping cell entry at or after a cell */
+static size_t find_sleeping_cell(broad_phase_t *broad_phase, uint64_t cell) {
+    size_t lo = 0;
+    size_t hi = broad_phase->sleeping_cell_count;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (broad_phase->sleeping_cells[mid].cell < cell) {
+            lo = mid + 1;
+        }
+        else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+static void find_candidates(broad_phase_t *broad_phase) {
+    broad_phase->cell_count = 0;
+    broad_phase->candidate_count = 0;
+    double max_sweep = MAX_SWEEP_CELLS * broad_phase->cell_size;
+    // Moves every cached shape in one batch, so the views below are already current
+    shape_cache_refresh(broad_phase->shapes);
+    for (size_t slot = 0; slot < broad_phase->tracked_size; slot++) {
+        tracked_t *tracked = &broad_phase->tracked[slot];
+        if (!tracked->active) {
+            continue;
+        }
+        vector_t centroid = body_get_centroid(tracked->body);
+        bool moved = centroid.x != tracked->previous.x || centroid.y != tracked->previous.y;
+        tracked->motion = vec_subtract(centroid, tracked->previous);
+        tracked->previous = centroid;
+        if (fabs(tracked->motion.x) > max_sweep || fabs(tracked->motion.y) > max_sweep) {
+            tracked->motion = VEC_ZERO;
+        }
+        if (tracked->live_records == 0 && tracked->category == 0) {
+            continue;
+        }
+        update_sleep(broad_phase, tracked, centroid);
+        if (tracked->asleep && !moved) {
+            continue;
+        }
+        // A sleeping body that drifted within its padded cells is checked like
+        // an awake one this tick, so its contacts with sleeping bodies still hold
+        tracked->shape = shape_cache_view(broad_phase->shapes, tracked->body);
+        insert_cells(broad_phase, slot, &broad_phase->cells,
+            &broad_phase->cell_count, &broad_phase->cell_capacity);
+    }
+    if (broad_phase->sleeping_changed) {
+        rebuild_sleeping_cells(broad_phase);
+    }
+
+    if (broad_phase->cell_count > 1) {
+        qsort(broad_phase->cells, broad_phase->cell_count, sizeof(cell_entry_t), compare_cells);
+    }
+
+    // Awake bodies are paired with each other and with sleeping bodies in the
+    // same cell; two still sleeping bodies are never checked against each other
+    size_t start = 0;
+    while (start < broad_phase->cell_count) {
+        uint64_t cell = broad_phase->cells[start].cell;
+        size_t end = start + 1;
+        while (end < broad_phase->cell_count && broad_phase->cells[end].cell == cell) {
+            end++;
+        }
+        size_t sleeping_start = find_sleeping_cell(broad_phase, cell);
+        size_t sleeping_end = sleeping_start;
+        while (sleeping_end < broad_phase->sleeping_cell_count
+            && broad_phase->sleeping_cells[sleeping_end].cell == cell) {
+            sleeping_end++;
+        }
+        for (size_t i = start; i < end; i++) {
+            size_t slot = broad_phase->cells[i].slot;
+            for (size_t j = i + 1; j < end; j++) {
+                check_cell_pair(broad_phase, slot, broad_phase->cells[j].slot);
+            }
+            for (size_t j = sleeping_start; j < sleeping_end; j++) {
+                // A drifting sleeper is in both lists
+                if (broad_phase->sleeping_cells[j].slot != slot) {
+                    check_cell_pair(broad_phase, slot, broad_phase->sleeping_cells[j].slot);
+                }
+            }
+        }
+        start = end;
+    }
+}
+
+/**
+ * Checks a pair involving a bullet along the paths the bodies took since
+ * the last tick. On a hit, the bullet is moved back to the point of contact.
+ */
+static collision_info_t sweep_pair(broad_phase_t *broad_phase, pair_record_t *record) {
+    tracked_t *tracked1 = &broad_phase->tracked[record->slot1];
+    tracked_t *tracked2 = &broad_phase->tracked[record->slot2];
+    swept_collision_info_t swept = packed_find_swept_collision(
+        tracked1->shape.polygon, tracked1->motion, tracked2->shape.polygon, tracked2->motion);
+    collision_info_t info = {.collided = swept.collided, .axis = swept.axis};
+    if (!swept.collided) {
+        return info;
+    }
+
+    vector_t rewind = vec_multiply(1 - swept.time, vec_subtract(tracked1->motion, tracked2->motion));
+    tracked_t *bullet = tracked1;
+    if (!tracked1->bullet) {
+        bullet = tracked2;
+        rewind = vec_negate(rewind);
+    }
+    vector_t centroid = vec_subtract(body_get_centroid(bullet->body), rewind);
+    body_set_centroid(bullet->body, centroid);
+    bullet->previous = centroid;
+    bullet->shape = shape_cache_view(broad_phase->shapes, bullet->body);
+    return info;
+}
+
+static void end_contact(pair_record_t *record) {
+    record->colliding = false;
+    if (record->handlers.end != NULL) {
+        record->handlers.end(record->body1, record->body2, record->axis, record->aux);
+    }
+}
+
+/**
+ * Drops the rule records of pairs that did not share a cell this tick and are
+ * not touching. A rule makes the record again if they meet later, so bodies
+ * that never die, like pooled ones, only keep records for their current neighbors.
+ */
+static void retire_rule_records(broad_phase_t *broad_phase) {
+    size_t kept = 0;
+    for (size_t i = 0; i < broad_phase->rule_record_count; i++) {
+        pair_record_t *record = broad_phase->rule_records[i];
+        if (!record->dead && (record->stamp == broad_phase->tick || record->colliding)) {
+            broad_phase->rule_records[kept++] = record;
+            continue;
+        }
+        if (!record->dead) {
+            kill_record(broad_phase, record);
+        }
+        record_release(record);
+    }
+    broad_phase->rule_record_count = kept;
+}
+
+static void broad_phase_tick(broad_phase_t *broad_phase) {
+    broad_phase->tick++;
+    find_candidates(broad_phase);
+
+    // Handlers may register new pairs, so only index into the tables here
+    size_t candidate_count = broad_phase->candidate_count;
+    for (size_t i = 0; i < candidate_count; i++) {
+        pair_record_t *record = broad_phase->candidates[i];
+        collision_info_t info = shape_view_find_collision(
+            &broad_phase->tracked[record->slot1].shape, &broad_phase->tracked[record->slot2].shape);
+        if (!info.collided && !record->colliding
+            && (broad_phase->tracked[record->slot1].bullet || broad_phase->tracked[record->slot2].bullet)) {
+            info = sweep_pair(broad_phase, record);
+        }
+        if (!info.collided) {
+            if (record->colliding) {
+                end_contact(record);
+            }
+            continue;
+        }
+        record->axis = info.axis;
+        if (!record->colliding) {
+            record->colliding = true;
+            record->refs++;
+            broad_phase->touching = ensure_capacity(broad_phase->touching,
+                &broad_phase->touching_capacity, broad_phase->touching_count + 1, sizeof(pair_record_t *));
+            broad_phase->touching[broad_phase->touching_count++] = record;
+            if (record->handlers.begin != NULL) {
+                record->handlers.begin(record->body1, record->body2, info.axis, record->aux);
+            }
+        }
+        else if (record->handlers.persist != NULL) {
+            record->handlers.persist(record->body1, record->body2, info.axis, record->aux);
+        }
+    }
+
+    // Pairs that left each other's cells are no longer colliding.
+    // Pairs of sleeping bodies are not checked, but are still touching.
+    size_t kept = 0;
+    for (size_t i = 0; i < broad_phase->touching_count; i++) {
+        pair_record_t *record = broad_phase->touching[i];
+        if (record->stamp != broad_phase->tick && record->colliding && !record->dead
+            && !(broad_phase->tracked[record->slot1].asleep && broad_phase->tracked[record->slot2].asleep)) {
+            end_contact(record);
+        }
+        if (record->colliding && !record->dead) {
+            broad_phase->touching[kept++] = record;
+        }
+        else {
+            record->colliding = false;
+            record_release(record);
+        }
+    }
+    broad_phase->touching_count = kept;
+    retire_rule_records(broad_phase);
+}
+
+// ===== PUBLIC API =====
+
+broad_phase_t *create_broad_phase(scene_t *scene, double cell_size) {
+    assert(cell_size > 0);
+    broad_phase_t *broad_phase = calloc(1, sizeof(broad_phase_t));
+    assert(broad_phase != NULL);
+    broad_phase->scene = scene;
+    broad_phase->cell_size = cell_size;
+    broad_phase->refs = 1;
+    broad_phase->free_slot = NO_SLOT;
+    broad_phase->shapes = create_shape_cache(scene);
+    rehash_bodies(broad_phase, INITIAL_CAPACITY);
+    rehash_pairs(broad_phase, INITIAL_CAPACITY);
+    scene_add_force_creator(scene, (force_creator_t) broad_phase_tick, broad_phase,
+        (free_func_t) broad_phase_release);
+    return broad_phase;
+}
+
+scene_t *broad_phase_get_scene(broad_phase_t *broad_phase) {
+    return broad_phase->scene;
+}
+
+shape_cache_t *broad_phase_get_shapes(broad_phase_t *broad_phase) {
+    return broad_phase->shapes;
+}
+
+void broad_phase_add_contact(
+    broad_phase_t *broad_phase,
+    body_t *body1,
+    body_t *body2,
+    contact_handlers_t handlers,
+    void *aux,
+    free_func_t freer
+) {
+    assert(body1 != body2);
+    size_t slot1 = track_body(broad_phase, body1);
+    size_t slot2 = track_body(broad_phase, body2);
+    add_record(broad_phase, slot1, slot2, handlers, aux, freer, NO_RULE);
+}
+
+void broad_phase_add_collision(
+    broad_phase_t *broad_phase,
+    body_t *body1,
+    body_t *body2,
+    collision_handler_t handler,
+    void *aux,
+    free_func_t freer
+) {
+    broad_phase_add_contact(broad_phase, body1, body2, (contact_handlers_t) {.begin = handler}, aux, freer);
+}
+
+void broad_phase_set_bullet(broad_phase_t *broad_phase, body_t *body, bool bullet) {
+    // track_body may move the tracked array, so call it before indexing
+    size_t slot = track_body(broad_phase, body);
+    tracked_t *tracked = &broad_phase->tracked[slot];
+    if (tracked->bullet != bullet) {
+        tracked->bullet = bullet;
+        if (bullet) {
+            broad_phase->bullet_count++;
+        }
+        else {
+            broad_phase->bullet_count--;
+        }
+    }
+}
+
+void broad_phase_set_category(broad_phase_t *broad_phase, body_t *body, uint32_t category, uint32_t mask) {
+    size_t slot = track_body(broad_phase, body);
+    tracked_t *tracked = &broad_phase->tracked[slot];
+    tracked->category = category;
+    tracked->mask = mask;
+}
+
+void broad_phase_add_contact_rule(
+    broad_phase_t *broad_phase,
+    uint32_t category1,
+    uint32_t category2,
+    contact_handlers_t handlers,
+    void *aux,
+    free_func_t freer
+) {
+    broad_phase->rules = ensure_capacity(broad_phase->rules,
+        &broad_phase->rule_capacity, broad_phase->rule_count + 1, sizeof(rule_t));
+    broad_phase->rules[broad_phase->rule_count++] = (rule_t) {category1, category2, handlers, aux, freer};
+}
+
+void broad_phase_add_rule(
+    broad_phase_t *broad_phase,
+    uint32_t category1,
+    uint32_t category2,
+    collision_handler_t handler,
+    void *aux,
+    free_func_t freer
+) {
+    broad_phase_add_contact_rule(broad_phase, category1, category2, (contact_handlers_t) {.begin = handler}, aux, freer);
+}
+
+static double reduced_mass(body_t *body1, body_t *body2) {
+    double mass1 = body_get_mass(body1);
+    double mass2 = body_get_mass(body2);
+    if (mass1 == INFINITY) {
+        return mass2;
+    }
+    if (mass2 == INFINITY) {
+        return mass1;
+    }
+    return mass1 * mass2 / (mass1 + mass2);
+}
+
+static void physics_collision_handler(body_t *body1, body_t *body2, vector_t axis, void *aux) {
+    double elasticity = *(double *) aux;
+    double u1 = vec_dot(axis, body_get_velocity(body1));
+    double u2 = vec_dot(axis, body_get_velocity(body2));
+    double impulse = reduced_mass(body1, body2) * (1 + elasticity) * (u2 - u1);
+
+    body_add_impulse(body1, vec_multiply(impulse, axis));
+    body_add_impulse(body2, vec_multiply(-impulse, axis));
+}
+
+/**
+ * While two bodies stay overlapped after bouncing, stops them from moving
+ * any further into each other. Without this, a ball resting on a peg is
+ * pulled into it by gravity until it falls through or pops out.
+ */
+static void physics_resting_handler(body_t *body1, body_t *body2, vector_t axis, void *aux) {
+    double u1 = vec_dot(axis, body_get_velocity(body1));
+    double u2 = vec_dot(axis, body_get_velocity(body2));
+    // The axis can point either way between the bodies
+    double side = vec_dot(axis, vec_subtract(body_get_centroid(body2), body_get_centroid(body1)));
+    double closing = side >= 0 ? u1 - u2 : u2 - u1;
+    if (closing <= 0) {
+        return;
+    }
+    double impulse = reduced_mass(body1, body2) * (u2 - u1);
+
+    body_add_impulse(body1, vec_multiply(impulse, axis));
+    body_add_impulse(body2, vec_multiply(-impulse, axis));
+}
+
+static const contact_handlers_t PHYSICS_HANDLERS = {
+    .begin = physics_collision_handler,
+    .persist = physics_resting_handler
+};
+
+void broad_phase_add_physics_collision(
+    broad_phase_t *broad_phase,
+    double elasticity,
+    body_t *body1,
+    body_t *body2
+) {
+    double *aux = malloc(sizeof(double));
+    assert(aux != NULL);
+    *aux = elasticity;
+    broad_phase_add_contact(broad_phase, body1, body2, PHYSICS_HANDLERS, aux, free);
+}
+
+static void destructive_collision_handler(body_t *body1, body_t *body2, vector_t axis, void *aux) {
+    body_remove(body1);
+    body_remove(body2);
+}
+
+void broad_phase_add_destructive_collision(
+    broad_phase_t *broad_phase,
+    body_t *body1,
+    body_t *body2
+) {
+    broad_phase_add_collision(broad_phase, body1, body2, destructive_collision_handler, NULL, NULL);
+}
+
+void broad_phase_add_physics_rule(
+    broad_phase_t *broad_phase,
+    double elasticity,
+    uint32_t category1,
+    uint32_t category2
+) {
+    double *aux = malloc(sizeof(double));
+    assert(aux != NULL);
+    *aux = elasticity;
+    broad_phase_add_contact_rule(broad_phase, category1, category2, PHYSICS_HANDLERS, aux, free);
+}
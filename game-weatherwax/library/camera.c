@@ -0,0 +1,38 @@
+#include <assert.h>
+#include <stdlib.h>
+#include "camera.h"
+
+struct camera {
+    vector_t position;
+};
+
+camera_t *camera_init(void) {
+    camera_t *camera = malloc(sizeof(camera_t));
+    assert(camera != NULL);
+    camera->position = VEC_ZERO;
+    return camera;
+}
+
+void camera_free(camera_t *camera) {
+    free(camera);
+}
+
+vector_t camera_get_position(camera_t *camera) {
+    return camera->position;
+}
+
+void camera_set_position(camera_t *camera, vector_t position) {
+    camera->position = position;
+}
+
+void camera_move(camera_t *camera, vector_t offset) {
+    camera->position = vec_add(camera->position, offset);
+}
+
+vector_t camera_to_view(camera_t *camera, vector_t point) {
+    return vec_subtract(point, camera->position);
+}
+
+vector_t camera_to_world(camera_t *camera, vector_t point) {
+    return vec_add(point, camera->position);
+}
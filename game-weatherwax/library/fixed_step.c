@@ -0,0 +1,144 @@
+#include <assert.h>
+#include <stdlib.h>
+#include "body.h"
+#include "fixed_step.h"
+
+static const size_t INITIAL_CAPACITY = 16;
+
+/** A body's pose at some point in time */
+typedef struct pose {
+    body_t *body;
+    vector_t centroid;
+    double angle;
+} pose_t;
+
+typedef struct poses {
+    pose_t *data;
+    size_t size;
+    size_t capacity;
+} poses_t;
+
+struct fixed_step {
+    double step;
+    size_t max_substeps;
+    double accumulator;
+    // Every body's pose before the last step, in scene order
+    poses_t previous;
+    // Every body's pose to draw, from fixed_step_interpolate
+    draw_pose_t *drawn;
+    size_t drawn_capacity;
+};
+
+static void poses_init(poses_t *poses) {
+    poses->data = malloc(INITIAL_CAPACITY * sizeof(pose_t));
+    assert(poses->data != NULL);
+    poses->size = 0;
+    poses->capacity = INITIAL_CAPACITY;
+}
+
+static void poses_add(poses_t *poses, body_t *body, vector_t centroid, double angle) {
+    if (poses->size == poses->capacity) {
+        poses->capacity *= 2;
+        poses->data = realloc(poses->data, poses->capacity * sizeof(pose_t));
+        assert(poses->data != NULL);
+    }
+    poses->data[poses->size++] = (pose_t) {body, centroid, angle};
+}
+
+static void snapshot(fixed_step_t *stepper, scene_t *scene) {
+    stepper->previous.size = 0;
+    for (size_t i = 0; i < scene_bodies(scene); i++) {
+        body_t *body = scene_get_body(scene, i);
+        poses_add(&stepper->previous, body, body_get_centroid(body), body_get_rotation(body));
+    }
+}
+
+fixed_step_t *fixed_step_init(double hz, size_t max_substeps) {
+    assert(hz > 0);
+    assert(max_substeps > 0);
+    fixed_step_t *stepper = malloc(sizeof(fixed_step_t));
+    assert(stepper != NULL);
+    stepper->step = 1 / hz;
+    stepper->max_substeps = max_substeps;
+    stepper->accumulator = 0;
+    poses_init(&stepper->previous);
+    stepper->drawn = malloc(INITIAL_CAPACITY * sizeof(draw_pose_t));
+    assert(stepper->drawn != NULL);
+    stepper->drawn_capacity = INITIAL_CAPACITY;
+    return stepper;
+}
+
+void fixed_step_free(fixed_step_t *stepper) {
+    free(stepper->previous.data);
+    free(stepper->drawn);
+    free(stepper);
+}
+
+size_t fixed_step_advance(fixed_step_t *stepper, scene_t *scene, double dt) {
+    stepper->accumulator += dt;
+    size_t steps = (size_t) (stepper->accumulator / stepper->step);
+    if (steps > stepper->max_substeps) {
+        steps = stepper->max_substeps;
+        stepper->accumulator = steps * stepper->step;
+    }
+
+    for (size_t i = 0; i < steps; i++) {
+        if (i + 1 == steps) {
+            snapshot(stepper, scene);
+        }
+        scene_tick(scene, stepper->step);
+        stepper->accumulator -= stepper->step;
+    }
+    if (stepper->accumulator < 0) {
+        stepper->accumulator = 0;
+    }
+    return steps;
+}
+
+double fixed_step_alpha(fixed_step_t *stepper) {
+    double alpha = stepper->accumulator / stepper->step;
+    return alpha < 1 ? alpha : 0;
+}
+
+/** Makes room for a pose to draw for each of a scene's bodies */
+static void reserve_drawn(fixed_step_t *stepper, size_t count) {
+    if (count <= stepper->drawn_capacity) {
+        return;
+    }
+    while (stepper->drawn_capacity < count) {
+        stepper->drawn_capacity *= 2;
+    }
+    stepper->drawn = realloc(stepper->drawn, stepper->drawn_capacity * sizeof(draw_pose_t));
+    assert(stepper->drawn != NULL);
+}
+
+const draw_pose_t *fixed_step_interpolate(fixed_step_t *stepper, scene_t *scene) {
+    double alpha = fixed_step_alpha(stepper);
+    size_t bodies = scene_bodies(scene);
+    reserve_drawn(stepper, bodies);
+
+    // Ticking only removes bodies and appends new ones, so the bodies
+    // that existed before the last step are still in the same order
+    size_t j = 0;
+    for (size_t i = 0; i < bodies; i++) {
+        body_t *body = scene_get_body(scene, i);
+        vector_t centroid = body_get_centroid(body);
+        double angle = body_get_rotation(body);
+        while (j < stepper->previous.size && stepper->previous.data[j].body != body) {
+            j++;
+        }
+        if (j == stepper->previous.size) {
+            // Added during the last step, so drawn where it is
+            stepper->drawn[i] = (draw_pose_t) {centroid, angle};
+            continue;
+        }
+
+        pose_t *before = &stepper->previous.data[j++];
+        vector_t offset = vec_multiply(alpha - 1, vec_subtract(centroid, before->centroid));
+        stepper->drawn[i] = (draw_pose_t) {
+            vec_add(centroid, offset),
+            angle + (alpha - 1) * (angle - before->angle)
+        };
+    }
+    return stepper->drawn;
+}
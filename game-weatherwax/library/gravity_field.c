@@ -0,0 +1,347 @@
+#include <assert.h>
+#include <math.h>
+#include <stdlib.h>
+#include "body_watch.h"
+#include "gravity_field.h"
+#include "thread_pool.h"
+#include "vector.h"
+
+// Matches create_newtonian_gravity, which skips pairs closer than this
+static const double MIN_DISTANCE = 30.0;
+// Coincident bodies stop splitting cells past this depth
+static const size_t MAX_DEPTH = 48;
+static const size_t INITIAL_CAPACITY = 16;
+
+#define EMPTY -1
+#define INTERNAL -2
+#define CLUSTER -3
+
+typedef struct node {
+    vector_t center;
+    double half_size;
+    double mass;
+    // Mass-weighted sum of positions while building, center of mass after
+    vector_t mass_center;
+    long child[4];
+    // Index of the single body in a leaf, or EMPTY/INTERNAL/CLUSTER
+    long body;
+} node_t;
+
+typedef struct member {
+    body_t *body;
+    vector_t position;
+    double mass;
+} member_t;
+
+/** Tree-walk stack; one per thread, so walks can run in parallel */
+typedef struct walk_stack {
+    long *data;
+    size_t capacity;
+} walk_stack_t;
+
+typedef struct watch {
+    gravity_field_t *field;
+    size_t index;
+} watch_t;
+
+struct gravity_field {
+    double G;
+    double theta;
+    scene_t *scene;
+    size_t refs;
+
+    member_t *members;
+    watch_t **watches;
+    size_t member_count;
+    size_t member_capacity;
+    size_t watch_capacity;
+
+    node_t *nodes;
+    size_t node_count;
+    size_t node_capacity;
+
+    // Each member's force this tick, filled in before any is applied
+    vector_t *forces;
+    size_t force_capacity;
+
+    // NULL while the field runs on one thread
+    thread_pool_t *pool;
+    walk_stack_t *stacks;
+    size_t thread_count;
+};
+
+static void *ensure_capacity(void *array, size_t *capacity, size_t needed, size_t elem_size) {
+    if (needed <= *capacity) {
+        return array;
+    }
+    size_t new_capacity = *capacity == 0 ? INITIAL_CAPACITY : *capacity;
+    while (new_capacity < needed) {
+        new_capacity *= 2;
+    }
+    array = realloc(array, new_capacity * elem_size);
+    assert(array != NULL);
+    *capacity = new_capacity;
+    return array;
+}
+
+static void gravity_field_release(gravity_field_t *field) {
+    field->refs--;
+    if (field->refs == 0) {
+        free(field->members);
+        free(field->watches);
+        free(field->nodes);
+        free(field->forces);
+        for (size_t i = 0; i < field->thread_count; i++) {
+            free(field->stacks[i].data);
+        }
+        free(field->stacks);
+        if (field->pool != NULL) {
+            thread_pool_free(field->pool);
+        }
+        free(field);
+    }
+}
+
+/** Swaps the last member into the removed member's place */
+static void remove_member(watch_t *watch) {
+    gravity_field_t *field = watch->field;
+    size_t index = watch->index;
+    size_t last = field->member_count - 1;
+    if (index != last) {
+        field->members[index] = field->members[last];
+        field->watches[index] = field->watches[last];
+        field->watches[index]->index = index;
+    }
+    field->member_count--;
+    free(watch);
+    gravity_field_release(field);
+}
+
+// ===== QUADTREE =====
+
+static long add_node(gravity_field_t *field, vector_t center, double half_size) {
+    field->nodes = ensure_capacity(field->nodes, &field->node_capacity,
+        field->node_count + 1, sizeof(node_t));
+    node_t *node = &field->nodes[field->node_count];
+    node->center = center;
+    node->half_size = half_size;
+    node->mass = 0.0;
+    node->mass_center = VEC_ZERO;
+    for (size_t i = 0; i < 4; i++) {
+        node->child[i] = EMPTY;
+    }
+    node->body = EMPTY;
+    return (long) field->node_count++;
+}
+
+static size_t quadrant(node_t *node, vector_t position) {
+    return (position.x >= node->center.x ? 1 : 0) + (position.y >= node->center.y ? 2 : 0);
+}
+
+/** Returns the child of a node in the given quadrant, creating it if needed */
+static long get_child(gravity_field_t *field, long index, size_t q) {
+    if (field->nodes[index].child[q] == EMPTY) {
+        node_t *node = &field->nodes[index];
+        double half = node->half_size / 2;
+        vector_t center = {
+            node->center.x + (q & 1 ? half : -half),
+            node->center.y + (q & 2 ? half : -half)
+        };
+        long child = add_node(field, center, half);
+        field->nodes[index].child[q] = child;
+    }
+    return field->nodes[index].child[q];
+}
+
+static void accumulate(node_t *node, member_t *member) {
+    node->mass += member->mass;
+    node->mass_center = vec_add(node->mass_center, vec_multiply(member->mass, member->position));
+}
+
+static void insert_member(gravity_field_t *field, size_t index) {
+    member_t *member = &field->members[index];
+    long current = 0;
+    size_t depth = 0;
+    while (true) {
+        node_t *node = &field->nodes[current];
+        if (node->body == EMPTY) {
+            node->body = (long) index;
+            accumulate(node, member);
+            return;
+        }
+        if (node->body == CLUSTER || (node->body >= 0 && depth >= MAX_DEPTH)) {
+            node->body = CLUSTER;
+            accumulate(node, member);
+            return;
+        }
+        if (node->body >= 0) {
+            // Push the resident body down a level
+            member_t *resident = &field->members[node->body];
+            long child = get_child(field, current, quadrant(node, resident->position));
+            node = &field->nodes[current];
+            field->nodes[child].body = node->body;
+            accumulate(&field->nodes[child], resident);
+            node->body = INTERNAL;
+        }
+        accumulate(node, member);
+        current = get_child(field, current, quadrant(node, member->position));
+        depth++;
+    }
+}
+
+static void build_tree(gravity_field_t *field) {
+    vector_t min = {INFINITY, INFINITY};
+    vector_t max = {-INFINITY, -INFINITY};
+    for (size_t i = 0; i < field->member_count; i++) {
+        member_t *member = &field->members[i];
+        member->position = body_get_centroid(member->body);
+        member->mass = body_get_mass(member->body);
+        min.x = fmin(min.x, member->position.x);
+        min.y = fmin(min.y, member->position.y);
+        max.x = fmax(max.x, member->position.x);
+        max.y = fmax(max.y, member->position.y);
+    }
+
+    field->node_count = 0;
+    vector_t center = vec_multiply(0.5, vec_add(min, max));
+    // Pad slightly so bodies on the far edge stay inside the root
+    double half_size = fmax(max.x - min.x, max.y - min.y) / 2 * 1.001 + 1.0;
+    add_node(field, center, half_size);
+    for (size_t i = 0; i < field->member_count; i++) {
+        insert_member(field, i);
+    }
+
+    for (size_t i = 0; i < field->node_count; i++) {
+        node_t *node = &field->nodes[i];
+        if (node->mass > 0) {
+            node->mass_center = vec_multiply(1 / node->mass, node->mass_center);
+        }
+    }
+}
+
+static bool node_contains(const node_t *node, vector_t position) {
+    return fabs(position.x - node->center.x) <= node->half_size
+        && fabs(position.y - node->center.y) <= node->half_size;
+}
+
+/**
+ * Walks the tree, adding the pull of every far-enough cell on one member.
+ * Only reads the tree, so it may run for several members at once.
+ */
+static vector_t field_force(gravity_field_t *field, size_t index, walk_stack_t *stack) {
+    member_t *member = &field->members[index];
+    vector_t force = VEC_ZERO;
+    size_t stack_size = 0;
+    stack->data = ensure_capacity(stack->data, &stack->capacity, 1, sizeof(long));
+    stack->data[stack_size++] = 0;
+
+    while (stack_size > 0) {
+        node_t *node = &field->nodes[stack->data[--stack_size]];
+        if (node->mass == 0 || node->body == (long) index) {
+            continue;
+        }
+        vector_t r = vec_subtract(node->mass_center, member->position);
+        double distance = sqrt(vec_dot(r, r));
+        // A cell holding the member itself is always opened, however large theta is,
+        // so a member never pulls on itself through its own cell's center of mass
+        bool far_enough = 2 * node->half_size < field->theta * distance
+            && !node_contains(node, member->position);
+        if (node->body != INTERNAL || far_enough) {
+            if (distance > MIN_DISTANCE) {
+                double magnitude = field->G * member->mass * node->mass / pow(distance, 3);
+                force = vec_add(force, vec_multiply(magnitude, r));
+            }
+            continue;
+        }
+        stack->data = ensure_capacity(stack->data, &stack->capacity,
+            stack_size + 4, sizeof(long));
+        for (size_t q = 0; q < 4; q++) {
+            if (node->child[q] != EMPTY) {
+                stack->data[stack_size++] = node->child[q];
+            }
+        }
+    }
+    return force;
+}
+
+static void compute_force(void *aux, size_t index, size_t thread) {
+    gravity_field_t *field = aux;
+    field->forces[index] = field_force(field, index, &field->stacks[thread]);
+}
+
+static void gravity_field_tick(gravity_field_t *field) {
+    if (field->member_count < 2) {
+        return;
+    }
+    build_tree(field);
+    field->forces = ensure_capacity(field->forces, &field->force_capacity,
+        field->member_count, sizeof(vector_t));
+    if (field->pool != NULL) {
+        thread_pool_for(field->pool, field->member_count, compute_force, field);
+    }
+    else {
+        for (size_t i = 0; i < field->member_count; i++) {
+            compute_force(field, i, 0);
+        }
+    }
+
+    // Each force only depends on the tree, and they are applied in member order,
+    // so the result is the same no matter how many threads computed them
+    for (size_t i = 0; i < field->member_count; i++) {
+        body_add_force(field->members[i].body, field->forces[i]);
+    }
+}
+
+// ===== PUBLIC API =====
+
+gravity_field_t *create_gravity_field(scene_t *scene, double G, double theta) {
+    assert(theta >= 0);
+    gravity_field_t *field = calloc(1, sizeof(gravity_field_t));
+    assert(field != NULL);
+    field->G = G;
+    field->theta = theta;
+    field->scene = scene;
+    field->refs = 1;
+    field->thread_count = 1;
+    field->stacks = calloc(1, sizeof(walk_stack_t));
+    assert(field->stacks != NULL);
+    scene_add_force_creator(scene, (force_creator_t) gravity_field_tick, field,
+        (free_func_t) gravity_field_release);
+    return field;
+}
+
+void gravity_field_add_body(gravity_field_t *field, body_t *body) {
+    size_t index = field->member_count++;
+    field->members = ensure_capacity(field->members, &field->member_capacity,
+        field->member_count, sizeof(member_t));
+    field->watches = ensure_capacity(field->watches, &field->watch_capacity,
+        field->member_count, sizeof(watch_t *));
+
+    watch_t *watch = malloc(sizeof(watch_t));
+    assert(watch != NULL);
+    watch->field = field;
+    watch->index = index;
+    field->members[index].body = body;
+    field->watches[index] = watch;
+    field->refs++;
+    body_watch(field->scene, body, (free_func_t) remove_member, watch);
+}
+
+void gravity_field_set_threads(gravity_field_t *field, size_t threads) {
+    assert(threads > 0);
+    if (field->pool != NULL) {
+        thread_pool_free(field->pool);
+        field->pool = NULL;
+    }
+    for (size_t i = 0; i < field->thread_count; i++) {
+        free(field->stacks[i].data);
+    }
+    free(field->stacks);
+
+    field->thread_count = threads;
+    field->stacks = calloc(threads, sizeof(walk_stack_t));
+    assert(field->stacks != NULL);
+    if (threads > 1) {
+        field->pool = thread_pool_init(threads);
+    }
+}
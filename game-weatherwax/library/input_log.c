@@ -0,0 +1,312 @@
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <SDL2/SDL.h>
+#include "body.h"
+#include "input_log.h"
+#include "list.h"
+
+static const char MAGIC[4] = {'I', 'N', 'L', '1'};
+static const size_t HEADER_SIZE = sizeof(MAGIC) + sizeof(uint64_t);
+// Kind byte, then the key and its held time
+static const size_t KEY_RECORD_SIZE = 2 + sizeof(double);
+// Kind byte, then dt
+static const size_t TICK_RECORD_SIZE = 1 + sizeof(double);
+// Kind byte, then the checksum of the final scene
+static const size_t END_RECORD_SIZE = 1 + sizeof(uint64_t);
+// FNV-1a, 64-bit
+static const uint64_t CHECKSUM_BASIS = 14695981039346656037ULL;
+static const uint64_t CHECKSUM_PRIME = 1099511628211ULL;
+static const size_t READ_CHUNK = 1 << 16;
+
+typedef enum {
+    RECORD_TICK,
+    RECORD_KEY_PRESSED,
+    RECORD_KEY_RELEASED,
+    RECORD_END
+} record_kind_t;
+
+/** How a replay's final scene compares with the recording's */
+typedef enum {
+    // The replay has not ended, or the recording has no checksum
+    CHECK_UNKNOWN,
+    CHECK_MATCHED,
+    CHECK_DIVERGED
+} check_t;
+
+static const char *CHECK_NAMES[] = {"unknown", "matched", "diverged"};
+
+struct input_log {
+    uint64_t seed;
+
+    // Set when recording
+    FILE *file;
+
+    // Set when replaying: the whole file, read up front so replay does no I/O
+    uint8_t *data;
+    size_t size;
+    size_t cursor;
+    size_t ticks;
+    double simulated;
+    // When the first frame was replayed, or negative before then
+    double started;
+    // The recording's final checksum, once the replay reaches it
+    bool has_checksum;
+    uint64_t checksum;
+    check_t check;
+};
+
+static double now(void) {
+    struct timespec time;
+    timespec_get(&time, TIME_UTC);
+    return time.tv_sec + time.tv_nsec * 1e-9;
+}
+
+static void write_u64(uint8_t *bytes, uint64_t value) {
+    for (size_t i = 0; i < sizeof(uint64_t); i++) {
+        bytes[i] = (uint8_t) (value >> (8 * i));
+    }
+}
+
+static uint64_t read_u64(const uint8_t *bytes) {
+    uint64_t value = 0;
+    for (size_t i = 0; i < sizeof(uint64_t); i++) {
+        value |= (uint64_t) bytes[i] << (8 * i);
+    }
+    return value;
+}
+
+static void write_double(uint8_t *bytes, double value) {
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    write_u64(bytes, bits);
+}
+
+static double read_double(const uint8_t *bytes) {
+    uint64_t bits = read_u64(bytes);
+    double value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+static uint64_t checksum_double(uint64_t hash, double value) {
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    for (size_t i = 0; i < sizeof(uint64_t); i++) {
+        hash = (hash ^ (uint8_t) (bits >> (8 * i))) * CHECKSUM_PRIME;
+    }
+    return hash;
+}
+
+/** Hashes the exact bits of every body's vertices, position, velocity and rotation, in scene order */
+static uint64_t scene_checksum(scene_t *scene) {
+    uint64_t hash = CHECKSUM_BASIS;
+    size_t bodies = scene_bodies(scene);
+    hash = checksum_double(hash, (double) bodies);
+    for (size_t i = 0; i < bodies; i++) {
+        body_t *body = scene_get_body(scene, i);
+        vector_t centroid = body_get_centroid(body);
+        vector_t velocity = body_get_velocity(body);
+        hash = checksum_double(hash, centroid.x);
+        hash = checksum_double(hash, centroid.y);
+        hash = checksum_double(hash, velocity.x);
+        hash = checksum_double(hash, velocity.y);
+        hash = checksum_double(hash, body_get_rotation(body));
+        list_t *shape = body_get_shape(body);
+        for (size_t j = 0; j < list_size(shape); j++) {
+            vector_t *vertex = list_get(shape, j);
+            hash = checksum_double(hash, vertex->x);
+            hash = checksum_double(hash, vertex->y);
+        }
+        list_free(shape);
+    }
+    return hash;
+}
+
+static input_log_t *log_init(uint64_t seed) {
+    input_log_t *log = malloc(sizeof(input_log_t));
+    assert(log != NULL);
+    log->seed = seed;
+    log->file = NULL;
+    log->data = NULL;
+    log->size = 0;
+    log->cursor = 0;
+    log->ticks = 0;
+    log->simulated = 0;
+    log->started = -1;
+    log->has_checksum = false;
+    log->checksum = 0;
+    log->check = CHECK_UNKNOWN;
+    return log;
+}
+
+input_log_t *input_log_record(const char *path, uint64_t seed) {
+    FILE *file = fopen(path, "wb");
+    if (file == NULL) {
+        return NULL;
+    }
+    uint8_t header[sizeof(MAGIC) + sizeof(uint64_t)];
+    memcpy(header, MAGIC, sizeof(MAGIC));
+    write_u64(header + sizeof(MAGIC), seed);
+    fwrite(header, 1, sizeof(header), file);
+
+    input_log_t *log = log_init(seed);
+    log->file = file;
+    return log;
+}
+
+input_log_t *input_log_replay(const char *path) {
+    FILE *file = fopen(path, "rb");
+    if (file == NULL) {
+        return NULL;
+    }
+    size_t capacity = READ_CHUNK;
+    uint8_t *data = malloc(capacity);
+    assert(data != NULL);
+    size_t size = 0;
+    size_t read;
+    while ((read = fread(data + size, 1, capacity - size, file)) > 0) {
+        size += read;
+        if (size == capacity) {
+            capacity *= 2;
+            data = realloc(data, capacity);
+            assert(data != NULL);
+        }
+    }
+    fclose(file);
+    if (size < HEADER_SIZE || memcmp(data, MAGIC, sizeof(MAGIC)) != 0) {
+        free(data);
+        return NULL;
+    }
+
+    input_log_t *log = log_init(read_u64(data + sizeof(MAGIC)));
+    log->data = data;
+    log->size = size;
+    log->cursor = HEADER_SIZE;
+    return log;
+}
+
+input_log_t *input_log_from_args(int argc, char *argv[], uint64_t seed) {
+    for (int i = 1; i + 1 < argc; i++) {
+        input_log_t *log = NULL;
+        if (strcmp(argv[i], "--record") == 0) {
+            log = input_log_record(argv[i + 1], seed);
+        }
+        else if (strcmp(argv[i], "--replay") == 0) {
+            SDL_setenv("SDL_VIDEODRIVER", "dummy", 1);
+            log = input_log_replay(argv[i + 1]);
+        }
+        else {
+            continue;
+        }
+        if (log == NULL) {
+            fprintf(stderr, "%s: cannot %s input log %s\n", argv[0], argv[i] + 2, argv[i + 1]);
+            exit(1);
+        }
+        return log;
+    }
+    return NULL;
+}
+
+void input_log_free(input_log_t *log) {
+    if (log->file != NULL) {
+        fclose(log->file);
+    }
+    if (input_log_is_replay(log)) {
+        double elapsed = log->started < 0 ? 0 : now() - log->started;
+        printf("replay ticks=%zu simulated_s=%.1f ticks/s=%.1f final_state=%s\n", log->ticks, log->simulated,
+            elapsed > 0 ? log->ticks / elapsed : 0.0, CHECK_NAMES[log->check]);
+    }
+    free(log->data);
+    free(log);
+}
+
+bool input_log_is_replay(input_log_t *log) {
+    return log->data != NULL;
+}
+
+uint64_t input_log_seed(input_log_t *log) {
+    return log->seed;
+}
+
+void input_log_key(input_log_t *log, char key, key_event_type_t type, double held_time) {
+    assert(log->file != NULL);
+    uint8_t record[2 + sizeof(double)];
+    record[0] = type == KEY_PRESSED ? RECORD_KEY_PRESSED : RECORD_KEY_RELEASED;
+    record[1] = (uint8_t) key;
+    write_double(record + 2, held_time);
+    fwrite(record, 1, sizeof(record), log->file);
+}
+
+void input_log_tick(input_log_t *log, double dt) {
+    assert(log->file != NULL);
+    uint8_t record[1 + sizeof(double)];
+    record[0] = RECORD_TICK;
+    write_double(record + 1, dt);
+    fwrite(record, 1, sizeof(record), log->file);
+}
+
+bool input_log_end(input_log_t *log, scene_t *scene) {
+    uint64_t checksum = scene_checksum(scene);
+    if (!input_log_is_replay(log)) {
+        uint8_t record[1 + sizeof(uint64_t)];
+        record[0] = RECORD_END;
+        write_u64(record + 1, checksum);
+        fwrite(record, 1, sizeof(record), log->file);
+        return true;
+    }
+    if (!log->has_checksum) {
+        log->check = CHECK_UNKNOWN;
+        return false;
+    }
+    log->check = checksum == log->checksum ? CHECK_MATCHED : CHECK_DIVERGED;
+    return log->check == CHECK_MATCHED;
+}
+
+bool input_log_replay_keys(input_log_t *log, scene_t *scene, key_handler_t handler) {
+    assert(input_log_is_replay(log));
+    if (log->started < 0) {
+        log->started = now();
+    }
+    while (log->cursor < log->size) {
+        const uint8_t *record = log->data + log->cursor;
+        switch (record[0]) {
+            case RECORD_TICK:
+                // A recording cut off mid-record ends at the last whole frame
+                return log->size - log->cursor >= TICK_RECORD_SIZE;
+
+            case RECORD_KEY_PRESSED:
+            case RECORD_KEY_RELEASED:
+                if (log->size - log->cursor < KEY_RECORD_SIZE) {
+                    return false;
+                }
+                log->cursor += KEY_RECORD_SIZE;
+                handler(scene, (char) record[1], record[0] == RECORD_KEY_PRESSED ? KEY_PRESSED : KEY_RELEASED,
+                    read_double(record + 2));
+                break;
+
+            case RECORD_END:
+                if (log->size - log->cursor >= END_RECORD_SIZE) {
+                    log->has_checksum = true;
+                    log->checksum = read_u64(record + 1);
+                }
+                log->cursor = log->size;
+                return false;
+
+            default:
+                return false;
+        }
+    }
+    return false;
+}
+
+double input_log_replay_tick(input_log_t *log) {
+    assert(log->cursor + TICK_RECORD_SIZE <= log->size && log->data[log->cursor] == RECORD_TICK);
+    double dt = read_double(log->data + log->cursor + 1);
+    log->cursor += TICK_RECORD_SIZE;
+    log->ticks++;
+    log->simulated += dt;
+    return dt;
+}
@@ -0,0 +1,261 @@
+#include <assert.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <SDL2/SDL.h>
+#include "body_table.h"
+#include "level_stream.h"
+
+static const size_t INITIAL_CAPACITY = 16;
+// How many chunks the thread lays out ahead of the scene
+#define READY_CHUNKS 4
+
+struct level_chunk {
+    size_t index;
+    double bottom;
+    double top;
+    // The highest spawn; the chunk is removed once the view is above it
+    double ceiling;
+    rng_t rng;
+
+    spawn_t *spawns;
+    size_t spawn_count;
+    size_t spawn_capacity;
+    // Set once the chunk's bodies are made
+    body_handle_t *bodies;
+};
+
+struct level_stream {
+    scene_t *scene;
+    body_table_t *handles;
+    // Only used by the thread, which splits a generator off it for each chunk
+    rng_t rng;
+    chunk_generator_t generate;
+    void *generate_aux;
+    chunk_spawner_t spawn;
+    void *spawn_aux;
+
+    SDL_Thread *thread;
+    SDL_mutex *lock;
+    // Signaled when a chunk is queued
+    SDL_cond *ready;
+    // Signaled when a chunk is taken from the queue or the stream is stopping
+    SDL_cond *space;
+    bool stopping;
+    level_chunk_t *queue[READY_CHUNKS];
+    size_t queue_start;
+    size_t queue_count;
+    // Where the first chunk starts; only the thread knows where the next one does
+    double start;
+
+    // Chunks in the scene, lowest first
+    level_chunk_t **loaded;
+    size_t loaded_count;
+    size_t loaded_capacity;
+    double top;
+};
+
+static level_chunk_t *chunk_init(level_stream_t *stream, size_t index, double bottom) {
+    level_chunk_t *chunk = malloc(sizeof(level_chunk_t));
+    assert(chunk != NULL);
+    chunk->index = index;
+    chunk->bottom = bottom;
+    chunk->top = bottom;
+    chunk->ceiling = bottom;
+    chunk->rng = rng_split(&stream->rng);
+    chunk->spawn_count = 0;
+    chunk->spawn_capacity = INITIAL_CAPACITY;
+    chunk->spawns = malloc(INITIAL_CAPACITY * sizeof(spawn_t));
+    assert(chunk->spawns != NULL);
+    chunk->bodies = NULL;
+    return chunk;
+}
+
+static void chunk_free(level_chunk_t *chunk) {
+    free(chunk->spawns);
+    free(chunk->bodies);
+    free(chunk);
+}
+
+static int generator_main(void *data) {
+    level_stream_t *stream = data;
+    double bottom = stream->start;
+    size_t index = 0;
+
+    SDL_LockMutex(stream->lock);
+    while (true) {
+        while (!stream->stopping && stream->queue_count == READY_CHUNKS) {
+            SDL_CondWait(stream->space, stream->lock);
+        }
+        if (stream->stopping) {
+            break;
+        }
+        SDL_UnlockMutex(stream->lock);
+
+        level_chunk_t *chunk = chunk_init(stream, index++, bottom);
+        chunk->top = stream->generate(chunk, bottom, stream->generate_aux);
+        // level_stream_update() loads chunks until one reaches the view, so each must rise
+        assert(chunk->top > bottom);
+        bottom = chunk->top;
+
+        SDL_LockMutex(stream->lock);
+        stream->queue[(stream->queue_start + stream->queue_count) % READY_CHUNKS] = chunk;
+        stream->queue_count++;
+        SDL_CondSignal(stream->ready);
+    }
+    SDL_UnlockMutex(stream->lock);
+    return 0;
+}
+
+static void level_stream_noop(void *aux) {}
+
+static void level_stream_free(level_stream_t *stream) {
+    SDL_LockMutex(stream->lock);
+    stream->stopping = true;
+    SDL_CondSignal(stream->space);
+    SDL_UnlockMutex(stream->lock);
+    SDL_WaitThread(stream->thread, NULL);
+
+    for (size_t i = 0; i < stream->queue_count; i++) {
+        chunk_free(stream->queue[(stream->queue_start + i) % READY_CHUNKS]);
+    }
+    // The scene frees the bodies
+    for (size_t i = 0; i < stream->loaded_count; i++) {
+        chunk_free(stream->loaded[i]);
+    }
+    free(stream->loaded);
+    SDL_DestroyCond(stream->ready);
+    SDL_DestroyCond(stream->space);
+    SDL_DestroyMutex(stream->lock);
+    free(stream);
+}
+
+level_stream_t *create_level_stream(scene_t *scene, double bottom, uint64_t seed,
+        chunk_generator_t generate, void *generate_aux, chunk_spawner_t spawn, void *spawn_aux) {
+    level_stream_t *stream = malloc(sizeof(level_stream_t));
+    assert(stream != NULL);
+    stream->scene = scene;
+    stream->handles = create_body_table(scene);
+    stream->rng = rng_init(seed);
+    stream->generate = generate;
+    stream->generate_aux = generate_aux;
+    stream->spawn = spawn;
+    stream->spawn_aux = spawn_aux;
+
+    stream->lock = SDL_CreateMutex();
+    stream->ready = SDL_CreateCond();
+    stream->space = SDL_CreateCond();
+    assert(stream->lock != NULL && stream->ready != NULL && stream->space != NULL);
+    stream->stopping = false;
+    stream->queue_start = 0;
+    stream->queue_count = 0;
+    stream->start = bottom;
+
+    stream->loaded_count = 0;
+    stream->loaded_capacity = INITIAL_CAPACITY;
+    stream->loaded = malloc(INITIAL_CAPACITY * sizeof(level_chunk_t *));
+    assert(stream->loaded != NULL);
+    stream->top = bottom;
+
+    stream->thread = SDL_CreateThread(generator_main, "level_stream", stream);
+    assert(stream->thread != NULL);
+    scene_add_force_creator(scene, level_stream_noop, stream, (free_func_t) level_stream_free);
+    return stream;
+}
+
+/** Takes the next chunk from the queue, waiting for the thread if it is empty */
+static level_chunk_t *take_chunk(level_stream_t *stream) {
+    SDL_LockMutex(stream->lock);
+    while (stream->queue_count == 0) {
+        SDL_CondWait(stream->ready, stream->lock);
+    }
+    level_chunk_t *chunk = stream->queue[stream->queue_start];
+    stream->queue_start = (stream->queue_start + 1) % READY_CHUNKS;
+    stream->queue_count--;
+    SDL_CondSignal(stream->space);
+    SDL_UnlockMutex(stream->lock);
+    return chunk;
+}
+
+static void load_chunk(level_stream_t *stream) {
+    level_chunk_t *chunk = take_chunk(stream);
+    chunk->bodies = malloc(chunk->spawn_capacity * sizeof(body_handle_t));
+    assert(chunk->bodies != NULL);
+    for (size_t i = 0; i < chunk->spawn_count; i++) {
+        body_t *body = stream->spawn(stream->scene, chunk->spawns[i], stream->spawn_aux);
+        chunk->bodies[i] = body == NULL ? NO_BODY_HANDLE : body_table_add(stream->handles, body);
+    }
+
+    if (stream->loaded_count == stream->loaded_capacity) {
+        stream->loaded_capacity *= 2;
+        stream->loaded = realloc(stream->loaded, stream->loaded_capacity * sizeof(level_chunk_t *));
+        assert(stream->loaded != NULL);
+    }
+    stream->loaded[stream->loaded_count++] = chunk;
+    stream->top = chunk->top;
+}
+
+/** Removes a chunk's bodies that are still in the scene */
+static void unload_chunk(level_stream_t *stream, level_chunk_t *chunk) {
+    for (size_t i = 0; i < chunk->spawn_count; i++) {
+        body_t *body = body_table_get(stream->handles, chunk->bodies[i]);
+        if (body != NULL) {
+            body_remove(body);
+        }
+    }
+    chunk_free(chunk);
+}
+
+void level_stream_update(level_stream_t *stream, double view_bottom, double view_top) {
+    while (stream->top < view_top) {
+        load_chunk(stream);
+    }
+    // Keep one chunk loaded above the view, so a chunk is never added where it can be seen
+    if (stream->loaded_count == 0 || stream->loaded[stream->loaded_count - 1]->bottom < view_top) {
+        load_chunk(stream);
+    }
+
+    size_t unloaded = 0;
+    while (unloaded < stream->loaded_count && stream->loaded[unloaded]->ceiling < view_bottom) {
+        unload_chunk(stream, stream->loaded[unloaded]);
+        unloaded++;
+    }
+    if (unloaded > 0) {
+        stream->loaded_count -= unloaded;
+        for (size_t i = 0; i < stream->loaded_count; i++) {
+            stream->loaded[i] = stream->loaded[i + unloaded];
+        }
+    }
+}
+
+double level_stream_top(level_stream_t *stream) {
+    return stream->top;
+}
+
+void level_chunk_add(level_chunk_t *chunk, spawn_t spawn) {
+    if (chunk->spawn_count == chunk->spawn_capacity) {
+        chunk->spawn_capacity *= 2;
+        chunk->spawns = realloc(chunk->spawns, chunk->spawn_capacity * sizeof(spawn_t));
+        assert(chunk->spawns != NULL);
+    }
+    chunk->spawns[chunk->spawn_count++] = spawn;
+    if (spawn.position.y > chunk->ceiling) {
+        chunk->ceiling = spawn.position.y;
+    }
+}
+
+size_t level_chunk_size(level_chunk_t *chunk) {
+    return chunk->spawn_count;
+}
+
+spawn_t level_chunk_get(level_chunk_t *chunk, size_t index) {
+    assert(index < chunk->spawn_count);
+    return chunk->spawns[index];
+}
+
+double level_chunk_rand(level_chunk_t *chunk, double min, double max) {
+    return rng_range(&chunk->rng, min, max);
+}
+
+rng_t *level_chunk_rng(level_chunk_t *chunk) {
+    return &chunk->rng;
+}
@@ -0,0 +1,310 @@
+#include <assert.h>
+#include <math.h>
+#include <stdlib.h>
+#include "packed_polygon.h"
+#include "vertex_kernels.h"
+
+packed_polygon_t *packed_polygon_init(size_t initial_capacity) {
+    packed_polygon_t *packed = malloc(sizeof(packed_polygon_t));
+    assert(packed != NULL);
+    if (initial_capacity == 0) {
+        initial_capacity = 1;
+    }
+    packed->size = 0;
+    packed->capacity = initial_capacity;
+    packed->x = malloc(initial_capacity * sizeof(double));
+    packed->y = malloc(initial_capacity * sizeof(double));
+    assert(packed->x != NULL && packed->y != NULL);
+    return packed;
+}
+
+static void packed_polygon_reserve(packed_polygon_t *packed, size_t capacity) {
+    if (capacity <= packed->capacity) {
+        return;
+    }
+    size_t new_capacity = packed->capacity * 2;
+    if (new_capacity < capacity) {
+        new_capacity = capacity;
+    }
+    packed->x = realloc(packed->x, new_capacity * sizeof(double));
+    packed->y = realloc(packed->y, new_capacity * sizeof(double));
+    assert(packed->x != NULL && packed->y != NULL);
+    packed->capacity = new_capacity;
+}
+
+packed_polygon_t *packed_polygon_from_list(list_t *polygon) {
+    packed_polygon_t *packed = packed_polygon_init(list_size(polygon));
+    packed_polygon_copy_list(packed, polygon);
+    return packed;
+}
+
+void packed_polygon_copy_list(packed_polygon_t *packed, list_t *polygon) {
+    size_t size = list_size(polygon);
+    packed_polygon_reserve(packed, size);
+    for (size_t i = 0; i < size; i++) {
+        vector_t *v = list_get(polygon, i);
+        packed->x[i] = v->x;
+        packed->y[i] = v->y;
+    }
+    packed->size = size;
+}
+
+list_t *packed_polygon_to_list(const packed_polygon_t *packed) {
+    list_t *polygon = list_init(packed->size, free);
+    for (size_t i = 0; i < packed->size; i++) {
+        vector_t *v = malloc(sizeof(vector_t));
+        assert(v != NULL);
+        v->x = packed->x[i];
+        v->y = packed->y[i];
+        list_add(polygon, v);
+    }
+    return polygon;
+}
+
+void packed_polygon_free(packed_polygon_t *packed) {
+    free(packed->x);
+    free(packed->y);
+    free(packed);
+}
+
+void packed_polygon_add(packed_polygon_t *packed, vector_t vertex) {
+    packed_polygon_reserve(packed, packed->size + 1);
+    packed->x[packed->size] = vertex.x;
+    packed->y[packed->size] = vertex.y;
+    packed->size++;
+}
+
+vector_t packed_polygon_get(const packed_polygon_t *packed, size_t index) {
+    assert(index < packed->size);
+    return (vector_t) {packed->x[index], packed->y[index]};
+}
+
+static double packed_polygon_signed_area(const packed_polygon_t *packed) {
+    double sum = 0.0;
+    size_t n = packed->size;
+    for (size_t i = 0; i < n; i++) {
+        size_t j = i + 1 == n ? 0 : i + 1;
+        sum += packed->x[i] * packed->y[j] - packed->x[j] * packed->y[i];
+    }
+    return sum / 2;
+}
+
+double packed_polygon_area(const packed_polygon_t *packed) {
+    return fabs(packed_polygon_signed_area(packed));
+}
+
+vector_t packed_polygon_centroid(const packed_polygon_t *packed) {
+    double cx = 0.0;
+    double cy = 0.0;
+    size_t n = packed->size;
+    for (size_t i = 0; i < n; i++) {
+        size_t j = i + 1 == n ? 0 : i + 1;
+        double cross = packed->x[i] * packed->y[j] - packed->x[j] * packed->y[i];
+        cx += (packed->x[i] + packed->x[j]) * cross;
+        cy += (packed->y[i] + packed->y[j]) * cross;
+    }
+    double area = packed_polygon_signed_area(packed);
+    return (vector_t) {cx / (6 * area), cy / (6 * area)};
+}
+
+double packed_polygon_moment(const packed_polygon_t *packed) {
+    double sum = 0.0;
+    size_t n = packed->size;
+    for (size_t i = 0; i < n; i++) {
+        size_t j = i + 1 == n ? 0 : i + 1;
+        double xi = packed->x[i];
+        double yi = packed->y[i];
+        double xj = packed->x[j];
+        double yj = packed->y[j];
+        double cross = xi * yj - xj * yi;
+        sum += cross * (xi * xi + xi * xj + xj * xj + yi * yi + yi * yj + yj * yj);
+    }
+    double signed_area = packed_polygon_signed_area(packed);
+    vector_t centroid = packed_polygon_centroid(packed);
+    // The sum is about the origin; move it to the centroid
+    return fabs(sum / 12 - signed_area * vec_dot(centroid, centroid));
+}
+
+void packed_polygon_translate(packed_polygon_t *packed, vector_t translation) {
+    vertices_translate(packed->x, packed->y, packed->size, translation);
+}
+
+void packed_polygon_rotate(packed_polygon_t *packed, double angle, vector_t point) {
+    vertices_rotate(packed->x, packed->y, packed->x, packed->y, packed->size, angle, point, point);
+}
+
+void packed_polygon_place(packed_polygon_t *packed, const packed_polygon_t *local, vector_t centroid, double angle) {
+    packed_polygon_reserve(packed, local->size);
+    packed->size = local->size;
+    vertices_rotate(packed->x, packed->y, local->x, local->y, local->size, angle, VEC_ZERO, centroid);
+}
+
+bounds_t packed_polygon_bounds(const packed_polygon_t *packed) {
+    bounds_t bounds;
+    vertices_extent(packed->x, packed->y, packed->size, &bounds.min, &bounds.max);
+    bounds.center = vec_multiply(0.5, vec_add(bounds.min, bounds.max));
+    bounds.radius = 0.0;
+    for (size_t i = 0; i < packed->size; i++) {
+        double dx = packed->x[i] - bounds.center.x;
+        double dy = packed->y[i] - bounds.center.y;
+        bounds.radius = fmax(bounds.radius, dx * dx + dy * dy);
+    }
+    bounds.radius = sqrt(bounds.radius);
+    return bounds;
+}
+
+bool bounds_overlap(const bounds_t *bounds1, const bounds_t *bounds2) {
+    double dx = bounds1->center.x - bounds2->center.x;
+    double dy = bounds1->center.y - bounds2->center.y;
+    double reach = bounds1->radius + bounds2->radius;
+    if (dx * dx + dy * dy >= reach * reach) {
+        return false;
+    }
+    return bounds1->min.x < bounds2->max.x && bounds2->min.x < bounds1->max.x
+        && bounds1->min.y < bounds2->max.y && bounds2->min.y < bounds1->max.y;
+}
+
+/** Projects every vertex onto an axis, returning the covered interval */
+static void packed_polygon_project(const packed_polygon_t *packed, vector_t axis, double *min, double *max) {
+    double lo = INFINITY;
+    double hi = -INFINITY;
+    for (size_t i = 0; i < packed->size; i++) {
+        double d = packed->x[i] * axis.x + packed->y[i] * axis.y;
+        lo = d < lo ? d : lo;
+        hi = d > hi ? d : hi;
+    }
+    *min = lo;
+    *max = hi;
+}
+
+/**
+ * Tests the edge normals of one polygon as separating axes.
+ * Returns false as soon as one separates the polygons;
+ * otherwise lowers *min_overlap to the smallest overlap seen.
+ */
+static bool overlap_on_axes(
+    const packed_polygon_t *edges,
+    const packed_polygon_t *shape1,
+    const packed_polygon_t *shape2,
+    double *min_overlap,
+    vector_t *min_axis
+) {
+    size_t n = edges->size;
+    for (size_t i = 0; i < n; i++) {
+        size_t j = i + 1 == n ? 0 : i + 1;
+        vector_t normal = {edges->y[i] - edges->y[j], edges->x[j] - edges->x[i]};
+        double length = sqrt(normal.x * normal.x + normal.y * normal.y);
+        if (length == 0) {
+            continue;
+        }
+        normal = vec_multiply(1 / length, normal);
+
+        double min1, max1, min2, max2;
+        packed_polygon_project(shape1, normal, &min1, &max1);
+        packed_polygon_project(shape2, normal, &min2, &max2);
+        double overlap = fmin(max1, max2) - fmax(min1, min2);
+        if (overlap <= 0) {
+            return false;
+        }
+        if (overlap < *min_overlap) {
+            *min_overlap = overlap;
+            *min_axis = normal;
+        }
+    }
+    return true;
+}
+
+collision_info_t packed_find_collision(const packed_polygon_t *shape1, const packed_polygon_t *shape2) {
+    collision_info_t info = {.collided = false, .axis = VEC_ZERO};
+    double min_overlap = INFINITY;
+    vector_t min_axis = VEC_ZERO;
+    if (overlap_on_axes(shape1, shape1, shape2, &min_overlap, &min_axis)
+        && overlap_on_axes(shape2, shape1, shape2, &min_overlap, &min_axis)) {
+        info.collided = true;
+        info.axis = min_axis;
+    }
+    return info;
+}
+
+/**
+ * Narrows the range of rewind amounts u (shape1 moved back by u * motion)
+ * for which the polygons overlap on each edge normal of one polygon.
+ * The normal that sets the upper bound is the one the polygons first met along.
+ */
+static void sweep_on_axes(
+    const packed_polygon_t *edges,
+    const packed_polygon_t *shape1,
+    const packed_polygon_t *shape2,
+    vector_t motion,
+    double *u_min,
+    double *u_max,
+    vector_t *axis
+) {
+    size_t n = edges->size;
+    for (size_t i = 0; i < n && *u_min < *u_max; i++) {
+        size_t j = i + 1 == n ? 0 : i + 1;
+        vector_t normal = {edges->y[i] - edges->y[j], edges->x[j] - edges->x[i]};
+        double length = sqrt(normal.x * normal.x + normal.y * normal.y);
+        if (length == 0) {
+            continue;
+        }
+        normal = vec_multiply(1 / length, normal);
+
+        double min1, max1, min2, max2;
+        packed_polygon_project(shape1, normal, &min1, &max1);
+        packed_polygon_project(shape2, normal, &min2, &max2);
+        // Rewound by u, the projections overlap while lo < u * speed < hi
+        double lo = min1 - max2;
+        double hi = max1 - min2;
+        double speed = vec_dot(motion, normal);
+        if (speed == 0) {
+            if (lo >= 0 || hi <= 0) {
+                *u_max = -INFINITY;
+            }
+            continue;
+        }
+        double enter = (speed > 0 ? lo : hi) / speed;
+        double exit = (speed > 0 ? hi : lo) / speed;
+        *u_min = fmax(*u_min, enter);
+        if (exit < *u_max) {
+            *u_max = exit;
+            *axis = normal;
+        }
+    }
+}
+
+swept_collision_info_t packed_find_swept_collision(
+    const packed_polygon_t *shape1,
+    vector_t motion1,
+    const packed_polygon_t *shape2,
+    vector_t motion2
+) {
+    swept_collision_info_t info = {.collided = false, .axis = VEC_ZERO, .time = 0.0};
+    vector_t motion = vec_subtract(motion1, motion2);
+    if (motion.x == 0 && motion.y == 0) {
+        collision_info_t still = packed_find_collision(shape1, shape2);
+        info.collided = still.collided;
+        info.axis = still.axis;
+        info.time = 1.0;
+        return info;
+    }
+
+    // Work in the second polygon's frame, rewinding the first along the motion
+    // u_max starts unbounded so the axis is set even if they overlapped from the start
+    double u_min = 0.0;
+    double u_max = INFINITY;
+    vector_t axis = VEC_ZERO;
+    sweep_on_axes(shape1, shape1, shape2, motion, &u_min, &u_max, &axis);
+    sweep_on_axes(shape2, shape1, shape2, motion, &u_min, &u_max, &axis);
+    u_max = fmin(u_max, 1.0);
+    if (u_min < u_max) {
+        info.collided = true;
+        info.axis = axis;
+        info.time = 1.0 - u_max;
+    }
+    return info;
+}
+
+bool packed_polygon_overlap(const packed_polygon_t *shape1, const packed_polygon_t *shape2) {
+    return packed_find_collision(shape1, shape2).collided;
+}
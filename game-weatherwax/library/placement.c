@@ -0,0 +1,158 @@
+#include <assert.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include "placement.h"
+
+static const size_t INITIAL_CAPACITY = 64;
+// Power of two, so a hash is reduced to a bucket with a mask
+static const size_t INITIAL_BUCKETS = 64;
+static const size_t NO_ENTRY = SIZE_MAX;
+
+typedef struct rectangle {
+    vector_t min;
+    vector_t max;
+} rectangle_t;
+
+/** A rectangle filed under one of the cells it covers */
+typedef struct cell_entry {
+    int64_t x;
+    int64_t y;
+    size_t rectangle;
+    // Next entry in the same bucket
+    size_t next;
+} cell_entry_t;
+
+struct placement {
+    double cell_size;
+
+    rectangle_t *rectangles;
+    size_t rectangle_count;
+    size_t rectangle_capacity;
+
+    cell_entry_t *entries;
+    size_t entry_count;
+    size_t entry_capacity;
+    size_t *buckets;
+    size_t bucket_count;
+};
+
+static size_t hash_cell(int64_t x, int64_t y) {
+    uint64_t h = (uint64_t) x * 0x9e3779b97f4a7c15ULL ^ (uint64_t) y * 0xc2b2ae3d27d4eb4fULL;
+    h ^= h >> 29;
+    return (size_t) h;
+}
+
+static void clear_buckets(placement_t *placement) {
+    for (size_t i = 0; i < placement->bucket_count; i++) {
+        placement->buckets[i] = NO_ENTRY;
+    }
+}
+
+/** Doubles the bucket count once there are twice as many entries as buckets */
+static void grow_buckets(placement_t *placement) {
+    placement->bucket_count *= 2;
+    free(placement->buckets);
+    placement->buckets = malloc(placement->bucket_count * sizeof(size_t));
+    assert(placement->buckets != NULL);
+    clear_buckets(placement);
+    for (size_t i = 0; i < placement->entry_count; i++) {
+        cell_entry_t *entry = &placement->entries[i];
+        size_t bucket = hash_cell(entry->x, entry->y) & (placement->bucket_count - 1);
+        entry->next = placement->buckets[bucket];
+        placement->buckets[bucket] = i;
+    }
+}
+
+static rectangle_t make_rectangle(vector_t center, vector_t size) {
+    vector_t half = vec_multiply(0.5, size);
+    return (rectangle_t) {vec_subtract(center, half), vec_add(center, half)};
+}
+
+static bool rectangles_overlap(const rectangle_t *a, const rectangle_t *b) {
+    return a->min.x < b->max.x && b->min.x < a->max.x
+        && a->min.y < b->max.y && b->min.y < a->max.y;
+}
+
+placement_t *placement_init(double cell_size) {
+    assert(cell_size > 0);
+    placement_t *placement = malloc(sizeof(placement_t));
+    assert(placement != NULL);
+    placement->cell_size = cell_size;
+    placement->rectangle_count = 0;
+    placement->rectangle_capacity = INITIAL_CAPACITY;
+    placement->rectangles = malloc(INITIAL_CAPACITY * sizeof(rectangle_t));
+    placement->entry_count = 0;
+    placement->entry_capacity = INITIAL_CAPACITY;
+    placement->entries = malloc(INITIAL_CAPACITY * sizeof(cell_entry_t));
+    placement->bucket_count = INITIAL_BUCKETS;
+    placement->buckets = malloc(INITIAL_BUCKETS * sizeof(size_t));
+    assert(placement->rectangles != NULL && placement->entries != NULL && placement->buckets != NULL);
+    clear_buckets(placement);
+    return placement;
+}
+
+void placement_free(placement_t *placement) {
+    free(placement->rectangles);
+    free(placement->entries);
+    free(placement->buckets);
+    free(placement);
+}
+
+void placement_clear(placement_t *placement) {
+    placement->rectangle_count = 0;
+    placement->entry_count = 0;
+    clear_buckets(placement);
+}
+
+bool placement_fits(placement_t *placement, vector_t center, vector_t size) {
+    rectangle_t candidate = make_rectangle(center, size);
+    int64_t min_x = (int64_t) floor(candidate.min.x / placement->cell_size);
+    int64_t max_x = (int64_t) floor(candidate.max.x / placement->cell_size);
+    int64_t min_y = (int64_t) floor(candidate.min.y / placement->cell_size);
+    int64_t max_y = (int64_t) floor(candidate.max.y / placement->cell_size);
+    for (int64_t x = min_x; x <= max_x; x++) {
+        for (int64_t y = min_y; y <= max_y; y++) {
+            size_t bucket = hash_cell(x, y) & (placement->bucket_count - 1);
+            for (size_t i = placement->buckets[bucket]; i != NO_ENTRY; i = placement->entries[i].next) {
+                cell_entry_t *entry = &placement->entries[i];
+                if (entry->x == x && entry->y == y
+                        && rectangles_overlap(&candidate, &placement->rectangles[entry->rectangle])) {
+                    return false;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+void placement_add(placement_t *placement, vector_t center, vector_t size) {
+    if (placement->rectangle_count == placement->rectangle_capacity) {
+        placement->rectangle_capacity *= 2;
+        placement->rectangles = realloc(placement->rectangles, placement->rectangle_capacity * sizeof(rectangle_t));
+        assert(placement->rectangles != NULL);
+    }
+    size_t index = placement->rectangle_count++;
+    rectangle_t *rectangle = &placement->rectangles[index];
+    *rectangle = make_rectangle(center, size);
+
+    int64_t min_x = (int64_t) floor(rectangle->min.x / placement->cell_size);
+    int64_t max_x = (int64_t) floor(rectangle->max.x / placement->cell_size);
+    int64_t min_y = (int64_t) floor(rectangle->min.y / placement->cell_size);
+    int64_t max_y = (int64_t) floor(rectangle->max.y / placement->cell_size);
+    for (int64_t x = min_x; x <= max_x; x++) {
+        for (int64_t y = min_y; y <= max_y; y++) {
+            if (placement->entry_count == placement->entry_capacity) {
+                placement->entry_capacity *= 2;
+                placement->entries = realloc(placement->entries, placement->entry_capacity * sizeof(cell_entry_t));
+                assert(placement->entries != NULL);
+            }
+            size_t bucket = hash_cell(x, y) & (placement->bucket_count - 1);
+            placement->entries[placement->entry_count] = (cell_entry_t) {x, y, index, placement->buckets[bucket]};
+            placement->buckets[bucket] = placement->entry_count++;
+        }
+    }
+    if (placement->entry_count > 2 * placement->bucket_count) {
+        grow_buckets(placement);
+    }
+}
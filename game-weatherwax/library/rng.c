@@ -0,0 +1,92 @@
+#include "rng.h"
+
+// xoshiro256**'s jump polynomial, for 2^128 calls to rng_next()
+static const uint64_t JUMP[] = {
+    0x180ec6d33cfd0aba, 0xd5a61266f0c9392c, 0xa9582618e03fc9aa, 0x39abdc4529b1661c
+};
+// 2^-53; the top 53 bits of a random integer fill a double's mantissa
+static const double DOUBLE_UNIT = 0x1.0p-53;
+
+static inline uint64_t rotate_left(uint64_t x, int k) {
+    return (x << k) | (x >> (64 - k));
+}
+
+/** splitmix64, which turns consecutive seeds into unrelated states */
+static uint64_t splitmix(uint64_t *seed) {
+    uint64_t z = (*seed += 0x9e3779b97f4a7c15);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+    return z ^ (z >> 31);
+}
+
+rng_t rng_init(uint64_t seed) {
+    rng_t rng;
+    for (size_t i = 0; i < 4; i++) {
+        rng.state[i] = splitmix(&seed);
+    }
+    return rng;
+}
+
+uint64_t rng_next(rng_t *rng) {
+    uint64_t *s = rng->state;
+    uint64_t result = rotate_left(s[1] * 5, 7) * 9;
+    uint64_t t = s[1] << 17;
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = rotate_left(s[3], 45);
+    return result;
+}
+
+double rng_double(rng_t *rng) {
+    return (rng_next(rng) >> 11) * DOUBLE_UNIT;
+}
+
+double rng_range(rng_t *rng, double min, double max) {
+    return min + rng_double(rng) * (max - min);
+}
+
+void rng_fill_uniform(rng_t *rng, double *values, size_t count, double min, double max) {
+    // Keeping the state in locals lets it stay in registers for the whole loop
+    uint64_t s0 = rng->state[0], s1 = rng->state[1], s2 = rng->state[2], s3 = rng->state[3];
+    for (size_t i = 0; i < count; i++) {
+        uint64_t result = rotate_left(s1 * 5, 7) * 9;
+        uint64_t t = s1 << 17;
+        s2 ^= s0;
+        s3 ^= s1;
+        s1 ^= s2;
+        s0 ^= s3;
+        s2 ^= t;
+        s3 = rotate_left(s3, 45);
+        values[i] = min + (result >> 11) * DOUBLE_UNIT * (max - min);
+    }
+    rng->state[0] = s0;
+    rng->state[1] = s1;
+    rng->state[2] = s2;
+    rng->state[3] = s3;
+}
+
+void rng_jump(rng_t *rng) {
+    uint64_t jumped[4] = {0, 0, 0, 0};
+    for (size_t i = 0; i < sizeof(JUMP) / sizeof(JUMP[0]); i++) {
+        for (int b = 0; b < 64; b++) {
+            if (JUMP[i] & (uint64_t) 1 << b) {
+                for (size_t j = 0; j < 4; j++) {
+                    jumped[j] ^= rng->state[j];
+                }
+            }
+            rng_next(rng);
+        }
+    }
+    for (size_t j = 0; j < 4; j++) {
+        rng->state[j] = jumped[j];
+    }
+}
+
+rng_t rng_split(rng_t *rng) {
+    rng_t split = *rng;
+    rng_jump(rng);
+    return split;
+}
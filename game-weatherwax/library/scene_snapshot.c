@@ -0,0 +1,145 @@
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+#include "body_table.h"
+#include "scene_snapshot.h"
+
+static const size_t INITIAL_CAPACITY = 64;
+
+struct scene_snapshot {
+    scene_t *scene;
+    body_table_t *handles;
+    body_respawner_t respawn;
+    void *aux;
+
+    // states[i] is the saved state of the body bodies[i] refers to
+    body_state_t *states;
+    body_handle_t *bodies;
+    size_t count;
+    size_t capacity;
+};
+
+static void scene_snapshot_noop(void *aux) {}
+
+static void scene_snapshot_free(scene_snapshot_t *snapshot) {
+    // The scene frees the bodies and the table
+    free(snapshot->states);
+    free(snapshot->bodies);
+    free(snapshot);
+}
+
+static void ensure_capacity(scene_snapshot_t *snapshot, size_t count) {
+    if (count <= snapshot->capacity) {
+        return;
+    }
+    while (snapshot->capacity < count) {
+        snapshot->capacity *= 2;
+    }
+    snapshot->states = realloc(snapshot->states, snapshot->capacity * sizeof(body_state_t));
+    snapshot->bodies = realloc(snapshot->bodies, snapshot->capacity * sizeof(body_handle_t));
+    assert(snapshot->states != NULL && snapshot->bodies != NULL);
+}
+
+/** Saves a body's state, keeping the kind it was added with */
+static void save_state(body_state_t *state, body_t *body) {
+    state->type = (int32_t) body_get_type(body);
+    state->centroid = body_get_centroid(body);
+    state->velocity = body_get_velocity(body);
+    state->rotation = body_get_rotation(body);
+    state->color = body_get_color(body);
+    state->visible = body_visible(body) ? 1 : 0;
+}
+
+/** Puts a body back in a saved state; a body's color cannot be changed, so it is only used to respawn */
+static void load_state(body_t *body, const body_state_t *state) {
+    body_set_type(body, (body_type_t) state->type);
+    body_set_rotation(body, state->rotation);
+    body_set_centroid(body, state->centroid);
+    body_set_velocity(body, state->velocity);
+    if (state->visible) {
+        body_show(body);
+    }
+    else {
+        body_hide(body);
+    }
+}
+
+/** Gets the body a saved state belongs to, or NULL if it is gone or on its way out */
+static body_t *live_body(scene_snapshot_t *snapshot, size_t index) {
+    body_t *body = body_table_get(snapshot->handles, snapshot->bodies[index]);
+    return body == NULL || body_is_removed(body) ? NULL : body;
+}
+
+scene_snapshot_t *create_scene_snapshot(scene_t *scene, body_respawner_t respawn, void *aux) {
+    scene_snapshot_t *snapshot = malloc(sizeof(scene_snapshot_t));
+    assert(snapshot != NULL);
+    snapshot->scene = scene;
+    snapshot->handles = create_body_table(scene);
+    snapshot->respawn = respawn;
+    snapshot->aux = aux;
+    snapshot->count = 0;
+    snapshot->capacity = INITIAL_CAPACITY;
+    snapshot->states = malloc(INITIAL_CAPACITY * sizeof(body_state_t));
+    snapshot->bodies = malloc(INITIAL_CAPACITY * sizeof(body_handle_t));
+    assert(snapshot->states != NULL && snapshot->bodies != NULL);
+    scene_add_force_creator(scene, scene_snapshot_noop, snapshot, (free_func_t) scene_snapshot_free);
+    return snapshot;
+}
+
+void scene_snapshot_add(scene_snapshot_t *snapshot, body_t *body, uint32_t kind) {
+    ensure_capacity(snapshot, snapshot->count + 1);
+    body_state_t *state = &snapshot->states[snapshot->count];
+    // Zeroes any bytes the fields leave unused, so saved states can be compared and written out as they are
+    memset(state, 0, sizeof(body_state_t));
+    state->kind = kind;
+    save_state(state, body);
+    snapshot->bodies[snapshot->count] = body_table_add(snapshot->handles, body);
+    snapshot->count++;
+}
+
+void scene_snapshot_take(scene_snapshot_t *snapshot) {
+    size_t kept = 0;
+    for (size_t i = 0; i < snapshot->count; i++) {
+        body_t *body = live_body(snapshot, i);
+        if (body == NULL) {
+            continue;
+        }
+        snapshot->states[kept] = snapshot->states[i];
+        snapshot->bodies[kept] = snapshot->bodies[i];
+        save_state(&snapshot->states[kept], body);
+        kept++;
+    }
+    snapshot->count = kept;
+}
+
+void scene_snapshot_restore(scene_snapshot_t *snapshot) {
+    for (size_t i = 0; i < snapshot->count; i++) {
+        const body_state_t *state = &snapshot->states[i];
+        body_t *body = live_body(snapshot, i);
+        if (body == NULL) {
+            body = snapshot->respawn(snapshot->scene, state, snapshot->aux);
+            if (body == NULL) {
+                snapshot->bodies[i] = NO_BODY_HANDLE;
+                continue;
+            }
+            snapshot->bodies[i] = body_table_add(snapshot->handles, body);
+        }
+        load_state(body, state);
+    }
+}
+
+const body_state_t *scene_snapshot_states(scene_snapshot_t *snapshot, size_t *count) {
+    *count = snapshot->count;
+    return snapshot->states;
+}
+
+void scene_snapshot_load(scene_snapshot_t *snapshot, const body_state_t *states, size_t count) {
+    // Dropping bodies would leave their handles in the table
+    assert(count >= snapshot->count);
+    ensure_capacity(snapshot, count);
+    for (size_t i = snapshot->count; i < count; i++) {
+        snapshot->bodies[i] = NO_BODY_HANDLE;
+    }
+    memcpy(snapshot->states, states, count * sizeof(body_state_t));
+    snapshot->count = count;
+}
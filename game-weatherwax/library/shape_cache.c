@@ -0,0 +1,316 @@
+#include <assert.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include "body_watch.h"
+#include "shape_cache.h"
+#include "vertex_kernels.h"
+
+#define NO_ENTRY SIZE_MAX
+
+static const size_t INITIAL_CAPACITY = 16;
+
+typedef struct entry {
+    body_t *body;
+    // Vertices relative to the centroid, at zero rotation
+    packed_polygon_t *local;
+    // Vertices in world coordinates as of centroid/angle below
+    packed_polygon_t *world;
+    bounds_t bounds;
+    // Distance from the centroid to the farthest vertex
+    double radius;
+    double area;
+    // Second moment of area about the centroid
+    double moment;
+    vector_t centroid;
+    double angle;
+    // Next entry in the same bucket, or in the free list
+    size_t next;
+} entry_t;
+
+typedef struct watch {
+    shape_cache_t *cache;
+    size_t index;
+} watch_t;
+
+struct shape_cache {
+    scene_t *scene;
+    size_t refs;
+
+    entry_t *entries;
+    size_t entry_count;
+    size_t entry_capacity;
+    size_t free_entry;
+    size_t live_count;
+
+    size_t *buckets;
+    size_t bucket_count;
+
+    // Scratch space for shape_cache_refresh(): the moved entries and their transforms
+    size_t *moved;
+    vertex_transform_t *transforms;
+    size_t moved_capacity;
+};
+
+static size_t hash_pointer(void *pointer) {
+    uint64_t h = (uint64_t) (uintptr_t) pointer;
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    return (size_t) h;
+}
+
+static void shape_cache_noop(void *aux) {}
+
+static void shape_cache_release(shape_cache_t *cache) {
+    cache->refs--;
+    if (cache->refs == 0) {
+        for (size_t i = 0; i < cache->entry_count; i++) {
+            packed_polygon_free(cache->entries[i].local);
+            packed_polygon_free(cache->entries[i].world);
+        }
+        free(cache->entries);
+        free(cache->buckets);
+        free(cache->moved);
+        free(cache->transforms);
+        free(cache);
+    }
+}
+
+static void rehash(shape_cache_t *cache, size_t bucket_count) {
+    free(cache->buckets);
+    cache->buckets = malloc(bucket_count * sizeof(size_t));
+    assert(cache->buckets != NULL);
+    cache->bucket_count = bucket_count;
+    for (size_t i = 0; i < bucket_count; i++) {
+        cache->buckets[i] = NO_ENTRY;
+    }
+    for (size_t i = 0; i < cache->entry_count; i++) {
+        entry_t *entry = &cache->entries[i];
+        if (entry->body != NULL) {
+            size_t bucket = hash_pointer(entry->body) & (bucket_count - 1);
+            entry->next = cache->buckets[bucket];
+            cache->buckets[bucket] = i;
+        }
+    }
+}
+
+static void forget_body(watch_t *watch) {
+    shape_cache_t *cache = watch->cache;
+    size_t index = watch->index;
+    free(watch);
+
+    entry_t *entry = &cache->entries[index];
+    size_t bucket = hash_pointer(entry->body) & (cache->bucket_count - 1);
+    size_t *link = &cache->buckets[bucket];
+    while (*link != index) {
+        link = &cache->entries[*link].next;
+    }
+    *link = entry->next;
+
+    entry->body = NULL;
+    entry->next = cache->free_entry;
+    cache->free_entry = index;
+    cache->live_count--;
+    shape_cache_release(cache);
+}
+
+/** Updates the bounding box and pose of an entry whose world-space vertices were just placed */
+static void finish_world(entry_t *entry, vector_t centroid, double angle) {
+    bounds_t *bounds = &entry->bounds;
+    vertices_extent(entry->world->x, entry->world->y, entry->world->size, &bounds->min, &bounds->max);
+    bounds->center = centroid;
+    bounds->radius = entry->radius;
+    entry->centroid = centroid;
+    entry->angle = angle;
+}
+
+/** Rebuilds the world-space vertices and bounding box from the local vertices */
+static void update_world(entry_t *entry, vector_t centroid, double angle) {
+    packed_polygon_place(entry->world, entry->local, centroid, angle);
+    finish_world(entry, centroid, angle);
+}
+
+/** Copies a body's shape into a fresh entry */
+static size_t add_entry(shape_cache_t *cache, body_t *body) {
+    size_t index;
+    if (cache->free_entry != NO_ENTRY) {
+        index = cache->free_entry;
+        cache->free_entry = cache->entries[index].next;
+    }
+    else {
+        index = cache->entry_count++;
+        if (cache->entry_count > cache->entry_capacity) {
+            cache->entry_capacity *= 2;
+            cache->entries = realloc(cache->entries, cache->entry_capacity * sizeof(entry_t));
+            assert(cache->entries != NULL);
+        }
+        cache->entries[index].local = packed_polygon_init(INITIAL_CAPACITY);
+        cache->entries[index].world = packed_polygon_init(INITIAL_CAPACITY);
+    }
+
+    entry_t *entry = &cache->entries[index];
+    entry->body = body;
+    vector_t centroid = body_get_centroid(body);
+    double angle = body_get_rotation(body);
+    list_t *shape = body_get_shape(body);
+    packed_polygon_copy_list(entry->world, shape);
+    packed_polygon_copy_list(entry->local, shape);
+    list_free(shape);
+    packed_polygon_translate(entry->local, vec_negate(centroid));
+    packed_polygon_rotate(entry->local, -angle, VEC_ZERO);
+
+    double radius = 0.0;
+    for (size_t i = 0; i < entry->local->size; i++) {
+        double x = entry->local->x[i];
+        double y = entry->local->y[i];
+        radius = fmax(radius, x * x + y * y);
+    }
+    entry->radius = sqrt(radius);
+    entry->area = packed_polygon_area(entry->local);
+    entry->moment = packed_polygon_moment(entry->local);
+    update_world(entry, centroid, angle);
+
+    cache->live_count++;
+    if (cache->live_count > cache->bucket_count) {
+        rehash(cache, cache->bucket_count * 2);
+    }
+    else {
+        size_t bucket = hash_pointer(body) & (cache->bucket_count - 1);
+        entry->next = cache->buckets[bucket];
+        cache->buckets[bucket] = index;
+    }
+
+    watch_t *watch = malloc(sizeof(watch_t));
+    assert(watch != NULL);
+    watch->cache = cache;
+    watch->index = index;
+    cache->refs++;
+    body_watch(cache->scene, body, (free_func_t) forget_body, watch);
+    return index;
+}
+
+shape_cache_t *create_shape_cache(scene_t *scene) {
+    shape_cache_t *cache = malloc(sizeof(shape_cache_t));
+    assert(cache != NULL);
+    cache->scene = scene;
+    cache->refs = 1;
+    cache->entry_count = 0;
+    cache->entry_capacity = INITIAL_CAPACITY;
+    cache->entries = malloc(INITIAL_CAPACITY * sizeof(entry_t));
+    assert(cache->entries != NULL);
+    cache->free_entry = NO_ENTRY;
+    cache->live_count = 0;
+    cache->buckets = NULL;
+    rehash(cache, INITIAL_CAPACITY);
+    cache->moved_capacity = INITIAL_CAPACITY;
+    cache->moved = malloc(INITIAL_CAPACITY * sizeof(size_t));
+    cache->transforms = malloc(INITIAL_CAPACITY * sizeof(vertex_transform_t));
+    assert(cache->moved != NULL && cache->transforms != NULL);
+    scene_add_force_creator(scene, shape_cache_noop, cache, (free_func_t) shape_cache_release);
+    return cache;
+}
+
+/** Finds the index of a body's entry, or NO_ENTRY if it has none */
+static size_t lookup_entry(shape_cache_t *cache, body_t *body) {
+    size_t bucket = hash_pointer(body) & (cache->bucket_count - 1);
+    size_t index = cache->buckets[bucket];
+    while (index != NO_ENTRY && cache->entries[index].body != body) {
+        index = cache->entries[index].next;
+    }
+    return index;
+}
+
+/** Finds a body's entry, adding it if needed */
+static entry_t *find_entry(shape_cache_t *cache, body_t *body) {
+    size_t index = lookup_entry(cache, body);
+    if (index == NO_ENTRY) {
+        index = add_entry(cache, body);
+    }
+    return &cache->entries[index];
+}
+
+/** Finds a body's entry and brings its world-space vertices up to date */
+static entry_t *get_entry(shape_cache_t *cache, body_t *body) {
+    entry_t *entry = find_entry(cache, body);
+    vector_t centroid = body_get_centroid(body);
+    double angle = body_get_rotation(body);
+    if (centroid.x != entry->centroid.x || centroid.y != entry->centroid.y || angle != entry->angle) {
+        update_world(entry, centroid, angle);
+    }
+    return entry;
+}
+
+void shape_cache_refresh(shape_cache_t *cache) {
+    if (cache->entry_count > cache->moved_capacity) {
+        while (cache->moved_capacity < cache->entry_count) {
+            cache->moved_capacity *= 2;
+        }
+        cache->moved = realloc(cache->moved, cache->moved_capacity * sizeof(size_t));
+        cache->transforms = realloc(cache->transforms, cache->moved_capacity * sizeof(vertex_transform_t));
+        assert(cache->moved != NULL && cache->transforms != NULL);
+    }
+
+    size_t moved = 0;
+    for (size_t i = 0; i < cache->entry_count; i++) {
+        entry_t *entry = &cache->entries[i];
+        if (entry->body == NULL) {
+            continue;
+        }
+        vector_t centroid = body_get_centroid(entry->body);
+        double angle = body_get_rotation(entry->body);
+        if (centroid.x == entry->centroid.x && centroid.y == entry->centroid.y && angle == entry->angle) {
+            continue;
+        }
+        // The world polygon already has room: it was placed from the same local vertices when added
+        entry->world->size = entry->local->size;
+        cache->transforms[moved] = (vertex_transform_t) {
+            entry->world->x, entry->world->y, entry->local->x, entry->local->y, entry->local->size,
+            angle, VEC_ZERO, centroid
+        };
+        cache->moved[moved++] = i;
+    }
+
+    vertices_rotate_batch(cache->transforms, moved);
+    for (size_t i = 0; i < moved; i++) {
+        const vertex_transform_t *transform = &cache->transforms[i];
+        finish_world(&cache->entries[cache->moved[i]], transform->offset, transform->angle);
+    }
+}
+
+const packed_polygon_t *shape_cache_get(shape_cache_t *cache, body_t *body) {
+    return get_entry(cache, body)->world;
+}
+
+shape_view_t shape_cache_view(shape_cache_t *cache, body_t *body) {
+    entry_t *entry = get_entry(cache, body);
+    return (shape_view_t) {entry->world, entry->bounds};
+}
+
+shape_view_t shape_cache_local(shape_cache_t *cache, body_t *body) {
+    entry_t *entry = find_entry(cache, body);
+    double radius = entry->radius;
+    return (shape_view_t) {entry->local, {{-radius, -radius}, {radius, radius}, VEC_ZERO, radius}};
+}
+
+double shape_cache_area(shape_cache_t *cache, body_t *body) {
+    return find_entry(cache, body)->area;
+}
+
+double shape_cache_moment(shape_cache_t *cache, body_t *body) {
+    entry_t *entry = find_entry(cache, body);
+    return body_get_mass(body) / entry->area * entry->moment;
+}
+
+collision_info_t shape_view_find_collision(const shape_view_t *shape1, const shape_view_t *shape2) {
+    if (!bounds_overlap(&shape1->bounds, &shape2->bounds)) {
+        return (collision_info_t) {.collided = false};
+    }
+    return packed_find_collision(shape1->polygon, shape2->polygon);
+}
+
+bool shape_view_overlap(const shape_view_t *shape1, const shape_view_t *shape2) {
+    return bounds_overlap(&shape1->bounds, &shape2->bounds)
+        && packed_polygon_overlap(shape1->polygon, shape2->polygon);
+}
@@ -0,0 +1,203 @@
+#include <assert.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include "body_watch.h"
+#include "spring_field.h"
+#include "thread_pool.h"
+#include "vector.h"
+
+static const size_t INITIAL_CAPACITY = 16;
+// A watch whose force is already gone
+static const size_t NO_FORCE = SIZE_MAX;
+
+typedef enum {
+    SPRING_FORCE,
+    DRAG_FORCE
+} force_kind_t;
+
+typedef struct watch watch_t;
+
+typedef struct field_force {
+    force_kind_t kind;
+    double constant;
+    body_t *body1;
+    // NULL for drag
+    body_t *body2;
+    watch_t *watches[2];
+} field_force_t;
+
+struct watch {
+    spring_field_t *field;
+    size_t index;
+};
+
+struct spring_field {
+    scene_t *scene;
+    size_t refs;
+
+    field_force_t *forces;
+    size_t force_count;
+    size_t force_capacity;
+    // Whether a force lost a body since the last tick
+    bool has_removed;
+
+    // What each force pushes on its first body this tick;
+    // a spring pushes its second body the opposite way
+    vector_t *pushes;
+    size_t push_capacity;
+
+    // NULL while the field runs on one thread
+    thread_pool_t *pool;
+};
+
+static void spring_field_release(spring_field_t *field) {
+    field->refs--;
+    if (field->refs == 0) {
+        free(field->forces);
+        free(field->pushes);
+        if (field->pool != NULL) {
+            thread_pool_free(field->pool);
+        }
+        free(field);
+    }
+}
+
+/** Marks the watched body's force as removed; the other body's watch then has nothing to do */
+static void remove_force(watch_t *watch) {
+    spring_field_t *field = watch->field;
+    if (watch->index != NO_FORCE) {
+        field_force_t *force = &field->forces[watch->index];
+        for (size_t i = 0; i < 2; i++) {
+            if (force->watches[i] != NULL) {
+                force->watches[i]->index = NO_FORCE;
+                force->watches[i] = NULL;
+            }
+        }
+        force->body1 = NULL;
+        field->has_removed = true;
+    }
+    free(watch);
+    spring_field_release(field);
+}
+
+/** Drops removed forces, keeping the rest in the order they were added */
+static void compact(spring_field_t *field) {
+    size_t kept = 0;
+    for (size_t i = 0; i < field->force_count; i++) {
+        field_force_t *force = &field->forces[i];
+        if (force->body1 == NULL) {
+            continue;
+        }
+        field->forces[kept] = *force;
+        for (size_t j = 0; j < 2; j++) {
+            if (force->watches[j] != NULL) {
+                force->watches[j]->index = kept;
+            }
+        }
+        kept++;
+    }
+    field->force_count = kept;
+    field->has_removed = false;
+}
+
+static void compute_push(void *aux, size_t index, size_t thread) {
+    spring_field_t *field = aux;
+    field_force_t *force = &field->forces[index];
+    if (force->kind == SPRING_FORCE) {
+        vector_t stretch = vec_subtract(body_get_centroid(force->body2),
+            body_get_centroid(force->body1));
+        field->pushes[index] = vec_multiply(force->constant, stretch);
+    }
+    else {
+        field->pushes[index] = vec_multiply(-force->constant, body_get_velocity(force->body1));
+    }
+}
+
+static void spring_field_tick(spring_field_t *field) {
+    if (field->has_removed) {
+        compact(field);
+    }
+    if (field->force_count > field->push_capacity) {
+        field->push_capacity = field->force_capacity;
+        field->pushes = realloc(field->pushes, field->push_capacity * sizeof(vector_t));
+        assert(field->pushes != NULL);
+    }
+    if (field->pool != NULL) {
+        thread_pool_for(field->pool, field->force_count, compute_push, field);
+    }
+    else {
+        for (size_t i = 0; i < field->force_count; i++) {
+            compute_push(field, i, 0);
+        }
+    }
+
+    // Each push only depends on the bodies' state before any force is applied,
+    // and they are applied in the order they were added, as separate force creators would,
+    // so the result is the same no matter how many threads computed them
+    for (size_t i = 0; i < field->force_count; i++) {
+        field_force_t *force = &field->forces[i];
+        body_add_force(force->body1, field->pushes[i]);
+        if (force->kind == SPRING_FORCE) {
+            body_add_force(force->body2, vec_negate(field->pushes[i]));
+        }
+    }
+}
+
+static watch_t *watch_body(spring_field_t *field, body_t *body, size_t index) {
+    watch_t *watch = malloc(sizeof(watch_t));
+    assert(watch != NULL);
+    watch->field = field;
+    watch->index = index;
+    field->refs++;
+    body_watch(field->scene, body, (free_func_t) remove_force, watch);
+    return watch;
+}
+
+static void add_force(spring_field_t *field, force_kind_t kind, double constant,
+        body_t *body1, body_t *body2) {
+    if (field->force_count == field->force_capacity) {
+        field->force_capacity = field->force_capacity == 0 ? INITIAL_CAPACITY : field->force_capacity * 2;
+        field->forces = realloc(field->forces, field->force_capacity * sizeof(field_force_t));
+        assert(field->forces != NULL);
+    }
+    size_t index = field->force_count++;
+    field_force_t *force = &field->forces[index];
+    force->kind = kind;
+    force->constant = constant;
+    force->body1 = body1;
+    force->body2 = body2;
+    force->watches[0] = watch_body(field, body1, index);
+    force->watches[1] = body2 == NULL ? NULL : watch_body(field, body2, index);
+}
+
+// ===== PUBLIC API =====
+
+spring_field_t *create_spring_field(scene_t *scene) {
+    spring_field_t *field = calloc(1, sizeof(spring_field_t));
+    assert(field != NULL);
+    field->scene = scene;
+    field->refs = 1;
+    scene_add_force_creator(scene, (force_creator_t) spring_field_tick, field,
+        (free_func_t) spring_field_release);
+    return field;
+}
+
+void spring_field_add_spring(spring_field_t *field, double k, body_t *body1, body_t *body2) {
+    add_force(field, SPRING_FORCE, k, body1, body2);
+}
+
+void spring_field_add_drag(spring_field_t *field, double gamma, body_t *body) {
+    add_force(field, DRAG_FORCE, gamma, body, NULL);
+}
+
+void spring_field_set_threads(spring_field_t *field, size_t threads) {
+    assert(threads > 0);
+    if (field->pool != NULL) {
+        thread_pool_free(field->pool);
+        field->pool = NULL;
+    }
+    if (threads > 1) {
+        field->pool = thread_pool_init(threads);
+    }
+}
@@ -0,0 +1,122 @@
+#include <assert.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <SDL2/SDL.h>
+#include "texture_cache.h"
+
+static const size_t INITIAL_CAPACITY = 8;
+
+/** A loaded file */
+typedef struct texture {
+    char *filename;
+    SDL_Texture *texture;
+} texture_t;
+
+/** A costume for one image, sharing its file's texture */
+typedef struct cached_costume {
+    texture_t *texture;
+    double width;
+    double height;
+    costume_t *costume;
+} cached_costume_t;
+
+// A game only has a handful of images, so lookups are linear scans
+struct texture_cache {
+    texture_t **textures;
+    size_t texture_count;
+    size_t texture_capacity;
+
+    cached_costume_t *costumes;
+    size_t costume_count;
+    size_t costume_capacity;
+};
+
+static texture_t *find_texture(texture_cache_t *cache, const char *filename) {
+    for (size_t i = 0; i < cache->texture_count; i++) {
+        if (strcmp(cache->textures[i]->filename, filename) == 0) {
+            return cache->textures[i];
+        }
+    }
+    return NULL;
+}
+
+static texture_t *load_texture(texture_cache_t *cache, char *filename) {
+    texture_t *texture = find_texture(cache, filename);
+    if (texture != NULL) {
+        return texture;
+    }
+    if (cache->texture_count == cache->texture_capacity) {
+        cache->texture_capacity *= 2;
+        cache->textures = realloc(cache->textures, cache->texture_capacity * sizeof(texture_t *));
+        assert(cache->textures != NULL);
+    }
+    texture = malloc(sizeof(texture_t));
+    assert(texture != NULL);
+    texture->filename = malloc(strlen(filename) + 1);
+    assert(texture->filename != NULL);
+    strcpy(texture->filename, filename);
+    texture->texture = create_image_texture(filename);
+    cache->textures[cache->texture_count++] = texture;
+    return texture;
+}
+
+texture_cache_t *texture_cache_init(void) {
+    texture_cache_t *cache = malloc(sizeof(texture_cache_t));
+    assert(cache != NULL);
+    cache->texture_count = 0;
+    cache->texture_capacity = INITIAL_CAPACITY;
+    cache->textures = malloc(INITIAL_CAPACITY * sizeof(texture_t *));
+    cache->costume_count = 0;
+    cache->costume_capacity = INITIAL_CAPACITY;
+    cache->costumes = malloc(INITIAL_CAPACITY * sizeof(cached_costume_t));
+    assert(cache->textures != NULL && cache->costumes != NULL);
+    return cache;
+}
+
+void texture_cache_free(texture_cache_t *cache) {
+    // costume_free() would destroy a texture other costumes still share
+    for (size_t i = 0; i < cache->costume_count; i++) {
+        free(cache->costumes[i].costume);
+    }
+    for (size_t i = 0; i < cache->texture_count; i++) {
+        SDL_DestroyTexture(cache->textures[i]->texture);
+        free(cache->textures[i]->filename);
+        free(cache->textures[i]);
+    }
+    free(cache->costumes);
+    free(cache->textures);
+    free(cache);
+}
+
+void texture_cache_preload(texture_cache_t *cache, const image_t *images, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        texture_cache_get(cache, images[i]);
+    }
+}
+
+costume_t *texture_cache_get(texture_cache_t *cache, image_t image) {
+    texture_t *texture = image.filename == NULL ? NULL : load_texture(cache, image.filename);
+    for (size_t i = 0; i < cache->costume_count; i++) {
+        cached_costume_t *cached = &cache->costumes[i];
+        if (cached->texture == texture && cached->width == image.width && cached->height == image.height) {
+            return cached->costume;
+        }
+    }
+    if (cache->costume_count == cache->costume_capacity) {
+        cache->costume_capacity *= 2;
+        cache->costumes = realloc(cache->costumes, cache->costume_capacity * sizeof(cached_costume_t));
+        assert(cache->costumes != NULL);
+    }
+    costume_t *costume = costume_init(texture == NULL ? NULL : texture->texture, image.width, image.height);
+    cache->costumes[cache->costume_count++] = (cached_costume_t) {texture, image.width, image.height, costume};
+    return costume;
+}
+
+list_t *texture_cache_costumes(texture_cache_t *cache, list_t *images) {
+    list_t *costumes = list_init(list_size(images), NULL);
+    for (size_t i = 0; i < list_size(images); i++) {
+        list_add(costumes, texture_cache_get(cache, *(image_t *) list_get(images, i)));
+    }
+    return costumes;
+}
@@ -0,0 +1,158 @@
+#include <assert.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <SDL2/SDL.h>
+#include "thread_pool.h"
+
+// Iterations claimed per trip to the shared counter
+static const size_t CHUNK_SIZE = 16;
+
+typedef struct worker {
+    thread_pool_t *pool;
+    size_t thread;
+    SDL_Thread *handle;
+} worker_t;
+
+struct thread_pool {
+    size_t threads;
+    worker_t *workers;
+
+    SDL_mutex *lock;
+    // Signaled when a loop starts or the pool is stopping
+    SDL_cond *start;
+    // Signaled when the last worker leaves a loop
+    SDL_cond *done;
+    // Bumped for every loop, so workers can tell a new loop from a spurious wakeup
+    size_t generation;
+    size_t busy_workers;
+    bool stopping;
+
+    // The loop being run
+    parallel_task_t task;
+    void *aux;
+    size_t count;
+    SDL_atomic_t next_chunk;
+};
+
+/** Claims chunks of the current loop until none are left */
+static void run_chunks(thread_pool_t *pool, size_t thread) {
+    size_t chunks = (pool->count + CHUNK_SIZE - 1) / CHUNK_SIZE;
+    while (true) {
+        size_t chunk = (size_t) SDL_AtomicAdd(&pool->next_chunk, 1);
+        if (chunk >= chunks) {
+            return;
+        }
+        size_t end = (chunk + 1) * CHUNK_SIZE;
+        if (end > pool->count) {
+            end = pool->count;
+        }
+        for (size_t i = chunk * CHUNK_SIZE; i < end; i++) {
+            pool->task(pool->aux, i, thread);
+        }
+    }
+}
+
+static int worker_main(void *data) {
+    worker_t *worker = data;
+    thread_pool_t *pool = worker->pool;
+    size_t seen = 0;
+
+    SDL_LockMutex(pool->lock);
+    while (true) {
+        while (!pool->stopping && pool->generation == seen) {
+            SDL_CondWait(pool->start, pool->lock);
+        }
+        if (pool->stopping) {
+            break;
+        }
+        seen = pool->generation;
+        SDL_UnlockMutex(pool->lock);
+
+        run_chunks(pool, worker->thread);
+
+        SDL_LockMutex(pool->lock);
+        pool->busy_workers--;
+        if (pool->busy_workers == 0) {
+            SDL_CondSignal(pool->done);
+        }
+    }
+    SDL_UnlockMutex(pool->lock);
+    return 0;
+}
+
+thread_pool_t *thread_pool_init(size_t threads) {
+    assert(threads > 0);
+    thread_pool_t *pool = malloc(sizeof(thread_pool_t));
+    assert(pool != NULL);
+    pool->threads = threads;
+    pool->generation = 0;
+    pool->busy_workers = 0;
+    pool->stopping = false;
+    pool->task = NULL;
+    pool->aux = NULL;
+    pool->count = 0;
+    SDL_AtomicSet(&pool->next_chunk, 0);
+    pool->lock = SDL_CreateMutex();
+    pool->start = SDL_CreateCond();
+    pool->done = SDL_CreateCond();
+    assert(pool->lock != NULL && pool->start != NULL && pool->done != NULL);
+
+    // The calling thread is thread 0 and has no worker of its own
+    pool->workers = malloc(threads * sizeof(worker_t));
+    assert(pool->workers != NULL);
+    for (size_t i = 1; i < threads; i++) {
+        worker_t *worker = &pool->workers[i];
+        worker->pool = pool;
+        worker->thread = i;
+        worker->handle = SDL_CreateThread(worker_main, "thread_pool", worker);
+        assert(worker->handle != NULL);
+    }
+    return pool;
+}
+
+void thread_pool_free(thread_pool_t *pool) {
+    SDL_LockMutex(pool->lock);
+    pool->stopping = true;
+    SDL_CondBroadcast(pool->start);
+    SDL_UnlockMutex(pool->lock);
+    for (size_t i = 1; i < pool->threads; i++) {
+        SDL_WaitThread(pool->workers[i].handle, NULL);
+    }
+    SDL_DestroyCond(pool->start);
+    SDL_DestroyCond(pool->done);
+    SDL_DestroyMutex(pool->lock);
+    free(pool->workers);
+    free(pool);
+}
+
+size_t thread_pool_threads(thread_pool_t *pool) {
+    return pool->threads;
+}
+
+void thread_pool_for(thread_pool_t *pool, size_t count, parallel_task_t task, void *aux) {
+    // A single chunk isn't worth waking the workers for
+    if (pool->threads == 1 || count <= CHUNK_SIZE) {
+        for (size_t i = 0; i < count; i++) {
+            task(aux, i, 0);
+        }
+        return;
+    }
+
+    SDL_LockMutex(pool->lock);
+    pool->task = task;
+    pool->aux = aux;
+    pool->count = count;
+    SDL_AtomicSet(&pool->next_chunk, 0);
+    pool->busy_workers = pool->threads - 1;
+    pool->generation++;
+    SDL_CondBroadcast(pool->start);
+    SDL_UnlockMutex(pool->lock);
+
+    run_chunks(pool, 0);
+
+    SDL_LockMutex(pool->lock);
+    while (pool->busy_workers > 0) {
+        SDL_CondWait(pool->done, pool->lock);
+    }
+    SDL_UnlockMutex(pool->lock);
+}
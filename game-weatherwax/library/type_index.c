@@ -0,0 +1,171 @@
+#include <assert.h>
+#include <stdlib.h>
+#include "body_watch.h"
+#include "type_index.h"
+
+static const size_t INITIAL_CAPACITY = 8;
+
+/** A body filed in the index, and where */
+typedef struct filed {
+    type_index_t *index;
+    body_t *body;
+    size_t type;
+    size_t position;
+} filed_t;
+
+typedef struct bucket {
+    filed_t **entries;
+    size_t count;
+    size_t capacity;
+} bucket_t;
+
+struct type_index {
+    scene_t *scene;
+    size_t refs;
+
+    // One bucket per body type, grown as larger types show up
+    bucket_t *buckets;
+    size_t bucket_count;
+    // How many of the scene's first bodies are filed
+    size_t synced;
+};
+
+static void type_index_noop(void *aux) {}
+
+static void type_index_release_ref(type_index_t *index) {
+    index->refs--;
+    if (index->refs == 0) {
+        for (size_t i = 0; i < index->bucket_count; i++) {
+            free(index->buckets[i].entries);
+        }
+        free(index->buckets);
+        free(index);
+    }
+}
+
+static bucket_t *get_bucket(type_index_t *index, size_t type) {
+    if (type >= index->bucket_count) {
+        size_t count = index->bucket_count;
+        index->bucket_count = type + 1;
+        index->buckets = realloc(index->buckets, index->bucket_count * sizeof(bucket_t));
+        assert(index->buckets != NULL);
+        for (size_t i = count; i < index->bucket_count; i++) {
+            index->buckets[i] = (bucket_t) {NULL, 0, 0};
+        }
+    }
+    return &index->buckets[type];
+}
+
+static void file(type_index_t *index, filed_t *filed, size_t type) {
+    bucket_t *bucket = get_bucket(index, type);
+    if (bucket->count == bucket->capacity) {
+        bucket->capacity = bucket->capacity == 0 ? INITIAL_CAPACITY : bucket->capacity * 2;
+        bucket->entries = realloc(bucket->entries, bucket->capacity * sizeof(filed_t *));
+        assert(bucket->entries != NULL);
+    }
+    filed->type = type;
+    filed->position = bucket->count;
+    bucket->entries[bucket->count++] = filed;
+}
+
+/** Takes a body out of its bucket by swapping in the bucket's last body */
+static void unfile(type_index_t *index, filed_t *filed) {
+    bucket_t *bucket = &index->buckets[filed->type];
+    filed_t *last = bucket->entries[--bucket->count];
+    bucket->entries[filed->position] = last;
+    last->position = filed->position;
+}
+
+static void forget_body(filed_t *filed) {
+    type_index_t *index = filed->index;
+    unfile(index, filed);
+    index->synced--;
+    free(filed);
+    type_index_release_ref(index);
+}
+
+/** Files the bodies added to the scene since the last sync */
+static void sync(type_index_t *index) {
+    size_t bodies = scene_bodies(index->scene);
+    for (size_t i = index->synced; i < bodies; i++) {
+        filed_t *filed = malloc(sizeof(filed_t));
+        assert(filed != NULL);
+        filed->index = index;
+        filed->body = scene_get_body(index->scene, i);
+        file(index, filed, body_get_type(filed->body));
+        index->refs++;
+        body_watch(index->scene, filed->body, (free_func_t) forget_body, filed);
+    }
+    index->synced = bodies;
+}
+
+/** Moves bodies whose type changed out of a bucket */
+static void refile_changed(type_index_t *index, size_t type) {
+    bucket_t *bucket = &index->buckets[type];
+    size_t i = 0;
+    while (i < bucket->count) {
+        filed_t *filed = bucket->entries[i];
+        size_t actual = body_get_type(filed->body);
+        if (actual == type) {
+            i++;
+            continue;
+        }
+        // The bucket's last body is swapped into position i
+        unfile(index, filed);
+        file(index, filed, actual);
+        bucket = &index->buckets[type];
+    }
+}
+
+static filed_t *find_filed(type_index_t *index, size_t type, body_t *body) {
+    if (type >= index->bucket_count) {
+        return NULL;
+    }
+    bucket_t *bucket = &index->buckets[type];
+    for (size_t i = 0; i < bucket->count; i++) {
+        if (bucket->entries[i]->body == body) {
+            return bucket->entries[i];
+        }
+    }
+    return NULL;
+}
+
+type_index_t *create_type_index(scene_t *scene) {
+    type_index_t *index = malloc(sizeof(type_index_t));
+    assert(index != NULL);
+    index->scene = scene;
+    index->refs = 1;
+    index->buckets = NULL;
+    index->bucket_count = 0;
+    index->synced = 0;
+    scene_add_force_creator(scene, type_index_noop, index, (free_func_t) type_index_release_ref);
+    return index;
+}
+
+size_t type_index_bodies(type_index_t *index, body_type_t type) {
+    sync(index);
+    if ((size_t) type >= index->bucket_count) {
+        return 0;
+    }
+    refile_changed(index, type);
+    return index->buckets[type].count;
+}
+
+body_t *type_index_get_body(type_index_t *index, body_type_t type, size_t i) {
+    assert((size_t) type < index->bucket_count && i < index->buckets[type].count);
+    return index->buckets[type].entries[i]->body;
+}
+
+void type_index_set_type(type_index_t *index, body_t *body, body_type_t type) {
+    sync(index);
+    // The body is filed under its current type,
+    // unless that was changed with body_set_type() since its bucket was last queried
+    filed_t *filed = find_filed(index, body_get_type(body), body);
+    for (size_t t = 0; t < index->bucket_count && filed == NULL; t++) {
+        filed = find_filed(index, t, body);
+    }
+    assert(filed != NULL);
+    body_set_type(body, type);
+    unfile(index, filed);
+    file(index, filed, type);
+}
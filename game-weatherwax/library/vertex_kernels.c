@@ -0,0 +1,238 @@
+#include <math.h>
+#include <stdbool.h>
+#include "vertex_kernels.h"
+
+#if defined(__x86_64__) || defined(_M_X64)
+#include <emmintrin.h>
+#define HAVE_SSE2
+#endif
+
+// AVX2 versions need per-function target attributes and runtime detection,
+// which MSVC does not have in the same form, so they are GCC/clang only
+#if defined(HAVE_SSE2) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#define HAVE_AVX2
+#define AVX2 __attribute__((target("avx2")))
+#endif
+
+// ===== SCALAR =====
+
+static void scalar_translate(double *x, double *y, size_t start, size_t n, vector_t t) {
+    for (size_t i = start; i < n; i++) {
+        x[i] += t.x;
+        y[i] += t.y;
+    }
+}
+
+static void scalar_rotate(double *out_x, double *out_y, const double *x, const double *y,
+    size_t start, size_t n, double c, double s, vector_t pivot, vector_t offset) {
+    for (size_t i = start; i < n; i++) {
+        double dx = x[i] - pivot.x;
+        double dy = y[i] - pivot.y;
+        out_x[i] = offset.x + dx * c - dy * s;
+        out_y[i] = offset.y + dx * s + dy * c;
+    }
+}
+
+static void scalar_extent(const double *x, const double *y, size_t start, size_t n,
+    vector_t *min, vector_t *max) {
+    for (size_t i = start; i < n; i++) {
+        min->x = fmin(min->x, x[i]);
+        min->y = fmin(min->y, y[i]);
+        max->x = fmax(max->x, x[i]);
+        max->y = fmax(max->y, y[i]);
+    }
+}
+
+// ===== SSE2 =====
+
+#ifdef HAVE_SSE2
+static size_t sse2_translate(double *x, double *y, size_t n, vector_t t) {
+    __m128d tx = _mm_set1_pd(t.x);
+    __m128d ty = _mm_set1_pd(t.y);
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2) {
+        _mm_storeu_pd(&x[i], _mm_add_pd(_mm_loadu_pd(&x[i]), tx));
+        _mm_storeu_pd(&y[i], _mm_add_pd(_mm_loadu_pd(&y[i]), ty));
+    }
+    return i;
+}
+
+static size_t sse2_rotate(double *out_x, double *out_y, const double *x, const double *y,
+    size_t n, double c, double s, vector_t pivot, vector_t offset) {
+    __m128d vc = _mm_set1_pd(c);
+    __m128d vs = _mm_set1_pd(s);
+    __m128d px = _mm_set1_pd(pivot.x);
+    __m128d py = _mm_set1_pd(pivot.y);
+    __m128d ox = _mm_set1_pd(offset.x);
+    __m128d oy = _mm_set1_pd(offset.y);
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2) {
+        __m128d dx = _mm_sub_pd(_mm_loadu_pd(&x[i]), px);
+        __m128d dy = _mm_sub_pd(_mm_loadu_pd(&y[i]), py);
+        __m128d rx = _mm_sub_pd(_mm_add_pd(ox, _mm_mul_pd(dx, vc)), _mm_mul_pd(dy, vs));
+        __m128d ry = _mm_add_pd(_mm_add_pd(oy, _mm_mul_pd(dx, vs)), _mm_mul_pd(dy, vc));
+        _mm_storeu_pd(&out_x[i], rx);
+        _mm_storeu_pd(&out_y[i], ry);
+    }
+    return i;
+}
+
+static size_t sse2_extent(const double *x, const double *y, size_t n, vector_t *min, vector_t *max) {
+    if (n < 2) {
+        return 0;
+    }
+    __m128d lo_x = _mm_set1_pd(min->x);
+    __m128d lo_y = _mm_set1_pd(min->y);
+    __m128d hi_x = _mm_set1_pd(max->x);
+    __m128d hi_y = _mm_set1_pd(max->y);
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2) {
+        __m128d vx = _mm_loadu_pd(&x[i]);
+        __m128d vy = _mm_loadu_pd(&y[i]);
+        lo_x = _mm_min_pd(lo_x, vx);
+        lo_y = _mm_min_pd(lo_y, vy);
+        hi_x = _mm_max_pd(hi_x, vx);
+        hi_y = _mm_max_pd(hi_y, vy);
+    }
+    double lanes[2];
+    _mm_storeu_pd(lanes, lo_x);
+    min->x = fmin(lanes[0], lanes[1]);
+    _mm_storeu_pd(lanes, lo_y);
+    min->y = fmin(lanes[0], lanes[1]);
+    _mm_storeu_pd(lanes, hi_x);
+    max->x = fmax(lanes[0], lanes[1]);
+    _mm_storeu_pd(lanes, hi_y);
+    max->y = fmax(lanes[0], lanes[1]);
+    return i;
+}
+#endif
+
+// ===== AVX2 =====
+
+#ifdef HAVE_AVX2
+static bool has_avx2(void) {
+    return __builtin_cpu_supports("avx2");
+}
+
+AVX2 static size_t avx2_translate(double *x, double *y, size_t n, vector_t t) {
+    __m256d tx = _mm256_set1_pd(t.x);
+    __m256d ty = _mm256_set1_pd(t.y);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        _mm256_storeu_pd(&x[i], _mm256_add_pd(_mm256_loadu_pd(&x[i]), tx));
+        _mm256_storeu_pd(&y[i], _mm256_add_pd(_mm256_loadu_pd(&y[i]), ty));
+    }
+    return i;
+}
+
+AVX2 static size_t avx2_rotate(double *out_x, double *out_y, const double *x, const double *y,
+    size_t n, double c, double s, vector_t pivot, vector_t offset) {
+    __m256d vc = _mm256_set1_pd(c);
+    __m256d vs = _mm256_set1_pd(s);
+    __m256d px = _mm256_set1_pd(pivot.x);
+    __m256d py = _mm256_set1_pd(pivot.y);
+    __m256d ox = _mm256_set1_pd(offset.x);
+    __m256d oy = _mm256_set1_pd(offset.y);
+    size_t i = 0;
+    // Separate multiplies and adds rather than FMA, to round like the scalar loop
+    for (; i + 4 <= n; i += 4) {
+        __m256d dx = _mm256_sub_pd(_mm256_loadu_pd(&x[i]), px);
+        __m256d dy = _mm256_sub_pd(_mm256_loadu_pd(&y[i]), py);
+        __m256d rx = _mm256_sub_pd(_mm256_add_pd(ox, _mm256_mul_pd(dx, vc)), _mm256_mul_pd(dy, vs));
+        __m256d ry = _mm256_add_pd(_mm256_add_pd(oy, _mm256_mul_pd(dx, vs)), _mm256_mul_pd(dy, vc));
+        _mm256_storeu_pd(&out_x[i], rx);
+        _mm256_storeu_pd(&out_y[i], ry);
+    }
+    return i;
+}
+
+AVX2 static size_t avx2_extent(const double *x, const double *y, size_t n, vector_t *min, vector_t *max) {
+    if (n < 4) {
+        return 0;
+    }
+    __m256d lo_x = _mm256_set1_pd(min->x);
+    __m256d lo_y = _mm256_set1_pd(min->y);
+    __m256d hi_x = _mm256_set1_pd(max->x);
+    __m256d hi_y = _mm256_set1_pd(max->y);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256d vx = _mm256_loadu_pd(&x[i]);
+        __m256d vy = _mm256_loadu_pd(&y[i]);
+        lo_x = _mm256_min_pd(lo_x, vx);
+        lo_y = _mm256_min_pd(lo_y, vy);
+        hi_x = _mm256_max_pd(hi_x, vx);
+        hi_y = _mm256_max_pd(hi_y, vy);
+    }
+    double lanes[4];
+    _mm256_storeu_pd(lanes, lo_x);
+    min->x = fmin(fmin(lanes[0], lanes[1]), fmin(lanes[2], lanes[3]));
+    _mm256_storeu_pd(lanes, lo_y);
+    min->y = fmin(fmin(lanes[0], lanes[1]), fmin(lanes[2], lanes[3]));
+    _mm256_storeu_pd(lanes, hi_x);
+    max->x = fmax(fmax(lanes[0], lanes[1]), fmax(lanes[2], lanes[3]));
+    _mm256_storeu_pd(lanes, hi_y);
+    max->y = fmax(fmax(lanes[0], lanes[1]), fmax(lanes[2], lanes[3]));
+    return i;
+}
+#endif
+
+// ===== DISPATCH =====
+// Each vector version handles whole groups of vertices and returns how many
+// it did; the scalar loop finishes the rest.
+
+typedef size_t (*rotate_kernel_t)(double *out_x, double *out_y, const double *x, const double *y,
+    size_t n, double c, double s, vector_t pivot, vector_t offset);
+
+/** Picks the widest rotate kernel the CPU supports, or NULL for the scalar loop alone */
+static rotate_kernel_t rotate_kernel(void) {
+#if defined(HAVE_AVX2)
+    return has_avx2() ? avx2_rotate : sse2_rotate;
+#elif defined(HAVE_SSE2)
+    return sse2_rotate;
+#else
+    return NULL;
+#endif
+}
+
+static void rotate_with(rotate_kernel_t kernel, const vertex_transform_t *t) {
+    double c = cos(t->angle);
+    double s = sin(t->angle);
+    size_t done = kernel == NULL ? 0 : kernel(t->out_x, t->out_y, t->x, t->y, t->n, c, s, t->pivot, t->offset);
+    scalar_rotate(t->out_x, t->out_y, t->x, t->y, done, t->n, c, s, t->pivot, t->offset);
+}
+
+void vertices_translate(double *x, double *y, size_t n, vector_t translation) {
+    size_t done = 0;
+#if defined(HAVE_AVX2)
+    done = has_avx2() ? avx2_translate(x, y, n, translation) : sse2_translate(x, y, n, translation);
+#elif defined(HAVE_SSE2)
+    done = sse2_translate(x, y, n, translation);
+#endif
+    scalar_translate(x, y, done, n, translation);
+}
+
+void vertices_rotate(double *out_x, double *out_y, const double *x, const double *y, size_t n,
+    double angle, vector_t pivot, vector_t offset) {
+    vertex_transform_t transform = {out_x, out_y, x, y, n, angle, pivot, offset};
+    rotate_with(rotate_kernel(), &transform);
+}
+
+void vertices_rotate_batch(const vertex_transform_t *transforms, size_t count) {
+    rotate_kernel_t kernel = rotate_kernel();
+    for (size_t i = 0; i < count; i++) {
+        rotate_with(kernel, &transforms[i]);
+    }
+}
+
+void vertices_extent(const double *x, const double *y, size_t n, vector_t *min, vector_t *max) {
+    *min = (vector_t) {INFINITY, INFINITY};
+    *max = (vector_t) {-INFINITY, -INFINITY};
+    size_t done = 0;
+#if defined(HAVE_AVX2)
+    done = has_avx2() ? avx2_extent(x, y, n, min, max) : sse2_extent(x, y, n, min, max);
+#elif defined(HAVE_SSE2)
+    done = sse2_extent(x, y, n, min, max);
+#endif
+    scalar_extent(x, y, done, n, min, max);
+}
@@ -0,0 +1,26 @@
+#ifndef __TEST_SUITE_H__
+#define __TEST_SUITE_H__
+
+#include <stdbool.h>
+#include <string.h>
+
+/**
+ * Shared by the test suites in tests/.
+ * Each suite's main() sets all_tests and testname from its arguments,
+ * then lists its tests with DO_TEST:
+ *
+ *     bool all_tests = argc == 1;
+ *     char *testname = all_tests ? NULL : argv[1];
+ *     DO_TEST(test_something)
+ */
+
+// The staff test_util.h may define the same macro
+#ifndef DO_TEST
+// Runs a test if every test was asked for or it is the one named on the command line
+#define DO_TEST(TEST) \
+    if (all_tests || strcmp(testname, #TEST) == 0) { \
+        TEST(); \
+    }
+#endif
+
+#endif // #ifndef __TEST_SUITE_H__
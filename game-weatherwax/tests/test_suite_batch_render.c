@@ -0,0 +1,147 @@
+#include <assert.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <SDL2/SDL.h>
+#include "batch_render.h"
+#include "scene.h"
+#include "sdl_window.h"
+#include "sdl_wrapper.h"
+#include "shape.h"
+#include "shape_cache.h"
+#include "test_suite.h"
+
+static const vector_t WINDOW_MIN = {0, 0};
+static const vector_t WINDOW_MAX = {100, 50};
+static const rgb_color_t RED = {1, 0, 0};
+static const rgb_color_t GREEN = {0, 1, 0};
+static const rgb_color_t BLUE = {0, 0, 1};
+// A point nothing in these tests is drawn over
+static const vector_t EMPTY_POINT = {5, 5};
+
+/**
+ * Points drawing at a texture, which keeps what was drawn after the frame
+ * is shown, so it can be read back.
+ */
+SDL_Texture *start_reading() {
+    int width, height;
+    SDL_GetRendererOutputSize(renderer, &width, &height);
+    SDL_Texture *target = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA32, SDL_TEXTUREACCESS_TARGET, width, height);
+    assert(target != NULL);
+    SDL_SetRenderTarget(renderer, target);
+    return target;
+}
+
+void stop_reading(SDL_Texture *target) {
+    SDL_SetRenderTarget(renderer, NULL);
+    SDL_DestroyTexture(target);
+}
+
+/** Reads the color drawn at a scene point */
+SDL_Color read_color(vector_t point) {
+    vector_t pixel = get_window_position(point, get_window_center());
+    SDL_Rect rect = {(int) pixel.x, (int) pixel.y, 1, 1};
+    SDL_Color color;
+    int result = SDL_RenderReadPixels(renderer, &rect, SDL_PIXELFORMAT_RGBA32, &color, sizeof(color));
+    assert(result == 0);
+    return color;
+}
+
+bool same_color(SDL_Color color1, SDL_Color color2) {
+    return color1.r == color2.r && color1.g == color2.g && color1.b == color2.b;
+}
+
+bool is_color(SDL_Color color, rgb_color_t expected) {
+    SDL_Color sdl_color = {expected.r * 255, expected.g * 255, expected.b * 255, 255};
+    return same_color(color, sdl_color);
+}
+
+body_t *add_rectangle(scene_t *scene, vector_t center, double size, rgb_color_t color) {
+    body_t *body = body_init(make_shape_rectangle(size, size, center), 1, color);
+    scene_add_body(scene, body);
+    return body;
+}
+
+void test_matches_sdl_render_scene() {
+    scene_t *scene = scene_init();
+    shape_cache_t *shapes = create_shape_cache(scene);
+    add_rectangle(scene, (vector_t) {25, 25}, 20, RED);
+    // Drawn over the right half of the red square
+    add_rectangle(scene, (vector_t) {35, 25}, 20, GREEN);
+    scene_add_body(scene, body_init(make_shape_circle(8, (vector_t) {75, 25}, 40), 1, BLUE));
+    // Outside the window, so skipped
+    add_rectangle(scene, (vector_t) {200, 25}, 20, RED);
+    vector_t points[] = {{18, 25}, {30, 25}, {42, 25}, {75, 25}, {75, 30}, {60, 45}, EMPTY_POINT};
+    size_t point_count = sizeof(points) / sizeof(points[0]);
+    SDL_Color expected[sizeof(points) / sizeof(points[0])];
+
+    SDL_Texture *target = start_reading();
+    sdl_render_scene(scene);
+    for (size_t i = 0; i < point_count; i++) {
+        expected[i] = read_color(points[i]);
+    }
+    assert(is_color(expected[0], RED) && is_color(expected[1], GREEN) && is_color(expected[3], BLUE));
+
+    batch_render_t *batch = batch_render_init();
+    // The second frame reuses the first one's buffers
+    for (size_t frame = 0; frame < 2; frame++) {
+        batch_render_scene(batch, scene, shapes);
+        for (size_t i = 0; i < point_count; i++) {
+            assert(same_color(read_color(points[i]), expected[i]));
+        }
+    }
+    stop_reading(target);
+    batch_render_free(batch);
+    scene_free(scene);
+}
+
+void test_view() {
+    scene_t *scene = scene_init();
+    shape_cache_t *shapes = create_shape_cache(scene);
+    body_t *red = add_rectangle(scene, (vector_t) {50, 25}, 10, RED);
+    body_t *green = add_rectangle(scene, (vector_t) {55, 25}, 10, GREEN);
+    batch_render_t *batch = batch_render_init();
+    SDL_Texture *target = start_reading();
+
+    // The camera shifts everything the other way
+    render_view_t view = {(vector_t) {20, 0}, NULL, NULL, 0};
+    batch_render_scene_view(batch, scene, shapes, &view);
+    SDL_Color background = read_color(EMPTY_POINT);
+    assert(is_color(read_color((vector_t) {28, 25}), RED));
+    assert(is_color(read_color((vector_t) {38, 25}), GREEN));
+    assert(same_color(read_color((vector_t) {50, 25}), background));
+
+    // The top body is drawn over the ones after it
+    view = (render_view_t) {VEC_ZERO, red, NULL, 0};
+    batch_render_scene_view(batch, scene, shapes, &view);
+    assert(is_color(read_color((vector_t) {52, 25}), RED));
+    assert(is_color(read_color((vector_t) {58, 25}), GREEN));
+
+    // Poses move where bodies are drawn, not the bodies
+    draw_pose_t poses[] = {{{20, 10}, 0}, {{80, 40}, 0}};
+    view = (render_view_t) {VEC_ZERO, NULL, poses, 2};
+    batch_render_scene_view(batch, scene, shapes, &view);
+    assert(is_color(read_color((vector_t) {20, 10}), RED));
+    assert(is_color(read_color((vector_t) {80, 40}), GREEN));
+    assert(same_color(read_color((vector_t) {52, 25}), background));
+    assert(body_get_centroid(red).x == 50 && body_get_centroid(green).x == 55);
+
+    stop_reading(target);
+    batch_render_free(batch);
+    scene_free(scene);
+}
+
+int main(int argc, char *argv[]) {
+    // Run all tests if there are no command-line arguments
+    bool all_tests = argc == 1;
+    char *testname = all_tests ? NULL : argv[1];
+
+    // Drawing needs a renderer, but not a window on screen
+    SDL_setenv("SDL_VIDEODRIVER", "dummy", 1);
+    sdl_init(WINDOW_MIN, WINDOW_MAX);
+
+    DO_TEST(test_matches_sdl_render_scene)
+    DO_TEST(test_view)
+
+    puts("batch_render_test PASS");
+}
@@ -0,0 +1,128 @@
+#include <assert.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "body_pool.h"
+#include "scene.h"
+#include "shape.h"
+#include "test_suite.h"
+
+/** Counts the bodies a pool makes and whether its aux was freed */
+typedef struct maker_log {
+    size_t made;
+    bool freed;
+} maker_log_t;
+
+body_t *make_body(body_pool_t *pool, void *aux) {
+    maker_log_t *log = aux;
+    log->made++;
+    body_t *body = body_init(make_shape_circle(1, VEC_ZERO, 8), 1, (rgb_color_t) {0, 0, 0});
+    scene_add_body(body_pool_get_scene(pool), body);
+    return body;
+}
+
+void free_log(void *aux) {
+    maker_log_t *log = aux;
+    log->freed = true;
+}
+
+void test_acquire_release() {
+    maker_log_t log = {0};
+    scene_t *scene = scene_init();
+    body_pool_t *pool = create_body_pool(scene, make_body, &log, NULL);
+    assert(body_pool_get_scene(pool) == scene);
+    assert(body_pool_size(pool) == 0);
+
+    body_t *first = body_pool_acquire(pool, (vector_t) {3, 4}, (vector_t) {0, 10});
+    assert(log.made == 1);
+    assert(body_visible(first));
+    assert(body_get_centroid(first).x == 3 && body_get_centroid(first).y == 4);
+    assert(body_get_velocity(first).y == 10);
+
+    // All bodies are in use, so another one is made
+    body_t *second = body_pool_acquire(pool, VEC_ZERO, VEC_ZERO);
+    assert(second != first);
+    assert(log.made == 2 && body_pool_size(pool) == 2);
+
+    body_pool_release(pool, first);
+    assert(!body_visible(first));
+    assert(body_get_velocity(first).x == 0 && body_get_velocity(first).y == 0);
+    // Parked bodies stay in the scene
+    assert(scene_bodies(scene) == 2);
+
+    body_t *again = body_pool_acquire(pool, (vector_t) {7, 8}, VEC_ZERO);
+    assert(again == first);
+    assert(body_visible(again));
+    assert(body_get_centroid(again).x == 7 && body_get_centroid(again).y == 8);
+    assert(log.made == 2);
+    scene_free(scene);
+}
+
+void test_release_twice() {
+    maker_log_t log = {0};
+    scene_t *scene = scene_init();
+    body_pool_t *pool = create_body_pool(scene, make_body, &log, NULL);
+    body_t *body = body_pool_acquire(pool, VEC_ZERO, VEC_ZERO);
+    body_pool_release(pool, body);
+    body_pool_release(pool, body);
+    // Parked once, so it is only handed out once
+    body_t *first = body_pool_acquire(pool, VEC_ZERO, VEC_ZERO);
+    body_t *second = body_pool_acquire(pool, VEC_ZERO, VEC_ZERO);
+    assert(first == body && second != body);
+    assert(body_pool_size(pool) == 2);
+    scene_free(scene);
+}
+
+void test_steady_state() {
+    maker_log_t log = {0};
+    scene_t *scene = scene_init();
+    body_pool_t *pool = create_body_pool(scene, make_body, &log, NULL);
+    // Fire one body a tick and release each one 10 ticks later
+    body_t *live[10] = {NULL};
+    for (size_t tick = 0; tick < 1000; tick++) {
+        size_t slot = tick % 10;
+        if (live[slot] != NULL) {
+            body_pool_release(pool, live[slot]);
+        }
+        live[slot] = body_pool_acquire(pool, VEC_ZERO, (vector_t) {0, 1});
+        scene_tick(scene, 0.01);
+    }
+    assert(log.made == 10);
+    assert(scene_bodies(scene) == 10);
+    scene_free(scene);
+}
+
+void test_removed_body_forgotten() {
+    maker_log_t log = {0};
+    scene_t *scene = scene_init();
+    body_pool_t *pool = create_body_pool(scene, make_body, &log, free_log);
+    body_t *kept = body_pool_acquire(pool, VEC_ZERO, VEC_ZERO);
+    body_t *removed = body_pool_acquire(pool, VEC_ZERO, VEC_ZERO);
+    body_pool_release(pool, kept);
+    body_pool_release(pool, removed);
+    body_remove(removed);
+    scene_tick(scene, 0.01);
+    assert(body_pool_size(pool) == 1);
+    assert(body_pool_get(pool, 0) == kept);
+
+    assert(body_pool_acquire(pool, VEC_ZERO, VEC_ZERO) == kept);
+    body_pool_acquire(pool, VEC_ZERO, VEC_ZERO);
+    assert(log.made == 3);
+    assert(!log.freed);
+    scene_free(scene);
+    assert(log.freed);
+}
+
+int main(int argc, char *argv[]) {
+    // Run all tests if there are no command-line arguments
+    bool all_tests = argc == 1;
+    char *testname = all_tests ? NULL : argv[1];
+
+    DO_TEST(test_acquire_release)
+    DO_TEST(test_release_twice)
+    DO_TEST(test_steady_state)
+    DO_TEST(test_removed_body_forgotten)
+
+    puts("body_pool_test PASS");
+}
@@ -0,0 +1,115 @@
+#include <assert.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include "body_table.h"
+#include "rng.h"
+#include "scene.h"
+#include "shape.h"
+#include "test_suite.h"
+
+static const size_t BODY_COUNT = 500;
+
+body_t *add_body(scene_t *scene) {
+    body_t *body = body_init(make_shape_circle(1, VEC_ZERO, 4), 1, (rgb_color_t) {0, 0, 0});
+    scene_add_body(scene, body);
+    return body;
+}
+
+bool scene_has_body(scene_t *scene, body_t *body) {
+    for (size_t i = 0; i < scene_bodies(scene); i++) {
+        if (scene_get_body(scene, i) == body) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void test_add_get() {
+    scene_t *scene = scene_init();
+    body_table_t *table = create_body_table(scene);
+    assert(body_table_size(table) == 0);
+    assert(body_table_get(table, NO_BODY_HANDLE) == NULL);
+
+    body_t *body1 = add_body(scene);
+    body_t *body2 = add_body(scene);
+    body_handle_t handle1 = body_table_add(table, body1);
+    body_handle_t handle2 = body_table_add(table, body2);
+    assert(body_table_size(table) == 2);
+    assert(body_table_get(table, handle1) == body1);
+    assert(body_table_get(table, handle2) == body2);
+    assert(body_handle_equal(handle1, handle1));
+    assert(!body_handle_equal(handle1, handle2));
+    assert(!body_handle_equal(handle1, NO_BODY_HANDLE));
+    scene_free(scene);
+}
+
+void test_stale_handle() {
+    scene_t *scene = scene_init();
+    body_table_t *table = create_body_table(scene);
+    body_t *body = add_body(scene);
+    body_handle_t old = body_table_add(table, body);
+    body_remove(body);
+    scene_tick(scene, 0.01);
+    assert(body_table_get(table, old) == NULL);
+    assert(body_table_size(table) == 0);
+
+    // The new body may reuse the slot, but the old handle stays stale
+    body_t *replacement = add_body(scene);
+    body_handle_t handle = body_table_add(table, replacement);
+    assert(!body_handle_equal(old, handle));
+    assert(body_table_get(table, old) == NULL);
+    assert(body_table_get(table, handle) == replacement);
+    scene_free(scene);
+}
+
+void test_random_removals() {
+    rng_t rng = rng_init(1);
+    scene_t *scene = scene_init();
+    body_table_t *table = create_body_table(scene);
+    body_handle_t handles[BODY_COUNT];
+    body_t *bodies[BODY_COUNT];
+    for (size_t i = 0; i < BODY_COUNT; i++) {
+        bodies[i] = add_body(scene);
+        handles[i] = body_table_add(table, bodies[i]);
+    }
+
+    for (size_t round = 0; round < 20; round++) {
+        for (size_t i = 0; i < BODY_COUNT; i++) {
+            if (rng_double(&rng) < 0.25) {
+                body_remove(bodies[i]);
+            }
+        }
+        scene_tick(scene, 0.01);
+        assert(body_table_size(table) == scene_bodies(scene));
+        for (size_t i = 0; i < body_table_size(table); i++) {
+            assert(scene_has_body(scene, body_table_body(table, i)));
+        }
+
+        for (size_t i = 0; i < BODY_COUNT; i++) {
+            body_t *body = body_table_get(table, handles[i]);
+            if (body != NULL) {
+                assert(body == bodies[i]);
+                continue;
+            }
+            body_handle_t old = handles[i];
+            bodies[i] = add_body(scene);
+            handles[i] = body_table_add(table, bodies[i]);
+            assert(body_table_get(table, old) == NULL);
+            assert(body_table_get(table, handles[i]) == bodies[i]);
+        }
+    }
+    scene_free(scene);
+}
+
+int main(int argc, char *argv[]) {
+    // Run all tests if there are no command-line arguments
+    bool all_tests = argc == 1;
+    char *testname = all_tests ? NULL : argv[1];
+
+    DO_TEST(test_add_get)
+    DO_TEST(test_stale_handle)
+    DO_TEST(test_random_removals)
+
+    puts("body_table_test PASS");
+}
@@ -0,0 +1,432 @@
+#include <assert.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include "broad_phase.h"
+#include "collision.h"
+#include "rng.h"
+#include "scene.h"
+#include "shape.h"
+#include "test_suite.h"
+
+// Sizes the hit records, so it must be a constant expression
+#define BODY_COUNT 80
+static const double CELL_SIZE = 10.0;
+static const double BODY_RADIUS = 3.0;
+static const size_t BODY_POINTS = 12;
+static const double AREA_SIZE = 120.0;
+static const double MAX_SPEED = 40.0;
+static const size_t TICKS = 200;
+static const double DT = 0.02;
+static const double GRAVITY = 10.0;
+static const size_t BOX_COUNT = 50;
+static const double BOX_SIZE = 10.0;
+static const uint32_t RED = 1 << 0;
+static const uint32_t BLUE = 1 << 1;
+
+/** Which pairs the broad phase reported on one tick */
+typedef struct hit_log {
+    body_t *bodies[BODY_COUNT];
+    // started[i][j], for i < j, is set when the handler is called for bodies i and j
+    bool started[BODY_COUNT][BODY_COUNT];
+} hit_log_t;
+
+size_t body_index(body_t **bodies, body_t *body) {
+    for (size_t i = 0; i < BODY_COUNT; i++) {
+        if (bodies[i] == body) {
+            return i;
+        }
+    }
+    assert(false);
+    return 0;
+}
+
+void record_hit(body_t *body1, body_t *body2, vector_t axis, void *aux) {
+    hit_log_t *log = aux;
+    size_t i = body_index(log->bodies, body1);
+    size_t j = body_index(log->bodies, body2);
+    if (i > j) {
+        size_t swap = i;
+        i = j;
+        j = swap;
+    }
+    // Once per tick at most
+    assert(!log->started[i][j]);
+    log->started[i][j] = true;
+}
+
+/** The stage of a contact reported for a pair on one tick */
+typedef enum {
+    NO_STAGE,
+    BEGIN_STAGE,
+    PERSIST_STAGE,
+    END_STAGE
+} contact_stage_t;
+
+/** Which contact stages the broad phase reported on one tick */
+typedef struct contact_log {
+    body_t *bodies[BODY_COUNT];
+    contact_stage_t stages[BODY_COUNT][BODY_COUNT];
+    // The axis of the pair's last begin or persist
+    vector_t axes[BODY_COUNT][BODY_COUNT];
+} contact_log_t;
+
+void record_stage(contact_log_t *log, body_t *body1, body_t *body2, vector_t axis, contact_stage_t stage) {
+    size_t i = body_index(log->bodies, body1);
+    size_t j = body_index(log->bodies, body2);
+    // Registered with the lower index first, so never swapped
+    assert(i < j);
+    // One stage per tick at most
+    assert(log->stages[i][j] == NO_STAGE);
+    log->stages[i][j] = stage;
+    if (stage == END_STAGE) {
+        assert(axis.x == log->axes[i][j].x && axis.y == log->axes[i][j].y);
+    }
+    else {
+        log->axes[i][j] = axis;
+    }
+}
+
+void record_begin(body_t *body1, body_t *body2, vector_t axis, void *aux) {
+    record_stage(aux, body1, body2, axis, BEGIN_STAGE);
+}
+
+void record_persist(body_t *body1, body_t *body2, vector_t axis, void *aux) {
+    record_stage(aux, body1, body2, axis, PERSIST_STAGE);
+}
+
+void record_end(body_t *body1, body_t *body2, vector_t axis, void *aux) {
+    record_stage(aux, body1, body2, axis, END_STAGE);
+}
+
+bool bodies_collide(body_t *body1, body_t *body2) {
+    list_t *shape1 = body_get_shape(body1);
+    list_t *shape2 = body_get_shape(body2);
+    bool collided = find_collision(shape1, shape2).collided;
+    list_free(shape1);
+    list_free(shape2);
+    return collided;
+}
+
+/** Records a hit from the red-blue rule, which must get the red body first */
+void record_red_blue(body_t *body1, body_t *body2, vector_t axis, void *aux) {
+    hit_log_t *log = aux;
+    assert(body_index(log->bodies, body1) % 3 == 0);
+    assert(body_index(log->bodies, body2) % 3 != 0);
+    record_hit(body1, body2, axis, aux);
+}
+
+void test_matches_brute_force() {
+    static hit_log_t log;
+    static bool colliding[BODY_COUNT][BODY_COUNT];
+    static bool was_colliding[BODY_COUNT][BODY_COUNT];
+    memset(was_colliding, 0, sizeof(was_colliding));
+    bool removed[BODY_COUNT] = {false};
+
+    rng_t rng = rng_init(1);
+    scene_t *scene = scene_init();
+    broad_phase_t *broad_phase = create_broad_phase(scene, CELL_SIZE);
+    for (size_t i = 0; i < BODY_COUNT; i++) {
+        vector_t center = {rng_range(&rng, 0, AREA_SIZE), rng_range(&rng, 0, AREA_SIZE)};
+        body_t *body = body_init(make_shape_circle(BODY_RADIUS, center, BODY_POINTS), 1, (rgb_color_t) {0, 0, 0});
+        body_set_velocity(body, (vector_t) {rng_range(&rng, -MAX_SPEED, MAX_SPEED), rng_range(&rng, -MAX_SPEED, MAX_SPEED)});
+        scene_add_body(scene, body);
+        for (size_t j = 0; j < i; j++) {
+            broad_phase_add_collision(broad_phase, body, log.bodies[j], record_hit, &log, NULL);
+        }
+        log.bodies[i] = body;
+    }
+
+    size_t hits = 0;
+    for (size_t tick = 0; tick < TICKS; tick++) {
+        // The handlers see the bodies where they are before the tick moves them
+        for (size_t i = 0; i < BODY_COUNT; i++) {
+            for (size_t j = i + 1; j < BODY_COUNT; j++) {
+                colliding[i][j] = !removed[i] && !removed[j] && bodies_collide(log.bodies[i], log.bodies[j]);
+            }
+        }
+        memset(log.started, 0, sizeof(log.started));
+        scene_tick(scene, DT);
+
+        for (size_t i = 0; i < BODY_COUNT; i++) {
+            for (size_t j = i + 1; j < BODY_COUNT; j++) {
+                if (removed[i] || removed[j]) {
+                    // Removed bodies are dropped, with their registrations, at the end of the tick after
+                    assert(tick <= TICKS / 2 + 1 || !log.started[i][j]);
+                    continue;
+                }
+                assert(log.started[i][j] == (colliding[i][j] && !was_colliding[i][j]));
+                hits += log.started[i][j];
+                was_colliding[i][j] = colliding[i][j];
+            }
+        }
+
+        if (tick == TICKS / 2) {
+            for (size_t i = 0; i < BODY_COUNT; i += 3) {
+                body_remove(log.bodies[i]);
+                removed[i] = true;
+            }
+        }
+    }
+    assert(hits > 50);
+    scene_free(scene);
+}
+
+void test_contacts_match_brute_force() {
+    static contact_log_t log;
+    static bool colliding[BODY_COUNT][BODY_COUNT];
+    static bool was_colliding[BODY_COUNT][BODY_COUNT];
+    memset(was_colliding, 0, sizeof(was_colliding));
+    bool removed[BODY_COUNT] = {false};
+    contact_handlers_t handlers = {record_begin, record_persist, record_end};
+
+    rng_t rng = rng_init(3);
+    scene_t *scene = scene_init();
+    broad_phase_t *broad_phase = create_broad_phase(scene, CELL_SIZE);
+    for (size_t i = 0; i < BODY_COUNT; i++) {
+        vector_t center = {rng_range(&rng, 0, AREA_SIZE), rng_range(&rng, 0, AREA_SIZE)};
+        body_t *body = body_init(make_shape_circle(BODY_RADIUS, center, BODY_POINTS), 1, (rgb_color_t) {0, 0, 0});
+        body_set_velocity(body, (vector_t) {rng_range(&rng, -MAX_SPEED, MAX_SPEED), rng_range(&rng, -MAX_SPEED, MAX_SPEED)});
+        scene_add_body(scene, body);
+        for (size_t j = 0; j < i; j++) {
+            broad_phase_add_contact(broad_phase, log.bodies[j], body, handlers, &log, NULL);
+        }
+        log.bodies[i] = body;
+    }
+
+    size_t counts[END_STAGE + 1] = {0};
+    for (size_t tick = 0; tick < TICKS; tick++) {
+        for (size_t i = 0; i < BODY_COUNT; i++) {
+            for (size_t j = i + 1; j < BODY_COUNT; j++) {
+                colliding[i][j] = !removed[i] && !removed[j] && bodies_collide(log.bodies[i], log.bodies[j]);
+            }
+        }
+        memset(log.stages, 0, sizeof(log.stages));
+        scene_tick(scene, DT);
+
+        for (size_t i = 0; i < BODY_COUNT; i++) {
+            for (size_t j = i + 1; j < BODY_COUNT; j++) {
+                if (removed[i] || removed[j]) {
+                    // Removing a body ends its contacts without an end
+                    assert(tick <= TICKS / 2 + 1 || log.stages[i][j] == NO_STAGE);
+                    continue;
+                }
+                contact_stage_t expected = NO_STAGE;
+                if (colliding[i][j]) {
+                    expected = was_colliding[i][j] ? PERSIST_STAGE : BEGIN_STAGE;
+                }
+                else if (was_colliding[i][j]) {
+                    expected = END_STAGE;
+                }
+                assert(log.stages[i][j] == expected);
+                counts[expected]++;
+                was_colliding[i][j] = colliding[i][j];
+            }
+        }
+
+        if (tick == TICKS / 2) {
+            for (size_t i = 0; i < BODY_COUNT; i += 3) {
+                body_remove(log.bodies[i]);
+                removed[i] = true;
+            }
+        }
+    }
+    assert(counts[BEGIN_STAGE] > 50 && counts[PERSIST_STAGE] > 50 && counts[END_STAGE] > 50);
+    scene_free(scene);
+}
+
+/** Pulls every body but the first, the floor, down */
+void pull_down(void *aux) {
+    scene_t *scene = aux;
+    for (size_t i = 1; i < scene_bodies(scene); i++) {
+        body_t *body = scene_get_body(scene, i);
+        body_add_force(body, (vector_t) {0, -GRAVITY * body_get_mass(body)});
+    }
+}
+
+void count_hit(body_t *body1, body_t *body2, vector_t axis, void *aux) {
+    size_t *count = aux;
+    (*count)++;
+}
+
+/** Makes a floor whose top is at y = 0, with a row of boxes resting on it */
+scene_t *make_resting_boxes(broad_phase_t **broad_phase) {
+    scene_t *scene = scene_init();
+    *broad_phase = create_broad_phase(scene, CELL_SIZE * 2);
+    body_t *floor = body_init(make_shape_rectangle(2000, 200, (vector_t) {1000, -100}), INFINITY, (rgb_color_t) {0, 0, 0});
+    scene_add_body(scene, floor);
+    scene_add_force_creator(scene, pull_down, scene, NULL);
+    for (size_t i = 0; i < BOX_COUNT; i++) {
+        vector_t center = {20 + 30 * i, BOX_SIZE / 2};
+        body_t *box = body_init(make_shape_rectangle(BOX_SIZE, BOX_SIZE, center), 1, (rgb_color_t) {0, 0, 0});
+        scene_add_body(scene, box);
+        broad_phase_add_physics_collision(*broad_phase, 0, box, floor);
+    }
+    return scene;
+}
+
+void test_resting_bodies_stay_put() {
+    broad_phase_t *broad_phase;
+    scene_t *scene = make_resting_boxes(&broad_phase);
+    for (size_t tick = 0; tick < 2000; tick++) {
+        scene_tick(scene, 0.01);
+        // Long after they fall asleep, the boxes neither sink nor bounce
+        for (size_t i = 1; i < scene_bodies(scene); i++) {
+            double y = body_get_centroid(scene_get_body(scene, i)).y;
+            assert(y > 0 && y <= BOX_SIZE / 2);
+        }
+    }
+    scene_free(scene);
+}
+
+void test_sleeping_bodies_still_hit() {
+    broad_phase_t *broad_phase;
+    scene_t *scene = make_resting_boxes(&broad_phase);
+    for (size_t tick = 0; tick < 100; tick++) {
+        scene_tick(scene, 0.01);
+    }
+
+    // A ball dropped on a sleeping box hits it
+    size_t ball_hits = 0;
+    body_t *box = scene_get_body(scene, 3);
+    vector_t above = vec_add(body_get_centroid(box), (vector_t) {0, 4 * BOX_SIZE});
+    body_t *ball = body_init(make_shape_circle(BOX_SIZE / 2, above, BODY_POINTS), 1, (rgb_color_t) {0, 0, 0});
+    body_set_velocity(ball, (vector_t) {0, -10 * BOX_SIZE});
+    scene_add_body(scene, ball);
+    broad_phase_add_collision(broad_phase, ball, box, count_hit, &ball_hits, NULL);
+    for (size_t tick = 0; tick < 100 && ball_hits == 0; tick++) {
+        scene_tick(scene, 0.01);
+    }
+    assert(ball_hits == 1);
+
+    // So does one a sleeping box is moved onto
+    size_t moved_hits = 0;
+    body_t *moved = scene_get_body(scene, 6);
+    body_t *target = body_init(make_shape_rectangle(BOX_SIZE, BOX_SIZE, (vector_t) {500, 500}), INFINITY, (rgb_color_t) {0, 0, 0});
+    scene_add_body(scene, target);
+    broad_phase_add_collision(broad_phase, moved, target, count_hit, &moved_hits, NULL);
+    scene_tick(scene, 0.01);
+    assert(moved_hits == 0);
+    body_set_centroid(moved, (vector_t) {500, 500});
+    scene_tick(scene, 0.01);
+    assert(moved_hits == 1);
+    scene_free(scene);
+}
+
+void test_sleep_keeps_velocity() {
+    scene_t *scene = scene_init();
+    broad_phase_t *broad_phase = create_broad_phase(scene, CELL_SIZE);
+    // Slow enough to fall asleep, since it stays within a hundredth of a cell for 30 ticks
+    double speed = CELL_SIZE / 10000;
+    body_t *creeper = body_init(make_shape_circle(BODY_RADIUS, VEC_ZERO, BODY_POINTS), 1, (rgb_color_t) {0, 0, 0});
+    body_set_velocity(creeper, (vector_t) {speed, 0});
+    body_t *wall = body_init(make_shape_rectangle(2, 20, (vector_t) {2 * CELL_SIZE, 0}), INFINITY, (rgb_color_t) {0, 0, 0});
+    scene_add_body(scene, creeper);
+    scene_add_body(scene, wall);
+    size_t hits = 0;
+    broad_phase_add_collision(broad_phase, creeper, wall, count_hit, &hits, NULL);
+
+    size_t ticks = 0;
+    while (hits == 0) {
+        scene_tick(scene, 1);
+        ticks++;
+        assert(body_get_velocity(creeper).x == speed);
+        assert(ticks < 20000);
+    }
+    // It crept the whole way, and hit the wall by the time it drifted a hundredth of a cell in
+    double reach = 2 * CELL_SIZE - 1 - BODY_RADIUS;
+    double x = body_get_centroid(creeper).x;
+    assert(x >= reach && x < reach + CELL_SIZE / 100 + 2 * speed);
+    scene_free(scene);
+}
+
+/** Body i is red if i is a multiple of 3, and blue bodies ending in 5 or 0 ignore red ones */
+uint32_t body_category(size_t i) {
+    return i % 3 == 0 ? RED : BLUE;
+}
+
+uint32_t body_mask(size_t i) {
+    return i % 3 != 0 && i % 5 == 0 ? BLUE : ALL_CATEGORIES;
+}
+
+/** Whether the rules below apply to bodies i and j */
+bool rule_applies(size_t i, size_t j) {
+    if (!(body_mask(i) & body_category(j)) || !(body_mask(j) & body_category(i))) {
+        return false;
+    }
+    return body_category(i) == RED || body_category(j) == RED;
+}
+
+void test_rules_match_brute_force() {
+    static hit_log_t log;
+    static bool colliding[BODY_COUNT][BODY_COUNT];
+    static bool was_colliding[BODY_COUNT][BODY_COUNT];
+    memset(was_colliding, 0, sizeof(was_colliding));
+    bool removed[BODY_COUNT] = {false};
+
+    rng_t rng = rng_init(2);
+    scene_t *scene = scene_init();
+    broad_phase_t *broad_phase = create_broad_phase(scene, CELL_SIZE);
+    for (size_t i = 0; i < BODY_COUNT; i++) {
+        // Rules also apply to bodies categorized after they were added
+        if (i == BODY_COUNT / 2) {
+            broad_phase_add_rule(broad_phase, RED, BLUE, record_red_blue, &log, NULL);
+            broad_phase_add_rule(broad_phase, RED, RED, record_hit, &log, NULL);
+        }
+        vector_t center = {rng_range(&rng, 0, AREA_SIZE), rng_range(&rng, 0, AREA_SIZE)};
+        body_t *body = body_init(make_shape_circle(BODY_RADIUS, center, BODY_POINTS), 1, (rgb_color_t) {0, 0, 0});
+        body_set_velocity(body, (vector_t) {rng_range(&rng, -MAX_SPEED, MAX_SPEED), rng_range(&rng, -MAX_SPEED, MAX_SPEED)});
+        scene_add_body(scene, body);
+        broad_phase_set_category(broad_phase, body, body_category(i), body_mask(i));
+        log.bodies[i] = body;
+    }
+
+    size_t hits = 0;
+    for (size_t tick = 0; tick < TICKS; tick++) {
+        for (size_t i = 0; i < BODY_COUNT; i++) {
+            for (size_t j = i + 1; j < BODY_COUNT; j++) {
+                colliding[i][j] = !removed[i] && !removed[j] && bodies_collide(log.bodies[i], log.bodies[j]);
+            }
+        }
+        memset(log.started, 0, sizeof(log.started));
+        scene_tick(scene, DT);
+
+        for (size_t i = 0; i < BODY_COUNT; i++) {
+            for (size_t j = i + 1; j < BODY_COUNT; j++) {
+                if (removed[i] || removed[j]) {
+                    assert(tick <= TICKS / 2 + 1 || !log.started[i][j]);
+                    continue;
+                }
+                bool started = colliding[i][j] && !was_colliding[i][j];
+                assert(log.started[i][j] == (started && rule_applies(i, j)));
+                hits += log.started[i][j];
+                was_colliding[i][j] = colliding[i][j];
+            }
+        }
+
+        if (tick == TICKS / 2) {
+            for (size_t i = 0; i < BODY_COUNT; i += 4) {
+                body_remove(log.bodies[i]);
+                removed[i] = true;
+            }
+        }
+    }
+    assert(hits > 20);
+    scene_free(scene);
+}
+
+int main(int argc, char *argv[]) {
+    // Run all tests if there are no command-line arguments
+    bool all_tests = argc == 1;
+    char *testname = all_tests ? NULL : argv[1];
+
+    DO_TEST(test_matches_brute_force)
+    DO_TEST(test_rules_match_brute_force)
+    DO_TEST(test_contacts_match_brute_force)
+    DO_TEST(test_resting_bodies_stay_put)
+    DO_TEST(test_sleeping_bodies_still_hit)
+    DO_TEST(test_sleep_keeps_velocity)
+
+    puts("broad_phase_test PASS");
+}
@@ -0,0 +1,126 @@
+#include <assert.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include "fixed_step.h"
+#include "rng.h"
+#include "scene.h"
+#include "shape.h"
+#include "test_suite.h"
+
+static const double EPSILON = 1e-9;
+// A power of two, so steps and the frame times below add up exactly
+static const double HZ = 64.0;
+static const size_t MAX_SUBSTEPS = 8;
+
+bool close_to(double a, double b) {
+    return fabs(a - b) < EPSILON;
+}
+
+body_t *add_moving_body(scene_t *scene, vector_t velocity) {
+    body_t *body = body_init(make_shape_rectangle(2, 2, VEC_ZERO), 1, (rgb_color_t) {0, 0, 0});
+    body_set_velocity(body, velocity);
+    scene_add_body(scene, body);
+    return body;
+}
+
+void test_interpolation_endpoints() {
+    scene_t *scene = scene_init();
+    body_t *body = add_moving_body(scene, (vector_t) {64, 0});
+    fixed_step_t *stepper = fixed_step_init(HZ, MAX_SUBSTEPS);
+
+    // One whole step: the body moves from x = 0 to x = 1, and is drawn where it was
+    assert(fixed_step_advance(stepper, scene, 1 / HZ) == 1);
+    assert(close_to(body_get_centroid(body).x, 1));
+    assert(fixed_step_alpha(stepper) == 0);
+    assert(close_to(fixed_step_interpolate(stepper, scene)[0].centroid.x, 0));
+
+    // Partway into the next step, it is drawn that far between the last two states
+    assert(fixed_step_advance(stepper, scene, 0.25 / HZ) == 0);
+    assert(close_to(fixed_step_alpha(stepper), 0.25));
+    assert(close_to(fixed_step_interpolate(stepper, scene)[0].centroid.x, 0.25));
+    assert(fixed_step_advance(stepper, scene, 0.5 / HZ) == 0);
+    assert(close_to(fixed_step_interpolate(stepper, scene)[0].centroid.x, 0.75));
+
+    // Interpolating never moves the body
+    assert(close_to(body_get_centroid(body).x, 1));
+
+    // Finishing the step starts the blend again from the new last state
+    assert(fixed_step_advance(stepper, scene, 0.25 / HZ) == 1);
+    assert(close_to(body_get_centroid(body).x, 2));
+    assert(close_to(fixed_step_interpolate(stepper, scene)[0].centroid.x, 1));
+
+    fixed_step_free(stepper);
+    scene_free(scene);
+}
+
+void test_new_body_drawn_in_place() {
+    scene_t *scene = scene_init();
+    add_moving_body(scene, (vector_t) {64, 0});
+    fixed_step_t *stepper = fixed_step_init(HZ, MAX_SUBSTEPS);
+    fixed_step_advance(stepper, scene, 1.5 / HZ);
+
+    body_t *added = add_moving_body(scene, (vector_t) {0, 64});
+    body_set_centroid(added, (vector_t) {5, 5});
+    const draw_pose_t *poses = fixed_step_interpolate(stepper, scene);
+    assert(close_to(poses[0].centroid.x, 0.5));
+    assert(close_to(poses[1].centroid.x, 5) && close_to(poses[1].centroid.y, 5));
+    fixed_step_free(stepper);
+    scene_free(scene);
+}
+
+/** Runs two seconds of frames of random length, some longer than a step */
+vector_t run_frames(uint64_t seed) {
+    rng_t rng = rng_init(seed);
+    scene_t *scene = scene_init();
+    body_t *body = add_moving_body(scene, (vector_t) {3, -5});
+    fixed_step_t *stepper = fixed_step_init(HZ, MAX_SUBSTEPS);
+    // Frame times are whole 256ths of a second, so they add up exactly
+    size_t ticks_left = 2 * 256;
+    while (ticks_left > 0) {
+        size_t ticks = 1 + rng_next(&rng) % 10;
+        if (ticks > ticks_left) {
+            ticks = ticks_left;
+        }
+        fixed_step_advance(stepper, scene, ticks / 256.0);
+        ticks_left -= ticks;
+    }
+    vector_t centroid = body_get_centroid(body);
+    fixed_step_free(stepper);
+    scene_free(scene);
+    return centroid;
+}
+
+void test_frame_rate_independent() {
+    vector_t first = run_frames(1);
+    vector_t second = run_frames(2);
+    assert(first.x == second.x && first.y == second.y);
+    assert(close_to(first.x, 6) && close_to(first.y, -10));
+}
+
+void test_max_substeps() {
+    scene_t *scene = scene_init();
+    body_t *body = add_moving_body(scene, (vector_t) {64, 0});
+    fixed_step_t *stepper = fixed_step_init(HZ, MAX_SUBSTEPS);
+    // A second-long frame only runs the most steps allowed, and the rest is dropped
+    assert(fixed_step_advance(stepper, scene, 1) == MAX_SUBSTEPS);
+    assert(close_to(body_get_centroid(body).x, MAX_SUBSTEPS));
+    assert(fixed_step_alpha(stepper) == 0);
+    assert(fixed_step_advance(stepper, scene, 0.5 / HZ) == 0);
+    fixed_step_free(stepper);
+    scene_free(scene);
+}
+
+int main(int argc, char *argv[]) {
+    // Run all tests if there are no command-line arguments
+    bool all_tests = argc == 1;
+    char *testname = all_tests ? NULL : argv[1];
+
+    DO_TEST(test_interpolation_endpoints)
+    DO_TEST(test_new_body_drawn_in_place)
+    DO_TEST(test_frame_rate_independent)
+    DO_TEST(test_max_substeps)
+
+    puts("fixed_step_test PASS");
+}
@@ -0,0 +1,101 @@
+#include <assert.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include "forces.h"
+#include "gravity_field.h"
+#include "rng.h"
+#include "scene.h"
+#include "shape.h"
+#include "test_suite.h"
+
+static const double G = 10000.0;
+static const size_t BODY_COUNT = 200;
+static const size_t TICKS = 50;
+// The body removed partway through
+static const size_t REMOVED_BODY = 3;
+static const size_t REMOVE_TICK = 20;
+static const double DT = 0.001;
+
+/**
+ * Makes a scene of randomly placed stars pulling on each other.
+ * threads == 0 uses one create_newtonian_gravity per pair instead of a field.
+ */
+scene_t *make_scene(size_t threads, double theta) {
+    rng_t rng = rng_init(3);
+    scene_t *scene = scene_init();
+    gravity_field_t *field = NULL;
+    if (threads > 0) {
+        field = create_gravity_field(scene, G, theta);
+        gravity_field_set_threads(field, threads);
+    }
+    for (size_t i = 0; i < BODY_COUNT; i++) {
+        vector_t center = {rng_range(&rng, 0, 1000), rng_range(&rng, 0, 500)};
+        body_t *body = body_init(make_shape_star(center, 4, 6, 3), rng_range(&rng, 1, 5), (rgb_color_t) {0, 0, 0});
+        scene_add_body(scene, body);
+        if (field != NULL) {
+            gravity_field_add_body(field, body);
+        }
+        else {
+            for (size_t j = 0; j < i; j++) {
+                create_newtonian_gravity(scene, G, scene_get_body(scene, j), body);
+            }
+        }
+    }
+    return scene;
+}
+
+void run(scene_t *scene) {
+    for (size_t tick = 0; tick < TICKS; tick++) {
+        if (tick == REMOVE_TICK) {
+            body_remove(scene_get_body(scene, REMOVED_BODY));
+        }
+        scene_tick(scene, DT);
+    }
+}
+
+void test_exact_matches_pairs() {
+    scene_t *pairs = make_scene(0, 0);
+    scene_t *field = make_scene(1, 0);
+    run(pairs);
+    run(field);
+    assert(scene_bodies(field) == BODY_COUNT - 1);
+    assert(scene_bodies(pairs) == scene_bodies(field));
+    for (size_t i = 0; i < scene_bodies(pairs); i++) {
+        vector_t expected = body_get_centroid(scene_get_body(pairs, i));
+        vector_t actual = body_get_centroid(scene_get_body(field, i));
+        // Forces are summed in a different order, so only close
+        assert(fabs(expected.x - actual.x) < 1e-6 && fabs(expected.y - actual.y) < 1e-6);
+    }
+    scene_free(pairs);
+    scene_free(field);
+}
+
+void test_threads_identical() {
+    scene_t *serial = make_scene(1, 0.5);
+    run(serial);
+    for (size_t threads = 2; threads <= 8; threads *= 2) {
+        scene_t *parallel = make_scene(threads, 0.5);
+        run(parallel);
+        assert(scene_bodies(parallel) == scene_bodies(serial));
+        for (size_t i = 0; i < scene_bodies(serial); i++) {
+            vector_t expected = body_get_centroid(scene_get_body(serial, i));
+            vector_t actual = body_get_centroid(scene_get_body(parallel, i));
+            assert(expected.x == actual.x && expected.y == actual.y);
+        }
+        scene_free(parallel);
+    }
+    scene_free(serial);
+}
+
+int main(int argc, char *argv[]) {
+    // Run all tests if there are no command-line arguments
+    bool all_tests = argc == 1;
+    char *testname = all_tests ? NULL : argv[1];
+
+    DO_TEST(test_exact_matches_pairs)
+    DO_TEST(test_threads_identical)
+
+    puts("gravity_field_test PASS");
+}
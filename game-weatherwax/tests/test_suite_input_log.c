@@ -0,0 +1,164 @@
+#include <assert.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "input_log.h"
+#include "scene.h"
+#include "shape.h"
+#include "test_suite.h"
+
+static const char *LOG_PATH = "out/test_input_log.bin";
+static const char *TRUNCATED_PATH = "out/test_input_log_truncated.bin";
+static const uint64_t SEED = 0xdeadbeefcafe1234;
+// Sizes the replay records, so it must be a constant expression
+#define MAX_EVENTS 16
+
+/** What a replay handed the game, in order */
+typedef struct replay_log {
+    char keys[MAX_EVENTS];
+    key_event_type_t types[MAX_EVENTS];
+    double held_times[MAX_EVENTS];
+    size_t key_count;
+    double dts[MAX_EVENTS];
+    size_t tick_count;
+    // Whether the scene ended as recorded, if a scene was given
+    bool matched;
+} replay_log_t;
+
+// Key handlers get no aux, so the replay being recorded is global
+static replay_log_t *replaying;
+
+void record_key(scene_t *scene, char key, key_event_type_t type, double held_time) {
+    assert(replaying->key_count < MAX_EVENTS);
+    replaying->keys[replaying->key_count] = key;
+    replaying->types[replaying->key_count] = type;
+    replaying->held_times[replaying->key_count] = held_time;
+    replaying->key_count++;
+}
+
+/** Replays a whole log, as a game loop would, and checks the scene at the end if given one */
+replay_log_t replay(const char *path, scene_t *scene) {
+    replay_log_t result = {0};
+    replaying = &result;
+    input_log_t *log = input_log_replay(path);
+    assert(log != NULL);
+    assert(input_log_is_replay(log));
+    assert(input_log_seed(log) == SEED);
+    while (input_log_replay_keys(log, scene, record_key)) {
+        assert(result.tick_count < MAX_EVENTS);
+        result.dts[result.tick_count++] = input_log_replay_tick(log);
+    }
+    if (scene != NULL) {
+        result.matched = input_log_end(log, scene);
+    }
+    input_log_free(log);
+    return result;
+}
+
+/** Records a short session: keys, frames of odd lengths, and a key after the last frame */
+void record_session(scene_t *scene) {
+    input_log_t *log = input_log_record(LOG_PATH, SEED);
+    assert(log != NULL);
+    assert(!input_log_is_replay(log));
+    input_log_key(log, 'a', KEY_PRESSED, 0.0);
+    input_log_tick(log, 1.0 / 60);
+    input_log_tick(log, 0.0171);
+    input_log_key(log, 'a', KEY_RELEASED, 0.25);
+    input_log_key(log, ' ', KEY_PRESSED, 0.1);
+    input_log_tick(log, 0.33);
+    input_log_key(log, 'x', KEY_PRESSED, 0.0);
+    if (scene != NULL) {
+        assert(input_log_end(log, scene));
+    }
+    input_log_free(log);
+}
+
+void test_round_trip() {
+    record_session(NULL);
+    replay_log_t result = replay(LOG_PATH, NULL);
+    // The key after the last frame is handed over, but there is no frame left to tick
+    assert(result.tick_count == 3);
+    assert(result.dts[0] == 1.0 / 60 && result.dts[1] == 0.0171 && result.dts[2] == 0.33);
+    assert(result.key_count == 4);
+    assert(result.keys[0] == 'a' && result.types[0] == KEY_PRESSED);
+    assert(result.keys[1] == 'a' && result.types[1] == KEY_RELEASED && result.held_times[1] == 0.25);
+    assert(result.keys[2] == ' ' && result.types[2] == KEY_PRESSED && result.held_times[2] == 0.1);
+    assert(result.keys[3] == 'x');
+    remove(LOG_PATH);
+}
+
+void test_final_state() {
+    scene_t *scene = scene_init();
+    body_t *body = body_init(make_shape_rectangle(2, 2, (vector_t) {1, 2}), 1, (rgb_color_t) {0, 0, 0});
+    body_set_velocity(body, (vector_t) {3, 4});
+    scene_add_body(scene, body);
+    record_session(scene);
+
+    assert(replay(LOG_PATH, scene).matched);
+
+    // Any change to a body, however small, is caught
+    body_set_velocity(body, (vector_t) {3, 4.000000001});
+    assert(!replay(LOG_PATH, scene).matched);
+    scene_free(scene);
+    remove(LOG_PATH);
+}
+
+void test_truncated() {
+    record_session(NULL);
+    replay_log_t full = replay(LOG_PATH, NULL);
+    FILE *file = fopen(LOG_PATH, "rb");
+    assert(file != NULL);
+    char data[256];
+    size_t size = fread(data, 1, sizeof(data), file);
+    fclose(file);
+
+    // Cutting the file off anywhere replays a prefix of the session, or refuses the file
+    bool opened_any = false;
+    for (size_t length = 0; length < size; length++) {
+        file = fopen(TRUNCATED_PATH, "wb");
+        fwrite(data, 1, length, file);
+        fclose(file);
+        input_log_t *log = input_log_replay(TRUNCATED_PATH);
+        if (log == NULL) {
+            assert(!opened_any);
+            continue;
+        }
+        input_log_free(log);
+        opened_any = true;
+
+        replay_log_t result = replay(TRUNCATED_PATH, NULL);
+        assert(result.tick_count <= full.tick_count && result.key_count <= full.key_count);
+        for (size_t i = 0; i < result.tick_count; i++) {
+            assert(result.dts[i] == full.dts[i]);
+        }
+        for (size_t i = 0; i < result.key_count; i++) {
+            assert(result.keys[i] == full.keys[i] && result.types[i] == full.types[i]);
+        }
+    }
+    assert(opened_any);
+    remove(TRUNCATED_PATH);
+    remove(LOG_PATH);
+}
+
+void test_not_a_log() {
+    FILE *file = fopen(LOG_PATH, "wb");
+    fputs("#include <stdio.h>\n", file);
+    fclose(file);
+    assert(input_log_replay(LOG_PATH) == NULL);
+    remove(LOG_PATH);
+    assert(input_log_replay(LOG_PATH) == NULL);
+}
+
+int main(int argc, char *argv[]) {
+    // Run all tests if there are no command-line arguments
+    bool all_tests = argc == 1;
+    char *testname = all_tests ? NULL : argv[1];
+
+    DO_TEST(test_round_trip)
+    DO_TEST(test_final_state)
+    DO_TEST(test_truncated)
+    DO_TEST(test_not_a_log)
+
+    puts("input_log_test PASS");
+}
@@ -0,0 +1,103 @@
+#include <assert.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include "level_stream.h"
+#include "scene.h"
+#include "shape.h"
+#include "test_suite.h"
+
+static const double CHUNK_HEIGHT = 1000.0;
+static const double VIEW_HEIGHT = 1000.0;
+// Sizes the spawn records, so it must be a constant expression
+#define MAX_SPAWNS 4000
+
+/** Every spawn a stream made bodies for, in order */
+typedef struct spawn_record {
+    spawn_t spawns[MAX_SPAWNS];
+    size_t count;
+} spawn_record_t;
+
+double generate_chunk(level_chunk_t *chunk, double bottom, void *aux) {
+    double y = bottom;
+    while (y < bottom + CHUNK_HEIGHT) {
+        y += level_chunk_rand(chunk, 10, 290);
+        spawn_t spawn = {0, {level_chunk_rand(chunk, 0, 500), y}, VEC_ZERO};
+        level_chunk_add(chunk, spawn);
+    }
+    return y;
+}
+
+body_t *spawn_body(scene_t *scene, spawn_t spawn, void *aux) {
+    spawn_record_t *record = aux;
+    assert(record->count < MAX_SPAWNS);
+    record->spawns[record->count++] = spawn;
+    body_t *body = body_init(make_shape_circle(5, spawn.position, 8), INFINITY, (rgb_color_t) {0, 0, 0});
+    scene_add_body(scene, body);
+    return body;
+}
+
+/** Climbs through a level, checking that only chunks near the view have bodies */
+void climb(uint64_t seed, spawn_record_t *record) {
+    record->count = 0;
+    scene_t *scene = scene_init();
+    level_stream_t *stream = create_level_stream(scene, 0, seed, generate_chunk, NULL, spawn_body, record);
+    for (size_t frame = 0; frame < 2000; frame++) {
+        double bottom = frame * 5.0;
+        level_stream_update(stream, bottom, bottom + VIEW_HEIGHT);
+        scene_tick(scene, 0.01);
+        assert(level_stream_top(stream) >= bottom + VIEW_HEIGHT);
+        assert(record->spawns[record->count - 1].position.y <= level_stream_top(stream));
+
+        // Part of a chunk can hang below the view, but no whole chunk
+        for (size_t i = 0; i < scene_bodies(scene); i++) {
+            vector_t position = body_get_centroid(scene_get_body(scene, i));
+            assert(position.y > bottom - 2 * CHUNK_HEIGHT);
+        }
+    }
+    scene_free(scene);
+}
+
+void test_same_seed_same_level() {
+    static spawn_record_t record1, record2;
+    climb(42, &record1);
+    climb(42, &record2);
+    assert(record1.count > 0);
+    assert(record1.count == record2.count);
+    for (size_t i = 0; i < record1.count; i++) {
+        assert(record1.spawns[i].position.x == record2.spawns[i].position.x);
+        assert(record1.spawns[i].position.y == record2.spawns[i].position.y);
+    }
+}
+
+void test_spawns_climb() {
+    static spawn_record_t record;
+    climb(7, &record);
+    for (size_t i = 1; i < record.count; i++) {
+        assert(record.spawns[i].position.y > record.spawns[i - 1].position.y);
+    }
+}
+
+void test_different_seed_different_level() {
+    static spawn_record_t record1, record2;
+    climb(1, &record1);
+    climb(2, &record2);
+    bool differs = record1.count != record2.count;
+    for (size_t i = 0; i < record1.count && !differs; i++) {
+        differs = record1.spawns[i].position.x != record2.spawns[i].position.x;
+    }
+    assert(differs);
+}
+
+int main(int argc, char *argv[]) {
+    // Run all tests if there are no command-line arguments
+    bool all_tests = argc == 1;
+    char *testname = all_tests ? NULL : argv[1];
+
+    DO_TEST(test_same_seed_same_level)
+    DO_TEST(test_spawns_climb)
+    DO_TEST(test_different_seed_different_level)
+
+    puts("level_stream_test PASS");
+}
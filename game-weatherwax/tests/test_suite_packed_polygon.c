@@ -0,0 +1,180 @@
+#include <assert.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include "packed_polygon.h"
+#include "polygon.h"
+#include "rng.h"
+#include "test_suite.h"
+
+static const double EPSILON = 1e-9;
+// Steps of the brute-force sweep the swept test is checked against
+static const size_t SWEEP_STEPS = 2000;
+
+bool close_to(double a, double b) {
+    return fabs(a - b) < EPSILON;
+}
+
+/** Makes a counterclockwise rectangle */
+packed_polygon_t *make_rectangle(vector_t center, double width, double height) {
+    packed_polygon_t *rectangle = packed_polygon_init(4);
+    packed_polygon_add(rectangle, (vector_t) {center.x - width / 2, center.y - height / 2});
+    packed_polygon_add(rectangle, (vector_t) {center.x + width / 2, center.y - height / 2});
+    packed_polygon_add(rectangle, (vector_t) {center.x + width / 2, center.y + height / 2});
+    packed_polygon_add(rectangle, (vector_t) {center.x - width / 2, center.y + height / 2});
+    return rectangle;
+}
+
+void test_matches_list_polygon() {
+    packed_polygon_t *packed = packed_polygon_init(1);
+    for (size_t i = 0; i < 7; i++) {
+        double angle = 2 * M_PI * i / 7;
+        double radius = i % 2 == 0 ? 5 : 3;
+        packed_polygon_add(packed, (vector_t) {3 + radius * cos(angle), -2 + radius * sin(angle)});
+    }
+    list_t *list = packed_polygon_to_list(packed);
+    assert(close_to(packed_polygon_area(packed), polygon_area(list)));
+    vector_t centroid = packed_polygon_centroid(packed);
+    vector_t list_centroid = polygon_centroid(list);
+    assert(close_to(centroid.x, list_centroid.x) && close_to(centroid.y, list_centroid.y));
+
+    packed_polygon_rotate(packed, 0.7, (vector_t) {1, 1});
+    packed_polygon_translate(packed, (vector_t) {5, -2});
+    polygon_rotate(list, 0.7, (vector_t) {1, 1});
+    polygon_translate(list, (vector_t) {5, -2});
+    packed_polygon_t *from_list = packed_polygon_from_list(list);
+    assert(from_list->size == packed->size);
+    for (size_t i = 0; i < packed->size; i++) {
+        assert(close_to(from_list->x[i], packed->x[i]));
+        assert(close_to(from_list->y[i], packed->y[i]));
+    }
+    packed_polygon_free(from_list);
+    packed_polygon_free(packed);
+    list_free(list);
+}
+
+void test_collision_axis() {
+    packed_polygon_t *a = make_rectangle((vector_t) {0, 0}, 10, 10);
+    // Overlaps by 1 along x and 7 along y, so x is the axis to push apart on
+    packed_polygon_t *b = make_rectangle((vector_t) {9, 3}, 10, 10);
+    collision_info_t info = packed_find_collision(a, b);
+    assert(info.collided);
+    assert(close_to(fabs(info.axis.x), 1) && close_to(info.axis.y, 0));
+    assert(packed_polygon_overlap(b, a));
+    packed_polygon_free(a);
+    packed_polygon_free(b);
+}
+
+void test_separated_and_touching() {
+    packed_polygon_t *a = make_rectangle((vector_t) {0, 0}, 10, 10);
+    packed_polygon_t *apart = make_rectangle((vector_t) {20, 0}, 10, 10);
+    packed_polygon_t *touching = make_rectangle((vector_t) {10, 0}, 10, 10);
+    assert(!packed_find_collision(a, apart).collided);
+    assert(!packed_polygon_overlap(a, touching));
+    packed_polygon_free(a);
+    packed_polygon_free(apart);
+    packed_polygon_free(touching);
+}
+
+void test_matches_list_collision() {
+    rng_t rng = rng_init(3);
+    for (size_t i = 0; i < 2000; i++) {
+        vector_t center1 = {rng_range(&rng, -20, 20), rng_range(&rng, -20, 20)};
+        vector_t center2 = {rng_range(&rng, -20, 20), rng_range(&rng, -20, 20)};
+        packed_polygon_t *a = make_rectangle(center1, rng_range(&rng, 1, 20), rng_range(&rng, 1, 20));
+        packed_polygon_t *b = make_rectangle(center2, rng_range(&rng, 1, 20), rng_range(&rng, 1, 20));
+        packed_polygon_rotate(a, rng_range(&rng, 0, M_PI), center1);
+        list_t *list_a = packed_polygon_to_list(a);
+        list_t *list_b = packed_polygon_to_list(b);
+        collision_info_t packed = packed_find_collision(a, b);
+        collision_info_t listed = find_collision(list_a, list_b);
+        assert(packed.collided == listed.collided);
+        list_free(list_a);
+        list_free(list_b);
+        packed_polygon_free(a);
+        packed_polygon_free(b);
+    }
+}
+
+void test_swept_tunneling() {
+    // A small fast box that passes all the way through a thin wall in one step
+    packed_polygon_t *box = make_rectangle((vector_t) {0, 60}, 4, 4);
+    packed_polygon_t *wall = make_rectangle((vector_t) {0, 0}, 40, 2);
+    vector_t motion = {0, 100};
+    assert(!packed_polygon_overlap(box, wall));
+    swept_collision_info_t info = packed_find_swept_collision(box, motion, wall, VEC_ZERO);
+    assert(info.collided);
+    // It starts at y = -40, so its top reaches the wall's bottom at y = -1 after 37 units
+    assert(close_to(info.time, 0.37));
+    assert(close_to(info.axis.x, 0) && close_to(fabs(info.axis.y), 1));
+
+    // Moving the wall with the box is the same as not moving either
+    assert(!packed_find_swept_collision(box, motion, wall, motion).collided);
+    packed_polygon_free(box);
+    packed_polygon_free(wall);
+}
+
+/** Copies a polygon, moved back along its motion to where it was at time t */
+void rewind_to(packed_polygon_t *rewound, const packed_polygon_t *polygon, vector_t motion, double t) {
+    rewound->size = 0;
+    for (size_t i = 0; i < polygon->size; i++) {
+        packed_polygon_add(rewound, (vector_t) {
+            polygon->x[i] - (1 - t) * motion.x,
+            polygon->y[i] - (1 - t) * motion.y
+        });
+    }
+}
+
+void test_swept_matches_brute_force() {
+    rng_t rng = rng_init(5);
+    packed_polygon_t *rewound1 = packed_polygon_init(4);
+    packed_polygon_t *rewound2 = packed_polygon_init(4);
+    size_t hits = 0;
+    for (size_t i = 0; i < 500; i++) {
+        vector_t center1 = {rng_range(&rng, -100, 100), rng_range(&rng, -100, 100)};
+        vector_t center2 = {rng_range(&rng, -20, 20), rng_range(&rng, -20, 20)};
+        vector_t motion1 = {rng_range(&rng, -150, 150), rng_range(&rng, -150, 150)};
+        vector_t motion2 = {rng_range(&rng, -20, 20), rng_range(&rng, -20, 20)};
+        packed_polygon_t *a = make_rectangle(center1, rng_range(&rng, 4, 14), rng_range(&rng, 4, 14));
+        packed_polygon_t *b = make_rectangle(center2, rng_range(&rng, 5, 35), rng_range(&rng, 3, 9));
+
+        double first = -1;
+        for (size_t step = 0; step <= SWEEP_STEPS; step++) {
+            double t = (double) step / SWEEP_STEPS;
+            rewind_to(rewound1, a, motion1, t);
+            rewind_to(rewound2, b, motion2, t);
+            if (packed_polygon_overlap(rewound1, rewound2)) {
+                first = t;
+                break;
+            }
+        }
+        swept_collision_info_t info = packed_find_swept_collision(a, motion1, b, motion2);
+        // A contact shorter than one step can slip between the brute-force samples
+        if (first >= 0) {
+            assert(info.collided);
+            assert(info.time <= first && first - info.time < 1.0 / SWEEP_STEPS + EPSILON);
+            hits++;
+        }
+        packed_polygon_free(a);
+        packed_polygon_free(b);
+    }
+    assert(hits > 10);
+    packed_polygon_free(rewound1);
+    packed_polygon_free(rewound2);
+}
+
+int main(int argc, char *argv[]) {
+    // Run all tests if there are no command-line arguments
+    bool all_tests = argc == 1;
+    char *testname = all_tests ? NULL : argv[1];
+
+    DO_TEST(test_matches_list_polygon)
+    DO_TEST(test_collision_axis)
+    DO_TEST(test_separated_and_touching)
+    DO_TEST(test_matches_list_collision)
+    DO_TEST(test_swept_tunneling)
+    DO_TEST(test_swept_matches_brute_force)
+
+    puts("packed_polygon_test PASS");
+}
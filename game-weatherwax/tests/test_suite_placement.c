@@ -0,0 +1,87 @@
+#include <assert.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include "placement.h"
+#include "rng.h"
+#include "test_suite.h"
+
+static const size_t MAX_PLACED = 2000;
+
+/** Whether two rectangles overlap by more than a shared edge */
+bool rectangles_overlap(vector_t center1, vector_t size1, vector_t center2, vector_t size2) {
+    return fabs(center1.x - center2.x) < (size1.x + size2.x) / 2
+        && fabs(center1.y - center2.y) < (size1.y + size2.y) / 2;
+}
+
+void test_empty_fits() {
+    placement_t *placement = placement_init(10);
+    assert(placement_fits(placement, (vector_t) {0, 0}, (vector_t) {5, 5}));
+    assert(placement_fits(placement, (vector_t) {-1e6, 1e6}, (vector_t) {100, 100}));
+    placement_free(placement);
+}
+
+void test_touching_edges_fit() {
+    placement_t *placement = placement_init(10);
+    vector_t size = {10, 4};
+    placement_add(placement, (vector_t) {0, 0}, size);
+    assert(!placement_fits(placement, (vector_t) {0, 0}, size));
+    assert(!placement_fits(placement, (vector_t) {9.9, 3.9}, size));
+    assert(placement_fits(placement, (vector_t) {10, 0}, size));
+    assert(placement_fits(placement, (vector_t) {0, -4}, size));
+    // Much bigger than a cell, and covering the first rectangle
+    assert(!placement_fits(placement, (vector_t) {40, 0}, (vector_t) {100, 1}));
+    placement_free(placement);
+}
+
+void test_clear() {
+    placement_t *placement = placement_init(10);
+    vector_t size = {10, 10};
+    placement_add(placement, (vector_t) {5, 5}, size);
+    assert(!placement_fits(placement, (vector_t) {5, 5}, size));
+    placement_clear(placement);
+    assert(placement_fits(placement, (vector_t) {5, 5}, size));
+    placement_free(placement);
+}
+
+void test_matches_brute_force() {
+    rng_t rng = rng_init(1);
+    vector_t placed[MAX_PLACED];
+    vector_t sizes[MAX_PLACED];
+    size_t count = 0;
+    placement_t *placement = placement_init(80);
+    for (size_t i = 0; i < 20000 && count < MAX_PLACED; i++) {
+        vector_t center = {rng_range(&rng, -100, 500), rng_range(&rng, -100, 3000)};
+        vector_t size = {rng_range(&rng, 5, 200), rng_range(&rng, 5, 40)};
+        bool fits = true;
+        for (size_t j = 0; j < count; j++) {
+            if (rectangles_overlap(center, size, placed[j], sizes[j])) {
+                fits = false;
+                break;
+            }
+        }
+        assert(placement_fits(placement, center, size) == fits);
+        if (fits) {
+            placement_add(placement, center, size);
+            placed[count] = center;
+            sizes[count] = size;
+            count++;
+        }
+    }
+    assert(count > 100);
+    placement_free(placement);
+}
+
+int main(int argc, char *argv[]) {
+    // Run all tests if there are no command-line arguments
+    bool all_tests = argc == 1;
+    char *testname = all_tests ? NULL : argv[1];
+
+    DO_TEST(test_empty_fits)
+    DO_TEST(test_touching_edges_fit)
+    DO_TEST(test_clear)
+    DO_TEST(test_matches_brute_force)
+
+    puts("placement_test PASS");
+}
@@ -0,0 +1,84 @@
+#include <assert.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include "rng.h"
+#include "test_suite.h"
+
+static const size_t FILL_COUNT = 1000;
+
+void test_reference_outputs() {
+    // The first outputs of the reference xoshiro256** from this state
+    rng_t rng = {{1, 2, 3, 4}};
+    assert(rng_next(&rng) == 11520ULL);
+    assert(rng_next(&rng) == 0ULL);
+    assert(rng_next(&rng) == 1509978240ULL);
+    assert(rng_next(&rng) == 1215971899390074240ULL);
+}
+
+void test_same_seed_same_numbers() {
+    rng_t rng1 = rng_init(42);
+    rng_t rng2 = rng_init(42);
+    rng_t rng3 = rng_init(43);
+    bool differs = false;
+    for (size_t i = 0; i < 100; i++) {
+        uint64_t value = rng_next(&rng1);
+        assert(value == rng_next(&rng2));
+        differs = differs || value != rng_next(&rng3);
+    }
+    assert(differs);
+
+    // A copy replays the generator
+    rng_t copy = rng1;
+    assert(rng_next(&copy) == rng_next(&rng1));
+}
+
+void test_range() {
+    rng_t rng = rng_init(7);
+    for (size_t i = 0; i < 10000; i++) {
+        double unit = rng_double(&rng);
+        assert(unit >= 0 && unit < 1);
+        double value = rng_range(&rng, -3, 5);
+        assert(value >= -3 && value < 5);
+    }
+}
+
+void test_fill_matches_range() {
+    rng_t rng1 = rng_init(7);
+    rng_t rng2 = rng_init(7);
+    double values[FILL_COUNT];
+    rng_fill_uniform(&rng1, values, FILL_COUNT, -3, 5);
+    for (size_t i = 0; i < FILL_COUNT; i++) {
+        assert(values[i] == rng_range(&rng2, -3, 5));
+    }
+    // Both generators end up in the same place
+    assert(rng_next(&rng1) == rng_next(&rng2));
+}
+
+void test_split() {
+    rng_t parent = rng_init(9);
+    rng_t unsplit = rng_init(9);
+    rng_t child = rng_split(&parent);
+    // The child continues where the parent was
+    assert(rng_next(&child) == rng_next(&unsplit));
+
+    // and the parent continues from one jump ahead
+    rng_t jumped = rng_init(9);
+    rng_jump(&jumped);
+    assert(rng_next(&parent) == rng_next(&jumped));
+    assert(rng_next(&parent) != rng_next(&child));
+}
+
+int main(int argc, char *argv[]) {
+    // Run all tests if there are no command-line arguments
+    bool all_tests = argc == 1;
+    char *testname = all_tests ? NULL : argv[1];
+
+    DO_TEST(test_reference_outputs)
+    DO_TEST(test_same_seed_same_numbers)
+    DO_TEST(test_range)
+    DO_TEST(test_fill_matches_range)
+    DO_TEST(test_split)
+
+    puts("rng_test PASS");
+}
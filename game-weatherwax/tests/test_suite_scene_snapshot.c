@@ -0,0 +1,164 @@
+#include <assert.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include "scene.h"
+#include "scene_snapshot.h"
+#include "shape.h"
+#include "test_suite.h"
+
+// Sizes the body arrays, so it must be a constant expression
+#define BODY_COUNT 100
+static const uint32_t BOX_KIND = 7;
+// Bodies of this kind are not respawned
+static const uint32_t DUST_KIND = 8;
+static const rgb_color_t RED = {1, 0, 0};
+
+/** Counts the bodies a respawner makes */
+typedef struct respawn_log {
+    size_t respawned;
+    size_t skipped;
+} respawn_log_t;
+
+body_t *respawn_box(scene_t *scene, const body_state_t *state, void *aux) {
+    respawn_log_t *log = aux;
+    if (state->kind == DUST_KIND) {
+        log->skipped++;
+        return NULL;
+    }
+    assert(state->kind == BOX_KIND);
+    log->respawned++;
+    body_t *body = body_init(make_shape_rectangle(10, 10, VEC_ZERO), 1, state->color);
+    scene_add_body(scene, body);
+    return body;
+}
+
+/** Adds boxes in a row, moving at different speeds, with the last of every ten hidden */
+void add_boxes(scene_t *scene, scene_snapshot_t *snapshot, body_t *boxes[]) {
+    for (size_t i = 0; i < BODY_COUNT; i++) {
+        boxes[i] = body_init_with_info(make_shape_rectangle(10, 10, (vector_t) {i, 0}), 1, RED, (body_type_t) (i % 3));
+        body_set_velocity(boxes[i], (vector_t) {0, i});
+        body_set_rotation(boxes[i], i / 100.0);
+        if (i % 10 == 9) {
+            body_hide(boxes[i]);
+        }
+        scene_add_body(scene, boxes[i]);
+        scene_snapshot_add(snapshot, boxes[i], BOX_KIND);
+    }
+}
+
+void check_restored(body_t *body, size_t i) {
+    assert(body_get_centroid(body).x == i && body_get_centroid(body).y == 0);
+    assert(body_get_velocity(body).x == 0 && body_get_velocity(body).y == i);
+    assert(body_get_rotation(body) == i / 100.0);
+    assert(body_get_type(body) == (body_type_t) (i % 3));
+    assert(body_visible(body) == (i % 10 != 9));
+}
+
+void test_restore() {
+    respawn_log_t log = {0};
+    scene_t *scene = scene_init();
+    scene_snapshot_t *snapshot = create_scene_snapshot(scene, respawn_box, &log);
+    body_t *boxes[BODY_COUNT];
+    add_boxes(scene, snapshot, boxes);
+    // Bodies that are not in the snapshot are left alone
+    body_t *outsider = body_init(make_shape_rectangle(10, 10, VEC_ZERO), 1, RED);
+    scene_add_body(scene, outsider);
+
+    for (size_t tick = 0; tick < 10; tick++) {
+        scene_tick(scene, 0.1);
+    }
+    for (size_t i = 0; i < BODY_COUNT; i++) {
+        body_set_rotation(boxes[i], 1);
+        body_set_type(boxes[i], (body_type_t) 2);
+        body_show(boxes[i]);
+    }
+    for (size_t i = 0; i < BODY_COUNT; i += 10) {
+        body_remove(boxes[i]);
+    }
+    body_set_velocity(outsider, (vector_t) {5, 5});
+    scene_tick(scene, 0.1);
+
+    scene_snapshot_restore(snapshot);
+    for (size_t i = 0; i < BODY_COUNT; i++) {
+        if (i % 10 != 0) {
+            check_restored(boxes[i], i);
+        }
+    }
+    assert(log.respawned == BODY_COUNT / 10);
+    assert(scene_bodies(scene) == BODY_COUNT + 1);
+    assert(body_get_velocity(outsider).x == 5);
+
+    // Respawned bodies are in the snapshot again, so restoring twice respawns nothing
+    scene_snapshot_restore(snapshot);
+    assert(log.respawned == BODY_COUNT / 10);
+    scene_free(scene);
+}
+
+void test_plain_data() {
+    assert(sizeof(body_state_t) == 64);
+    scene_t *scenes[2];
+    const body_state_t *states[2];
+    size_t counts[2];
+    body_t *boxes[BODY_COUNT];
+    for (size_t i = 0; i < 2; i++) {
+        scenes[i] = scene_init();
+        scene_snapshot_t *snapshot = create_scene_snapshot(scenes[i], respawn_box, NULL);
+        add_boxes(scenes[i], snapshot, boxes);
+        states[i] = scene_snapshot_states(snapshot, &counts[i]);
+    }
+    // Equal bodies save equal bytes, unused ones included
+    assert(counts[0] == BODY_COUNT && counts[1] == BODY_COUNT);
+    assert(memcmp(states[0], states[1], BODY_COUNT * sizeof(body_state_t)) == 0);
+    assert(states[0][9].visible == 0 && states[0][10].visible == 1);
+    assert(states[0][5].kind == BOX_KIND && states[0][5].type == 2);
+    scene_free(scenes[0]);
+    scene_free(scenes[1]);
+}
+
+void test_load() {
+    respawn_log_t log = {0};
+    scene_t *scene = scene_init();
+    scene_snapshot_t *snapshot = create_scene_snapshot(scene, respawn_box, &log);
+    body_t *boxes[BODY_COUNT];
+    add_boxes(scene, snapshot, boxes);
+    size_t count;
+    const body_state_t *states = scene_snapshot_states(snapshot, &count);
+    body_state_t copy[BODY_COUNT + 1];
+    memcpy(copy, states, count * sizeof(body_state_t));
+    copy[count] = copy[0];
+    copy[count].kind = DUST_KIND;
+
+    // Loading states into an empty snapshot respawns all of them
+    respawn_log_t other_log = {0};
+    scene_t *other = scene_init();
+    scene_snapshot_t *loaded = create_scene_snapshot(other, respawn_box, &other_log);
+    scene_snapshot_load(loaded, copy, count + 1);
+    scene_snapshot_restore(loaded);
+    assert(other_log.respawned == BODY_COUNT && other_log.skipped == 1);
+    assert(scene_bodies(other) == BODY_COUNT);
+    for (size_t i = 0; i < BODY_COUNT; i++) {
+        check_restored(scene_get_body(other, i), i);
+    }
+
+    // Taking a snapshot drops the bodies removed since
+    body_remove(scene_get_body(other, 5));
+    scene_tick(other, 0.01);
+    scene_snapshot_take(loaded);
+    scene_snapshot_states(loaded, &count);
+    assert(count == BODY_COUNT - 1);
+    scene_free(other);
+    scene_free(scene);
+}
+
+int main(int argc, char *argv[]) {
+    // Run all tests if there are no command-line arguments
+    bool all_tests = argc == 1;
+    char *testname = all_tests ? NULL : argv[1];
+
+    DO_TEST(test_restore)
+    DO_TEST(test_plain_data)
+    DO_TEST(test_load)
+
+    puts("scene_snapshot_test PASS");
+}
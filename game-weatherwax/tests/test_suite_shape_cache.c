@@ -0,0 +1,128 @@
+#include <assert.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include "rng.h"
+#include "scene.h"
+#include "shape.h"
+#include "shape_cache.h"
+#include "test_suite.h"
+
+static const double EPSILON = 1e-9;
+static const size_t BODY_COUNT = 50;
+
+bool close_to(double a, double b) {
+    return fabs(a - b) < EPSILON;
+}
+
+body_t *add_rectangle(scene_t *scene, vector_t center, double width, double height, double mass) {
+    body_t *body = body_init(make_shape_rectangle(width, height, center), mass, (rgb_color_t) {0, 0, 0});
+    scene_add_body(scene, body);
+    return body;
+}
+
+/** Checks a cached view against a fresh copy of the body's shape */
+void check_view(shape_cache_t *cache, body_t *body) {
+    shape_view_t view = shape_cache_view(cache, body);
+    list_t *shape = body_get_shape(body);
+    assert(view.polygon->size == list_size(shape));
+    for (size_t i = 0; i < view.polygon->size; i++) {
+        vector_t *vertex = list_get(shape, i);
+        assert(close_to(view.polygon->x[i], vertex->x));
+        assert(close_to(view.polygon->y[i], vertex->y));
+        assert(vertex->x >= view.bounds.min.x - EPSILON && vertex->x <= view.bounds.max.x + EPSILON);
+        assert(vertex->y >= view.bounds.min.y - EPSILON && vertex->y <= view.bounds.max.y + EPSILON);
+    }
+    list_free(shape);
+}
+
+void test_follows_moving_bodies() {
+    rng_t rng = rng_init(4);
+    scene_t *scene = scene_init();
+    shape_cache_t *cache = create_shape_cache(scene);
+    for (size_t i = 0; i < BODY_COUNT; i++) {
+        vector_t center = {rng_range(&rng, -50, 50), rng_range(&rng, -50, 50)};
+        add_rectangle(scene, center, rng_range(&rng, 1, 20), rng_range(&rng, 1, 20), 1);
+    }
+    for (size_t tick = 0; tick < 50; tick++) {
+        for (size_t i = 0; i < scene_bodies(scene); i++) {
+            body_t *body = scene_get_body(scene, i);
+            // Leave some bodies still, so their cached vertices are reused
+            if (i % 4 != 0) {
+                body_set_rotation(body, rng_range(&rng, 0, 2 * M_PI));
+                body_set_centroid(body, (vector_t) {rng_range(&rng, -50, 50), rng_range(&rng, -50, 50)});
+            }
+        }
+        // Half the ticks bring every body up to date at once first
+        if (tick % 2 == 0) {
+            shape_cache_refresh(cache);
+        }
+        for (size_t i = 0; i < scene_bodies(scene); i++) {
+            check_view(cache, scene_get_body(scene, i));
+        }
+    }
+    scene_free(scene);
+}
+
+void test_area_and_moment() {
+    scene_t *scene = scene_init();
+    shape_cache_t *cache = create_shape_cache(scene);
+    body_t *body = add_rectangle(scene, (vector_t) {3, -2}, 4, 6, 5);
+    body_set_rotation(body, 0.3);
+    assert(close_to(shape_cache_area(cache, body), 24));
+    // A solid rectangle's moment is m (w^2 + h^2) / 12
+    assert(close_to(shape_cache_moment(cache, body), 5 * (16 + 36) / 12.0));
+    scene_free(scene);
+}
+
+void test_local_shape() {
+    scene_t *scene = scene_init();
+    shape_cache_t *cache = create_shape_cache(scene);
+    body_t *body = add_rectangle(scene, (vector_t) {10, 20}, 4, 2, 1);
+    body_set_rotation(body, 1.0);
+    shape_view_t local = shape_cache_local(cache, body);
+    assert(close_to(local.bounds.radius, sqrt(5)));
+    assert(close_to(local.bounds.center.x, 0) && close_to(local.bounds.center.y, 0));
+    for (size_t i = 0; i < local.polygon->size; i++) {
+        assert(close_to(fabs(local.polygon->x[i]), 2) && close_to(fabs(local.polygon->y[i]), 1));
+    }
+    // Looking up the local shape leaves the world shape right
+    check_view(cache, body);
+    scene_free(scene);
+}
+
+void test_removed_bodies() {
+    rng_t rng = rng_init(6);
+    scene_t *scene = scene_init();
+    shape_cache_t *cache = create_shape_cache(scene);
+    for (size_t round = 0; round < 20; round++) {
+        while (scene_bodies(scene) < BODY_COUNT) {
+            vector_t center = {rng_range(&rng, -50, 50), rng_range(&rng, -50, 50)};
+            add_rectangle(scene, center, rng_range(&rng, 1, 20), rng_range(&rng, 1, 20), 1);
+        }
+        for (size_t i = 0; i < scene_bodies(scene); i++) {
+            body_t *body = scene_get_body(scene, i);
+            check_view(cache, body);
+            if (rng_double(&rng) < 0.3) {
+                body_remove(body);
+            }
+        }
+        // New bodies may be allocated where removed ones were, and must not get their shapes
+        scene_tick(scene, 0.01);
+    }
+    scene_free(scene);
+}
+
+int main(int argc, char *argv[]) {
+    // Run all tests if there are no command-line arguments
+    bool all_tests = argc == 1;
+    char *testname = all_tests ? NULL : argv[1];
+
+    DO_TEST(test_follows_moving_bodies)
+    DO_TEST(test_area_and_moment)
+    DO_TEST(test_local_shape)
+    DO_TEST(test_removed_bodies)
+
+    puts("shape_cache_test PASS");
+}
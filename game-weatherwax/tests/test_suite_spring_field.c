@@ -0,0 +1,108 @@
+#include <assert.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include "forces.h"
+#include "rng.h"
+#include "scene.h"
+#include "shape.h"
+#include "spring_field.h"
+#include "test_suite.h"
+
+static const size_t ANCHOR_COUNT = 300;
+static const double ANCHOR_K = 40.0;
+static const double CHAIN_K = 3.0;
+static const double GAMMA = 0.5;
+static const size_t TICKS = 100;
+static const double DT = 0.001;
+
+/**
+ * Makes a scene of weights, each hung on a fixed anchor and chained to the last weight.
+ * threads == 0 uses create_spring and create_drag instead of a field.
+ */
+scene_t *make_scene(size_t threads) {
+    rng_t rng = rng_init(5);
+    scene_t *scene = scene_init();
+    spring_field_t *field = NULL;
+    if (threads > 0) {
+        field = create_spring_field(scene);
+        spring_field_set_threads(field, threads);
+    }
+    body_t *last = NULL;
+    for (size_t i = 0; i < ANCHOR_COUNT; i++) {
+        body_t *anchor = body_init(make_shape_circle(1, (vector_t) {i * 3.0, 250}, 8), INFINITY, (rgb_color_t) {0, 0, 0});
+        body_t *weight = body_init(make_shape_circle(5, (vector_t) {i * 3.0, rng_range(&rng, 0, 500)}, 8), 0.5, (rgb_color_t) {0, 0, 0});
+        scene_add_body(scene, anchor);
+        scene_add_body(scene, weight);
+        body_t *chained = last != NULL ? last : anchor;
+        if (field != NULL) {
+            spring_field_add_spring(field, ANCHOR_K, weight, anchor);
+            spring_field_add_drag(field, GAMMA, weight);
+            spring_field_add_spring(field, CHAIN_K, weight, chained);
+        }
+        else {
+            create_spring(scene, ANCHOR_K, weight, anchor);
+            create_drag(scene, GAMMA, weight);
+            create_spring(scene, CHAIN_K, weight, chained);
+        }
+        last = weight;
+    }
+    return scene;
+}
+
+void run(scene_t *scene) {
+    for (size_t tick = 0; tick < TICKS; tick++) {
+        // Removing bodies takes their springs and drag with them
+        if (tick == 30) {
+            body_remove(scene_get_body(scene, 11));
+        }
+        if (tick == 60) {
+            body_remove(scene_get_body(scene, 300));
+        }
+        scene_tick(scene, DT);
+    }
+}
+
+void check_same(scene_t *expected, scene_t *actual, double tolerance) {
+    assert(scene_bodies(actual) == scene_bodies(expected));
+    for (size_t i = 0; i < scene_bodies(expected); i++) {
+        vector_t p = body_get_centroid(scene_get_body(expected, i));
+        vector_t q = body_get_centroid(scene_get_body(actual, i));
+        assert(fabs(p.x - q.x) <= tolerance && fabs(p.y - q.y) <= tolerance);
+    }
+}
+
+void test_matches_forces() {
+    scene_t *forces = make_scene(0);
+    scene_t *field = make_scene(1);
+    run(forces);
+    run(field);
+    assert(scene_bodies(field) == 2 * ANCHOR_COUNT - 2);
+    check_same(forces, field, 1e-9);
+    scene_free(forces);
+    scene_free(field);
+}
+
+void test_threads_identical() {
+    scene_t *serial = make_scene(1);
+    run(serial);
+    for (size_t threads = 2; threads <= 8; threads += 3) {
+        scene_t *parallel = make_scene(threads);
+        run(parallel);
+        check_same(serial, parallel, 0);
+        scene_free(parallel);
+    }
+    scene_free(serial);
+}
+
+int main(int argc, char *argv[]) {
+    // Run all tests if there are no command-line arguments
+    bool all_tests = argc == 1;
+    char *testname = all_tests ? NULL : argv[1];
+
+    DO_TEST(test_matches_forces)
+    DO_TEST(test_threads_identical)
+
+    puts("spring_field_test PASS");
+}
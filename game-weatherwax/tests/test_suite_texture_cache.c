@@ -0,0 +1,79 @@
+#include <assert.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <SDL2/SDL.h>
+#include "list.h"
+#include "sdl_wrapper.h"
+#include "skin.h"
+#include "test_suite.h"
+#include "texture_cache.h"
+
+static const image_t PLATFORM_IMAGE = {"media/platform.jpg", 80, 10};
+static const image_t WIDE_PLATFORM_IMAGE = {"media/platform.jpg", 160, 10};
+static const image_t BIRD_IMAGE = {"media/bird.png", 60, 60};
+static const image_t BLANK_IMAGE = {NULL, 20, 20};
+
+void test_shared_costumes() {
+    texture_cache_t *cache = texture_cache_init();
+    costume_t *platform = texture_cache_get(cache, PLATFORM_IMAGE);
+    assert(costume_get_texture(platform) != NULL);
+    assert(costume_get_width(platform) == 80 && costume_get_height(platform) == 10);
+    // The same image gets the same costume
+    assert(texture_cache_get(cache, PLATFORM_IMAGE) == platform);
+
+    // The same file at another size shares the texture, not the costume
+    costume_t *wide = texture_cache_get(cache, WIDE_PLATFORM_IMAGE);
+    assert(wide != platform);
+    assert(costume_get_texture(wide) == costume_get_texture(platform));
+    assert(costume_get_width(wide) == 160);
+
+    costume_t *bird = texture_cache_get(cache, BIRD_IMAGE);
+    assert(costume_get_texture(bird) != costume_get_texture(platform));
+
+    costume_t *blank = texture_cache_get(cache, BLANK_IMAGE);
+    assert(costume_get_texture(blank) == NULL);
+    assert(texture_cache_get(cache, BLANK_IMAGE) == blank);
+    texture_cache_free(cache);
+}
+
+void test_preload_and_lists() {
+    texture_cache_t *cache = texture_cache_init();
+    image_t images[] = {PLATFORM_IMAGE, BIRD_IMAGE, PLATFORM_IMAGE, BLANK_IMAGE};
+    size_t image_count = sizeof(images) / sizeof(images[0]);
+    texture_cache_preload(cache, images, image_count);
+
+    list_t *image_list = list_init(image_count, NULL);
+    for (size_t i = 0; i < image_count; i++) {
+        list_add(image_list, &images[i]);
+    }
+    // Building many skins reuses the preloaded costumes
+    for (size_t round = 0; round < 100; round++) {
+        list_t *costumes = texture_cache_costumes(cache, image_list);
+        assert(list_size(costumes) == image_count);
+        for (size_t i = 0; i < image_count; i++) {
+            assert(list_get(costumes, i) == texture_cache_get(cache, images[i]));
+        }
+        // The skin does not own the costumes, so freeing it leaves them cached
+        skin_free(skin_init(costumes, true));
+    }
+    assert(costume_get_texture(texture_cache_get(cache, PLATFORM_IMAGE)) != NULL);
+    list_free(image_list);
+    texture_cache_free(cache);
+}
+
+int main(int argc, char *argv[]) {
+    // Run all tests if there are no command-line arguments
+    bool all_tests = argc == 1;
+    char *testname = all_tests ? NULL : argv[1];
+
+    // Textures need a renderer, but not a window on screen
+    SDL_setenv("SDL_VIDEODRIVER", "dummy", 1);
+    sdl_init(VEC_ZERO, (vector_t) {100, 100});
+
+    DO_TEST(test_shared_costumes)
+    DO_TEST(test_preload_and_lists)
+
+    puts("texture_cache_test PASS");
+}
@@ -0,0 +1,75 @@
+#include <assert.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "test_suite.h"
+#include "thread_pool.h"
+
+static const size_t THREAD_COUNTS[] = {1, 2, 4, 7};
+static const size_t TASK_COUNTS[] = {0, 1, 3, 1000};
+
+/** What the tasks of one thread_pool_for call saw */
+typedef struct visit_log {
+    size_t threads;
+    size_t *visits;
+    size_t *order;
+    size_t next;
+} visit_log_t;
+
+void visit(void *aux, size_t index, size_t thread) {
+    visit_log_t *log = aux;
+    assert(thread < log->threads);
+    // Each index is run once, so only one task writes each slot
+    log->visits[index]++;
+    if (log->threads == 1) {
+        log->order[log->next++] = index;
+    }
+}
+
+void test_every_index_once() {
+    for (size_t i = 0; i < sizeof(THREAD_COUNTS) / sizeof(THREAD_COUNTS[0]); i++) {
+        size_t threads = THREAD_COUNTS[i];
+        thread_pool_t *pool = thread_pool_init(threads);
+        assert(thread_pool_threads(pool) == threads);
+        // The same pool is reused for calls of every size
+        for (size_t round = 0; round < 3; round++) {
+            for (size_t j = 0; j < sizeof(TASK_COUNTS) / sizeof(TASK_COUNTS[0]); j++) {
+                size_t count = TASK_COUNTS[j];
+                visit_log_t log = {threads, calloc(count + 1, sizeof(size_t)), calloc(count + 1, sizeof(size_t)), 0};
+                thread_pool_for(pool, count, visit, &log);
+                for (size_t index = 0; index < count; index++) {
+                    assert(log.visits[index] == 1);
+                }
+                free(log.visits);
+                free(log.order);
+            }
+        }
+        thread_pool_free(pool);
+    }
+}
+
+void test_one_thread_in_order() {
+    thread_pool_t *pool = thread_pool_init(1);
+    size_t count = 100;
+    visit_log_t log = {1, calloc(count, sizeof(size_t)), calloc(count, sizeof(size_t)), 0};
+    thread_pool_for(pool, count, visit, &log);
+    assert(log.next == count);
+    for (size_t index = 0; index < count; index++) {
+        assert(log.order[index] == index);
+    }
+    free(log.visits);
+    free(log.order);
+    thread_pool_free(pool);
+}
+
+int main(int argc, char *argv[]) {
+    // Run all tests if there are no command-line arguments
+    bool all_tests = argc == 1;
+    char *testname = all_tests ? NULL : argv[1];
+
+    DO_TEST(test_every_index_once)
+    DO_TEST(test_one_thread_in_order)
+
+    puts("thread_pool_test PASS");
+}
@@ -0,0 +1,104 @@
+#include <assert.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include "rng.h"
+#include "scene.h"
+#include "shape.h"
+#include "test_suite.h"
+#include "type_index.h"
+
+// Tests use the first few body types
+static const size_t TYPE_COUNT = 6;
+
+body_t *add_body(scene_t *scene, body_type_t type) {
+    list_t *shape = make_shape_circle(1, VEC_ZERO, 4);
+    body_t *body = body_init_with_info(shape, 1, (rgb_color_t) {0, 0, 0}, type);
+    scene_add_body(scene, body);
+    return body;
+}
+
+/** Checks every bucket against a scan of the scene */
+void check_buckets(scene_t *scene, type_index_t *index) {
+    for (size_t type = 0; type < TYPE_COUNT; type++) {
+        size_t expected = 0;
+        for (size_t i = 0; i < scene_bodies(scene); i++) {
+            if (body_get_type(scene_get_body(scene, i)) == (body_type_t) type) {
+                expected++;
+            }
+        }
+        size_t count = type_index_bodies(index, type);
+        assert(count == expected);
+        for (size_t i = 0; i < count; i++) {
+            assert(body_get_type(type_index_get_body(index, type, i)) == (body_type_t) type);
+        }
+    }
+}
+
+void test_existing_and_new_bodies() {
+    scene_t *scene = scene_init();
+    body_t *first = add_body(scene, 1);
+    add_body(scene, 2);
+    type_index_t *index = create_type_index(scene);
+    assert(type_index_bodies(index, 1) == 1);
+    assert(type_index_get_body(index, 1, 0) == first);
+    assert(type_index_bodies(index, 3) == 0);
+
+    add_body(scene, 2);
+    assert(type_index_bodies(index, 2) == 2);
+    scene_free(scene);
+}
+
+void test_set_type() {
+    scene_t *scene = scene_init();
+    type_index_t *index = create_type_index(scene);
+    body_t *body = add_body(scene, 1);
+    assert(type_index_bodies(index, 1) == 1);
+    type_index_set_type(index, body, 4);
+    assert(body_get_type(body) == 4);
+    assert(type_index_bodies(index, 1) == 0);
+    assert(type_index_bodies(index, 4) == 1);
+    assert(type_index_get_body(index, 4, 0) == body);
+
+    // A type changed behind the index's back is caught when the old bucket is queried
+    body_set_type(body, 5);
+    assert(type_index_bodies(index, 4) == 0);
+    assert(type_index_bodies(index, 5) == 1);
+    scene_free(scene);
+}
+
+void test_random_changes() {
+    rng_t rng = rng_init(2);
+    scene_t *scene = scene_init();
+    type_index_t *index = create_type_index(scene);
+    for (size_t round = 0; round < 200; round++) {
+        for (size_t i = 0; i < 10; i++) {
+            add_body(scene, rng_next(&rng) % TYPE_COUNT);
+        }
+        for (size_t i = 0; i < scene_bodies(scene); i++) {
+            body_t *body = scene_get_body(scene, i);
+            uint64_t choice = rng_next(&rng) % 20;
+            if (choice == 0) {
+                body_remove(body);
+            }
+            else if (choice == 1) {
+                type_index_set_type(index, body, rng_next(&rng) % TYPE_COUNT);
+            }
+        }
+        scene_tick(scene, 0.01);
+        check_buckets(scene, index);
+    }
+    scene_free(scene);
+}
+
+int main(int argc, char *argv[]) {
+    // Run all tests if there are no command-line arguments
+    bool all_tests = argc == 1;
+    char *testname = all_tests ? NULL : argv[1];
+
+    DO_TEST(test_existing_and_new_bodies)
+    DO_TEST(test_set_type)
+    DO_TEST(test_random_changes)
+
+    puts("type_index_test PASS");
+}